@@ -14,6 +14,8 @@
 
 #include "ModSkeleton.h"
 #include "BPVariant.h"
+#include "BPVariantPool.h"
+#include "ModSkeletonProfiler.h"
 
 EBPVariantType UBPVariant::GetType() const
 {
@@ -22,16 +24,159 @@ EBPVariantType UBPVariant::GetType() const
 
 void UBPVariant::SetType(EBPVariantType NewType)
 {
-	if (Type == EBPVariantType::VT_String)
-	{
-		delete StoreUnion.StoreString;
-	}
 	Type = NewType;
-	AsArray.Empty();
+	AsArray.Reset();
+	MapKeys.Reset();
+	MapIndex.Reset();
+	MapValues.Reset();
+	Packed.Reset();
 	StoreObject = nullptr;
+	StoreString.Reset();
 	FMemory::Memset(&StoreUnion, 0, sizeof(PrivStoreUnion));
-	if (Type == EBPVariantType::VT_String) {
-		StoreUnion.StoreString = new FString();
+}
+
+/**
+ * Shared by the UBPVariant and FBPVariant hashes, so both representations of a value hash the same
+ */
+static uint32 HashVariantScalar(EBPVariantType Type, bool BoolValue, int32 IntValue, float FloatValue, const FString& StringValue, const UObject* ObjectValue)
+{
+	const uint32 TypeHash = GetTypeHash(static_cast<uint8>(Type));
+	switch (Type)
+	{
+	case EBPVariantType::VT_Boolean:
+		return HashCombine(TypeHash, BoolValue ? 1 : 0);
+	case EBPVariantType::VT_Integer:
+		return HashCombine(TypeHash, GetTypeHash(IntValue));
+	case EBPVariantType::VT_Float:
+		// -0 == +0, so they have to hash the same
+		return HashCombine(TypeHash, FloatValue == 0.0f ? 0 : GetTypeHash(FloatValue));
+	case EBPVariantType::VT_String:
+		return HashCombine(TypeHash, GetTypeHash(StringValue));
+	case EBPVariantType::VT_Class:
+	case EBPVariantType::VT_Object:
+		return HashCombine(TypeHash, PointerHash(ObjectValue));
+	default:
+		return TypeHash;
+	}
+}
+
+UBPVariant* UBPVariant::NewBPVariant(UObject* Outer)
+{
+	MODSKELETON_COUNT_VARIANT_ALLOCATION();
+
+	if (UBPVariantPool* Pool = UBPVariantPool::GetScopedPool())
+	{
+		return Pool->Acquire(Outer);
+	}
+	return NewObject<UBPVariant>(Outer, UBPVariant::StaticClass());
+}
+
+int32 UBPVariant::GetStructuralHash() const
+{
+	return static_cast<int32>(HashOf(this));
+}
+
+bool UBPVariant::StructurallyEquals(const UBPVariant* Other) const
+{
+	return Equal(this, Other);
+}
+
+/**
+ * Maps are unordered, so EntrySum adds up the hash of each key / value pair
+ */
+static uint32 HashVariantMap(int32 Num, uint32 EntrySum)
+{
+	return HashCombine(HashCombine(GetTypeHash(static_cast<uint8>(EBPVariantType::VT_Map)), GetTypeHash(Num)), EntrySum);
+}
+
+uint32 UBPVariant::HashOf(const UBPVariant* Variant)
+{
+	if (Variant == nullptr)
+	{
+		return HashVariantScalar(EBPVariantType::VT_None, false, 0, 0.0f, FString(), nullptr);
+	}
+	if (Variant->Type == EBPVariantType::VT_Array)
+	{
+		return HashCombine(GetTypeHash(static_cast<uint8>(EBPVariantType::VT_Array)), FBPVariant::HashArray(Variant->AsArray));
+	}
+	if (Variant->Type == EBPVariantType::VT_Map)
+	{
+		uint32 EntrySum = 0;
+		for (int32 i = 0; i < Variant->MapKeys.Num(); ++i)
+		{
+			EntrySum += HashCombine(GetTypeHash(Variant->MapKeys[i]), HashOf(Variant->MapValues[i]));
+		}
+		return HashVariantMap(Variant->MapKeys.Num(), EntrySum);
+	}
+	if (FBPVariantPackedArray::IsPackedType(Variant->Type))
+	{
+		return Variant->Packed.GetHash(Variant->Type);
+	}
+	return HashVariantScalar(Variant->Type, Variant->GetAsBoolean(), Variant->GetAsInteger(), Variant->GetAsFloat(), Variant->StoreString, Variant->Type == EBPVariantType::VT_Class ? Variant->GetAsClass() : Variant->GetAsObject());
+}
+
+bool UBPVariant::Equal(const UBPVariant* A, const UBPVariant* B)
+{
+	if (A == B)
+	{
+		return true;
+	}
+	const EBPVariantType TypeA = A != nullptr ? A->Type : EBPVariantType::VT_None;
+	const EBPVariantType TypeB = B != nullptr ? B->Type : EBPVariantType::VT_None;
+	if (TypeA != TypeB)
+	{
+		return false;
+	}
+
+	switch (TypeA)
+	{
+	case EBPVariantType::VT_Boolean:
+		return A->GetAsBoolean() == B->GetAsBoolean();
+	case EBPVariantType::VT_Integer:
+		return A->GetAsInteger() == B->GetAsInteger();
+	case EBPVariantType::VT_Float:
+		return A->GetAsFloat() == B->GetAsFloat();
+	case EBPVariantType::VT_String:
+		return A->GetAsString().Equals(B->GetAsString(), ESearchCase::CaseSensitive);
+	case EBPVariantType::VT_Class:
+		return A->GetAsClass() == B->GetAsClass();
+	case EBPVariantType::VT_Object:
+		return A->GetAsObject() == B->GetAsObject();
+	case EBPVariantType::VT_Array:
+		if (A->AsArray.Num() != B->AsArray.Num())
+		{
+			return false;
+		}
+		for (int32 i = 0; i < A->AsArray.Num(); ++i)
+		{
+			if (!Equal(A->AsArray[i], B->AsArray[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	case EBPVariantType::VT_Map:
+		if (A->MapKeys.Num() != B->MapKeys.Num())
+		{
+			return false;
+		}
+		for (int32 i = 0; i < A->MapKeys.Num(); ++i)
+		{
+			const int32 Index = B->FindMapIndex(A->MapKeys[i]);
+			if (Index == INDEX_NONE || !Equal(A->MapValues[i], B->MapValues[Index]))
+			{
+				return false;
+			}
+		}
+		return true;
+	case EBPVariantType::VT_IntArray:
+	case EBPVariantType::VT_FloatArray:
+	case EBPVariantType::VT_BoolArray:
+	case EBPVariantType::VT_VectorArray:
+		return A->Packed.Identical(TypeA, B->Packed);
+	default:
+	case EBPVariantType::VT_None:
+		return true;
 	}
 }
 
@@ -70,6 +215,25 @@ FString UBPVariant::GetDebugValue() const
 		Out.Append("\n]");
 		return Out;
 	}
+	case EBPVariantType::VT_Map:
+	{
+		FString Out("Map{");
+		for (int32 i = 0; i < MapKeys.Num(); ++i)
+		{
+			if (i > 0) Out.Append(",");
+			Out.Append("\n  ");
+			Out.Append(MapKeys[i].GetDebugValue());
+			Out.Append(": ");
+			Out.Append(MapValues[i] != nullptr ? MapValues[i]->GetDebugValue() : FString("None"));
+		}
+		Out.Append("\n}");
+		return Out;
+	}
+	case EBPVariantType::VT_IntArray:
+	case EBPVariantType::VT_FloatArray:
+	case EBPVariantType::VT_BoolArray:
+	case EBPVariantType::VT_VectorArray:
+		return Packed.GetDebugValue(Type);
 	default:
 	case EBPVariantType::VT_None:
 		return TEXT("None");
@@ -78,7 +242,7 @@ FString UBPVariant::GetDebugValue() const
 
 UBPVariant* UBPVariant::NewBPVariantAsBoolean(UObject* Outer, bool Value)
 {
-	UBPVariant* Out = NewObject<UBPVariant>(Outer, UBPVariant::StaticClass());
+	UBPVariant* Out = NewBPVariant(Outer);
 	Out->SetAsBoolean(Value);
 	return Out;
 }
@@ -104,7 +268,7 @@ bool UBPVariant::SetAsBoolean(bool Value)
 
 UBPVariant* UBPVariant::NewBPVariantAsInteger(UObject* Outer, int32 Value)
 {
-	UBPVariant* Out = NewObject<UBPVariant>(Outer, UBPVariant::StaticClass());
+	UBPVariant* Out = NewBPVariant(Outer);
 	Out->SetAsInteger(Value);
 	return Out;
 }
@@ -131,7 +295,7 @@ int32 UBPVariant::SetAsInteger(int32 Value)
 
 UBPVariant* UBPVariant::NewBPVariantAsFloat(UObject* Outer, float Value)
 {
-	UBPVariant* Out = NewObject<UBPVariant>(Outer, UBPVariant::StaticClass());
+	UBPVariant* Out = NewBPVariant(Outer);
 	Out->SetAsFloat(Value);
 	return Out;
 }
@@ -157,7 +321,7 @@ float UBPVariant::SetAsFloat(float Value)
 
 UBPVariant* UBPVariant::NewBPVariantAsString(UObject* Outer, const FString& Value)
 {
-	UBPVariant* Out = NewObject<UBPVariant>(Outer, UBPVariant::StaticClass());
+	UBPVariant* Out = NewBPVariant(Outer);
 	Out->SetAsString(Value);
 	return Out;
 }
@@ -166,25 +330,25 @@ const FString& UBPVariant::GetAsString() const
 {
 	if (Type == EBPVariantType::VT_String)
 	{
-		return *StoreUnion.StoreString;
+		return StoreString;
 	}
 	else
 	{
-		// TODO - BAD
-		return *((FString*)nullptr);
+		static const FString Empty;
+		return Empty;
 	}
 }
 
 const FString& UBPVariant::SetAsString(const FString& Value)
 {
 	SetType(EBPVariantType::VT_String);
-	*StoreUnion.StoreString = Value;
+	StoreString = Value;
 	return Value;
 }
 
 UBPVariant* UBPVariant::NewBPVariantAsClass(UObject* Outer, UClass* Value)
 {
-	UBPVariant* Out = NewObject<UBPVariant>(Outer, UBPVariant::StaticClass());
+	UBPVariant* Out = NewBPVariant(Outer);
 	Out->SetAsClass(Value);
 	return Out;
 }
@@ -210,7 +374,7 @@ UClass* UBPVariant::SetAsClass(UClass* Value)
 
 UBPVariant* UBPVariant::NewBPVariantAsObject(UObject* Outer, UObject* Value)
 {
-	UBPVariant* Out = NewObject<UBPVariant>(Outer, UBPVariant::StaticClass());
+	UBPVariant* Out = NewBPVariant(Outer);
 	Out->SetAsObject(Value);
 	return Out;
 }
@@ -236,7 +400,7 @@ UObject* UBPVariant::SetAsObject(UObject* Value)
 
 UBPVariant* UBPVariant::NewBPVariantAsArray(UObject* Outer)
 {
-	UBPVariant* Out = NewObject<UBPVariant>(Outer, UBPVariant::StaticClass());
+	UBPVariant* Out = NewBPVariant(Outer);
 	Out->SetAsArray();
 	return Out;
 }
@@ -244,4 +408,1296 @@ UBPVariant* UBPVariant::NewBPVariantAsArray(UObject* Outer)
 void UBPVariant::SetAsArray()
 {
 	SetType(EBPVariantType::VT_Array);
-}
\ No newline at end of file
+}
+
+UBPVariant* UBPVariant::NewBPVariantAsMap(UObject* Outer)
+{
+	UBPVariant* Out = NewBPVariant(Outer);
+	Out->SetAsMap();
+	return Out;
+}
+
+void UBPVariant::SetAsMap()
+{
+	SetType(EBPVariantType::VT_Map);
+}
+
+int32 UBPVariant::GetMapNum() const
+{
+	return MapKeys.Num();
+}
+
+int32 UBPVariant::FindMapIndex(const FBPVariant& Key) const
+{
+	for (auto It = MapIndex.CreateConstKeyIterator(GetTypeHash(Key)); It; ++It)
+	{
+		if (MapKeys[It.Value()] == Key)
+		{
+			return It.Value();
+		}
+	}
+	return INDEX_NONE;
+}
+
+UBPVariant* UBPVariant::FindMapValue(const FBPVariant& Key) const
+{
+	const int32 Index = FindMapIndex(Key);
+	return Index != INDEX_NONE ? MapValues[Index] : nullptr;
+}
+
+bool UBPVariant::SetMapValue(const FBPVariant& Key, UBPVariant* Value)
+{
+	if (Type != EBPVariantType::VT_Map || !FBPVariant::IsValidMapKey(Key))
+	{
+		return false;
+	}
+
+	const int32 Index = FindMapIndex(Key);
+	if (Index != INDEX_NONE)
+	{
+		MapValues[Index] = Value;
+		return true;
+	}
+
+	MapIndex.Add(GetTypeHash(Key), MapKeys.Add(Key));
+	MapValues.Add(Value);
+	return true;
+}
+
+bool UBPVariant::RemoveMapValue(const FBPVariant& Key)
+{
+	const int32 Index = FindMapIndex(Key);
+	if (Index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Swap the last entry into the hole, so only its position needs re-indexing
+	const int32 Last = MapKeys.Num() - 1;
+	MapIndex.RemoveSingle(GetTypeHash(Key), Index);
+	if (Index != Last)
+	{
+		const uint32 LastHash = GetTypeHash(MapKeys[Last]);
+		MapIndex.RemoveSingle(LastHash, Last);
+		MapIndex.Add(LastHash, Index);
+	}
+	MapKeys.RemoveAtSwap(Index, 1, false);
+	MapValues.RemoveAtSwap(Index, 1, false);
+	return true;
+}
+
+const TArray< FBPVariant >& UBPVariant::GetMapKeys() const
+{
+	// MapKeys is always empty unless this is a VT_Map
+	return MapKeys;
+}
+
+const TArray< UBPVariant* >& UBPVariant::GetMapValues() const
+{
+	return MapValues;
+}
+
+UBPVariant* UBPVariant::NewBPVariantAsIntArray(UObject* Outer, const TArray<int32>& Values)
+{
+	UBPVariant* Out = NewBPVariant(Outer);
+	Out->SetAsIntArray(Values);
+	return Out;
+}
+
+UBPVariant* UBPVariant::NewBPVariantAsFloatArray(UObject* Outer, const TArray<float>& Values)
+{
+	UBPVariant* Out = NewBPVariant(Outer);
+	Out->SetAsFloatArray(Values);
+	return Out;
+}
+
+UBPVariant* UBPVariant::NewBPVariantAsBoolArray(UObject* Outer, const TArray<bool>& Values)
+{
+	UBPVariant* Out = NewBPVariant(Outer);
+	Out->SetAsBoolArray(Values);
+	return Out;
+}
+
+UBPVariant* UBPVariant::NewBPVariantAsVectorArray(UObject* Outer, const TArray<FVector>& Values)
+{
+	UBPVariant* Out = NewBPVariant(Outer);
+	Out->SetAsVectorArray(Values);
+	return Out;
+}
+
+void UBPVariant::SetAsIntArray(const TArray<int32>& Values)
+{
+	SetType(EBPVariantType::VT_IntArray);
+	Packed.Ints = Values;
+}
+
+void UBPVariant::SetAsFloatArray(const TArray<float>& Values)
+{
+	SetType(EBPVariantType::VT_FloatArray);
+	Packed.Floats = Values;
+}
+
+void UBPVariant::SetAsBoolArray(const TArray<bool>& Values)
+{
+	SetType(EBPVariantType::VT_BoolArray);
+	Packed.Bools.Init(false, Values.Num());
+	for (int32 i = 0; i < Values.Num(); ++i)
+	{
+		Packed.Bools[i] = Values[i];
+	}
+}
+
+void UBPVariant::SetAsVectorArray(const TArray<FVector>& Values)
+{
+	SetType(EBPVariantType::VT_VectorArray);
+	Packed.Vectors = Values;
+}
+
+const TArray<int32>& UBPVariant::GetAsIntArray() const
+{
+	// the packed arrays are always empty unless this is of their type
+	return Packed.Ints;
+}
+
+const TArray<float>& UBPVariant::GetAsFloatArray() const
+{
+	return Packed.Floats;
+}
+
+TArray<bool> UBPVariant::GetAsBoolArray() const
+{
+	TArray<bool> Out;
+	Out.Reserve(Packed.Bools.Num());
+	for (int32 i = 0; i < Packed.Bools.Num(); ++i)
+	{
+		Out.Add(Packed.Bools[i]);
+	}
+	return Out;
+}
+
+const TArray<FVector>& UBPVariant::GetAsVectorArray() const
+{
+	return Packed.Vectors;
+}
+
+int32 UBPVariant::GetPackedNum() const
+{
+	return Packed.Num(Type);
+}
+
+float UBPVariant::GetPackedSum() const
+{
+	return Packed.Sum(Type);
+}
+
+bool UBPVariant::GetPackedRange(float& Min, float& Max) const
+{
+	return Packed.GetRange(Type, Min, Max);
+}
+
+FVector UBPVariant::GetPackedVectorSum() const
+{
+	return Packed.SumVectors();
+}
+
+bool UBPVariant::GetPackedVectorBounds(FVector& Min, FVector& Max) const
+{
+	return Packed.GetVectorBounds(Min, Max);
+}
+
+bool UBPVariant::ScalePacked(float Factor)
+{
+	return Packed.Scale(Type, Factor);
+}
+
+bool UBPVariant::AddPacked(const UBPVariant* Other, float Factor)
+{
+	return Other != nullptr && Other->Type == Type && Packed.Add(Type, Other->Packed, Factor);
+}
+
+/**
+ * Write access to a node shared between FBPVariant copies, allocating it or copying it away from the other owners first.
+ * Copying a node copies its elements, which only adds references to the nodes below.
+ */
+template <typename NodeType>
+static NodeType& MutableNode(TSharedPtr< NodeType, ESPMode::ThreadSafe >& Node)
+{
+	if (!Node.IsValid())
+	{
+		MODSKELETON_COUNT_VALUE_NODE_ALLOCATION();
+		Node = MakeShareable(new NodeType());
+	}
+	else if (!Node.IsUnique())
+	{
+		// another copy still reads this node, give this one its own
+		MODSKELETON_COUNT_VALUE_NODE_ALLOCATION();
+		Node = MakeShareable(new NodeType(*Node));
+	}
+	return *Node;
+}
+
+/**
+ * Empty a node on a type change if this is its only owner, so its allocation can be refilled, otherwise let go of it
+ */
+template <typename NodeType>
+static void ResetNode(TSharedPtr< NodeType, ESPMode::ThreadSafe >& Node)
+{
+	if (Node.IsValid() && Node.IsUnique())
+	{
+		Node->Reset();
+	}
+	else
+	{
+		Node.Reset();
+	}
+}
+
+FBPVariant::FBPVariant()
+	: Type(EBPVariantType::VT_None)
+	, StoreObject(nullptr)
+{
+	FMemory::Memset(&StoreUnion, 0, sizeof(PrivStoreUnion));
+}
+
+EBPVariantType FBPVariant::GetType() const
+{
+	return Type;
+}
+
+void FBPVariant::SetType(EBPVariantType NewType)
+{
+	Type = NewType;
+	StoreString.Reset();
+	ResetNode(StoreArray);
+	StoreMap.Reset();
+	ResetNode(StorePacked);
+	StoreObject = nullptr;
+	FMemory::Memset(&StoreUnion, 0, sizeof(PrivStoreUnion));
+}
+
+FString FBPVariant::GetDebugValue() const
+{
+	switch (Type)
+	{
+	case EBPVariantType::VT_Boolean:
+		return FString::Printf(TEXT("Boolean(%s)"), GetAsBoolean() ? TEXT("true") : TEXT("false"));
+	case EBPVariantType::VT_Integer:
+		return FString::Printf(TEXT("Integer(%d)"), GetAsInteger());
+	case EBPVariantType::VT_Float:
+		return FString::Printf(TEXT("Float(%f)"), GetAsFloat());
+	case EBPVariantType::VT_String:
+		return FString::Printf(TEXT("String(\"%s\")"), *GetAsString());
+	case EBPVariantType::VT_Class:
+		return FString::Printf(TEXT("Class(%s)"), *GetFullNameSafe(GetAsClass()));
+	case EBPVariantType::VT_Object:
+		return FString::Printf(TEXT("Object(%s)"), *GetFullNameSafe(GetAsObject()));
+	case EBPVariantType::VT_Array:
+	{
+		FString Out("Array[");
+		const TArray< FBPVariant >& Elements = GetAsArray();
+		for (int32 i = 0; i < Elements.Num(); ++i)
+		{
+			if (i > 0) Out.Append(",");
+			Out.Append("\n  ");
+			Out.Append(Elements[i].GetDebugValue());
+		}
+		Out.Append("\n]");
+		return Out;
+	}
+	case EBPVariantType::VT_Map:
+	{
+		FString Out("Map{");
+		bool bFirst = true;
+		for (const auto& Entry : GetAsMap().Entries)
+		{
+			if (!bFirst) Out.Append(",");
+			bFirst = false;
+			Out.Append("\n  ");
+			Out.Append(Entry.Key.GetDebugValue());
+			Out.Append(": ");
+			Out.Append(Entry.Value.GetDebugValue());
+		}
+		Out.Append("\n}");
+		return Out;
+	}
+	case EBPVariantType::VT_IntArray:
+	case EBPVariantType::VT_FloatArray:
+	case EBPVariantType::VT_BoolArray:
+	case EBPVariantType::VT_VectorArray:
+		return GetPacked().GetDebugValue(Type);
+	default:
+	case EBPVariantType::VT_None:
+		return TEXT("None");
+	}
+}
+
+bool FBPVariant::GetAsBoolean() const
+{
+	return Type == EBPVariantType::VT_Boolean ? StoreUnion.StoreBool : false;
+}
+
+bool FBPVariant::SetAsBoolean(bool Value)
+{
+	SetType(EBPVariantType::VT_Boolean);
+	StoreUnion.StoreBool = Value;
+	return Value;
+}
+
+int32 FBPVariant::GetAsInteger() const
+{
+	return Type == EBPVariantType::VT_Integer ? StoreUnion.StoreInt32 : 0;
+}
+
+int32 FBPVariant::SetAsInteger(int32 Value)
+{
+	SetType(EBPVariantType::VT_Integer);
+	StoreUnion.StoreInt32 = Value;
+	return Value;
+}
+
+float FBPVariant::GetAsFloat() const
+{
+	return Type == EBPVariantType::VT_Float ? StoreUnion.StoreFloat : 0.0f;
+}
+
+float FBPVariant::SetAsFloat(float Value)
+{
+	SetType(EBPVariantType::VT_Float);
+	StoreUnion.StoreFloat = Value;
+	return Value;
+}
+
+const FString& FBPVariant::GetAsString() const
+{
+	// StoreString is always empty unless this is a VT_String
+	return StoreString;
+}
+
+const FString& FBPVariant::SetAsString(const FString& Value)
+{
+	SetType(EBPVariantType::VT_String);
+	StoreString = Value;
+	return StoreString;
+}
+
+UClass* FBPVariant::GetAsClass() const
+{
+	return Type == EBPVariantType::VT_Class ? static_cast<UClass*>(StoreObject) : nullptr;
+}
+
+UClass* FBPVariant::SetAsClass(UClass* Value)
+{
+	SetType(EBPVariantType::VT_Class);
+	StoreObject = Value;
+	return Value;
+}
+
+UObject* FBPVariant::GetAsObject() const
+{
+	return Type == EBPVariantType::VT_Object ? StoreObject : nullptr;
+}
+
+UObject* FBPVariant::SetAsObject(UObject* Value)
+{
+	SetType(EBPVariantType::VT_Object);
+	StoreObject = Value;
+	return Value;
+}
+
+const TArray< FBPVariant >& FBPVariant::GetAsArray() const
+{
+	// StoreArray is always empty unless this is a VT_Array
+	static const TArray< FBPVariant > Empty;
+	return StoreArray.IsValid() ? *StoreArray : Empty;
+}
+
+TArray< FBPVariant >& FBPVariant::SetAsArray()
+{
+	SetType(EBPVariantType::VT_Array);
+	return MutableArray();
+}
+
+TArray< FBPVariant >& FBPVariant::GetMutableArray()
+{
+	check(Type == EBPVariantType::VT_Array);
+	return MutableArray();
+}
+
+TArray< FBPVariant >& FBPVariant::MutableArray()
+{
+	return MutableNode(StoreArray);
+}
+
+bool FBPVariant::SharesStorageWith(const FBPVariant& Other) const
+{
+	return Type == Other.Type && (
+		(StoreArray.IsValid() && StoreArray == Other.StoreArray) ||
+		(StoreMap.IsValid() && StoreMap == Other.StoreMap) ||
+		(StorePacked.IsValid() && StorePacked == Other.StorePacked));
+}
+
+void FBPVariant::SetAsMap()
+{
+	SetType(EBPVariantType::VT_Map);
+}
+
+const FBPVariantMap& FBPVariant::GetAsMap() const
+{
+	static const FBPVariantMap Empty;
+	return StoreMap.IsValid() ? *StoreMap : Empty;
+}
+
+int32 FBPVariant::GetMapNum() const
+{
+	return StoreMap.IsValid() ? StoreMap->Entries.Num() : 0;
+}
+
+const FBPVariant* FBPVariant::FindMapValue(const FBPVariant& Key) const
+{
+	return StoreMap.IsValid() ? StoreMap->Entries.Find(Key) : nullptr;
+}
+
+FBPVariant& FBPVariant::FindOrAddMapValue(const FBPVariant& Key)
+{
+	check(Type == EBPVariantType::VT_Map && IsValidMapKey(Key));
+	return MutableMap().Entries.FindOrAdd(Key);
+}
+
+FBPVariant* FBPVariant::FindMutableMapValue(const FBPVariant& Key)
+{
+	// don't unshare the map just to find out the key is missing
+	if (FindMapValue(Key) == nullptr)
+	{
+		return nullptr;
+	}
+	return MutableMap().Entries.Find(Key);
+}
+
+bool FBPVariant::RemoveMapValue(const FBPVariant& Key)
+{
+	if (FindMapValue(Key) == nullptr)
+	{
+		return false;
+	}
+	MutableMap().Entries.Remove(Key);
+	return true;
+}
+
+bool FBPVariant::IsValidMapKey(const FBPVariant& Key)
+{
+	return Key.Type == EBPVariantType::VT_String || Key.Type == EBPVariantType::VT_Integer;
+}
+
+FBPVariantMap& FBPVariant::MutableMap()
+{
+	return MutableNode(StoreMap);
+}
+
+TArray<int32>& FBPVariant::SetAsIntArray()
+{
+	SetType(EBPVariantType::VT_IntArray);
+	return MutablePacked().Ints;
+}
+
+TArray<float>& FBPVariant::SetAsFloatArray()
+{
+	SetType(EBPVariantType::VT_FloatArray);
+	return MutablePacked().Floats;
+}
+
+TBitArray<>& FBPVariant::SetAsBoolArray()
+{
+	SetType(EBPVariantType::VT_BoolArray);
+	return MutablePacked().Bools;
+}
+
+TArray<FVector>& FBPVariant::SetAsVectorArray()
+{
+	SetType(EBPVariantType::VT_VectorArray);
+	return MutablePacked().Vectors;
+}
+
+const TArray<int32>& FBPVariant::GetAsIntArray() const
+{
+	return GetPacked().Ints;
+}
+
+const TArray<float>& FBPVariant::GetAsFloatArray() const
+{
+	return GetPacked().Floats;
+}
+
+const TBitArray<>& FBPVariant::GetAsBoolArray() const
+{
+	return GetPacked().Bools;
+}
+
+const TArray<FVector>& FBPVariant::GetAsVectorArray() const
+{
+	return GetPacked().Vectors;
+}
+
+const FBPVariantPackedArray& FBPVariant::GetPacked() const
+{
+	static const FBPVariantPackedArray Empty;
+	return StorePacked.IsValid() ? *StorePacked : Empty;
+}
+
+int32 FBPVariant::GetPackedNum() const
+{
+	return GetPacked().Num(Type);
+}
+
+float FBPVariant::GetPackedSum() const
+{
+	return GetPacked().Sum(Type);
+}
+
+bool FBPVariant::GetPackedRange(float& OutMin, float& OutMax) const
+{
+	return GetPacked().GetRange(Type, OutMin, OutMax);
+}
+
+FVector FBPVariant::GetPackedVectorSum() const
+{
+	return GetPacked().SumVectors();
+}
+
+bool FBPVariant::GetPackedVectorBounds(FVector& OutMin, FVector& OutMax) const
+{
+	return GetPacked().GetVectorBounds(OutMin, OutMax);
+}
+
+bool FBPVariant::ScalePacked(float Factor)
+{
+	if (GetPackedNum() == 0)
+	{
+		// nothing to do, and no reason to unshare
+		return Type == EBPVariantType::VT_IntArray || Type == EBPVariantType::VT_FloatArray || Type == EBPVariantType::VT_VectorArray;
+	}
+	return MutablePacked().Scale(Type, Factor);
+}
+
+bool FBPVariant::AddPacked(const FBPVariant& Other, float Factor)
+{
+	if (Other.Type != Type || Other.GetPackedNum() != GetPackedNum())
+	{
+		return false;
+	}
+	// hold on to Other's elements in case it shares them with this, MutablePacked would then copy them out from under it
+	const TSharedPtr< FBPVariantPackedArray, ESPMode::ThreadSafe > OtherPacked = Other.StorePacked;
+	return MutablePacked().Add(Type, OtherPacked.IsValid() ? *OtherPacked : Other.GetPacked(), Factor);
+}
+
+FBPVariantPackedArray& FBPVariant::MutablePacked()
+{
+	return MutableNode(StorePacked);
+}
+
+uint32 FBPVariant::HashMap(const FBPVariantMap& Map)
+{
+	uint32 EntrySum = 0;
+	for (const auto& Entry : Map.Entries)
+	{
+		EntrySum += HashCombine(GetTypeHash(Entry.Key), GetTypeHash(Entry.Value));
+	}
+	return HashVariantMap(Map.Entries.Num(), EntrySum);
+}
+
+const TCHAR* FBPVariant::GetTypeName(EBPVariantType Type)
+{
+	switch (Type)
+	{
+	case EBPVariantType::VT_Boolean:
+		return TEXT("Boolean");
+	case EBPVariantType::VT_Integer:
+		return TEXT("Integer");
+	case EBPVariantType::VT_Float:
+		return TEXT("Float");
+	case EBPVariantType::VT_String:
+		return TEXT("String");
+	case EBPVariantType::VT_Class:
+		return TEXT("Class");
+	case EBPVariantType::VT_Object:
+		return TEXT("Object");
+	case EBPVariantType::VT_Array:
+		return TEXT("Array");
+	case EBPVariantType::VT_Map:
+		return TEXT("Map");
+	case EBPVariantType::VT_IntArray:
+		return TEXT("IntegerArray");
+	case EBPVariantType::VT_FloatArray:
+		return TEXT("FloatArray");
+	case EBPVariantType::VT_BoolArray:
+		return TEXT("BooleanArray");
+	case EBPVariantType::VT_VectorArray:
+		return TEXT("VectorArray");
+	default:
+	case EBPVariantType::VT_None:
+		return TEXT("None");
+	}
+}
+
+FBPVariant FBPVariant::FromObject(const UBPVariant* Variant)
+{
+	FBPVariant Out;
+	if (Variant == nullptr)
+	{
+		return Out;
+	}
+
+	switch (Variant->GetType())
+	{
+	case EBPVariantType::VT_Boolean:
+		Out.SetAsBoolean(Variant->GetAsBoolean());
+		break;
+	case EBPVariantType::VT_Integer:
+		Out.SetAsInteger(Variant->GetAsInteger());
+		break;
+	case EBPVariantType::VT_Float:
+		Out.SetAsFloat(Variant->GetAsFloat());
+		break;
+	case EBPVariantType::VT_String:
+		Out.SetAsString(Variant->GetAsString());
+		break;
+	case EBPVariantType::VT_Class:
+		Out.SetAsClass(Variant->GetAsClass());
+		break;
+	case EBPVariantType::VT_Object:
+		Out.SetAsObject(Variant->GetAsObject());
+		break;
+	case EBPVariantType::VT_Array:
+		FromObjectArray(Variant->AsArray, Out.SetAsArray());
+		break;
+	case EBPVariantType::VT_Map:
+	{
+		Out.SetAsMap();
+		FBPVariantMap& Map = Out.MutableMap();
+		Map.Entries.Reserve(Variant->MapKeys.Num());
+		for (int32 i = 0; i < Variant->MapKeys.Num(); ++i)
+		{
+			Map.Entries.Add(Variant->MapKeys[i], FromObject(Variant->MapValues[i]));
+		}
+		break;
+	}
+	case EBPVariantType::VT_IntArray:
+	case EBPVariantType::VT_FloatArray:
+	case EBPVariantType::VT_BoolArray:
+	case EBPVariantType::VT_VectorArray:
+		Out.SetType(Variant->GetType());
+		Out.MutablePacked() = Variant->Packed;
+		break;
+	default:
+	case EBPVariantType::VT_None:
+		break;
+	}
+	return Out;
+}
+
+UBPVariant* FBPVariant::ToObject(UObject* Outer) const
+{
+	switch (Type)
+	{
+	case EBPVariantType::VT_Boolean:
+		return UBPVariant::NewBPVariantAsBoolean(Outer, GetAsBoolean());
+	case EBPVariantType::VT_Integer:
+		return UBPVariant::NewBPVariantAsInteger(Outer, GetAsInteger());
+	case EBPVariantType::VT_Float:
+		return UBPVariant::NewBPVariantAsFloat(Outer, GetAsFloat());
+	case EBPVariantType::VT_String:
+		return UBPVariant::NewBPVariantAsString(Outer, GetAsString());
+	case EBPVariantType::VT_Class:
+		return UBPVariant::NewBPVariantAsClass(Outer, GetAsClass());
+	case EBPVariantType::VT_Object:
+		return UBPVariant::NewBPVariantAsObject(Outer, GetAsObject());
+	case EBPVariantType::VT_Array:
+	{
+		UBPVariant* Out = UBPVariant::NewBPVariantAsArray(Outer);
+		ToObjectArray(Outer, GetAsArray(), Out->AsArray);
+		return Out;
+	}
+	case EBPVariantType::VT_Map:
+	{
+		UBPVariant* Out = UBPVariant::NewBPVariantAsMap(Outer);
+		for (const auto& Entry : GetAsMap().Entries)
+		{
+			Out->SetMapValue(Entry.Key, Entry.Value.ToObject(Outer));
+		}
+		return Out;
+	}
+	case EBPVariantType::VT_IntArray:
+	case EBPVariantType::VT_FloatArray:
+	case EBPVariantType::VT_BoolArray:
+	case EBPVariantType::VT_VectorArray:
+	{
+		UBPVariant* Out = UBPVariant::NewBPVariant(Outer);
+		Out->SetType(Type);
+		Out->Packed = GetPacked();
+		return Out;
+	}
+	default:
+	case EBPVariantType::VT_None:
+		return UBPVariant::NewBPVariant(Outer);
+	}
+}
+
+void FBPVariant::FromObjectArray(const TArray< UBPVariant* >& Variants, TArray< FBPVariant >& OutValues)
+{
+	OutValues.Reset(Variants.Num());
+	for (const UBPVariant* Variant : Variants)
+	{
+		OutValues.Add(FromObject(Variant));
+	}
+}
+
+void FBPVariant::ToObjectArray(UObject* Outer, const TArray< FBPVariant >& Values, TArray< UBPVariant* >& OutVariants)
+{
+	OutVariants.Reset(Values.Num());
+	for (const FBPVariant& Value : Values)
+	{
+		OutVariants.Add(Value.ToObject(Outer));
+	}
+}
+
+bool FBPVariant::operator==(const FBPVariant& Other) const
+{
+	if (Type != Other.Type)
+	{
+		return false;
+	}
+
+	switch (Type)
+	{
+	case EBPVariantType::VT_Boolean:
+		return StoreUnion.StoreBool == Other.StoreUnion.StoreBool;
+	case EBPVariantType::VT_Integer:
+		return StoreUnion.StoreInt32 == Other.StoreUnion.StoreInt32;
+	case EBPVariantType::VT_Float:
+		return StoreUnion.StoreFloat == Other.StoreUnion.StoreFloat;
+	case EBPVariantType::VT_String:
+		return StoreString.Equals(Other.StoreString, ESearchCase::CaseSensitive);
+	case EBPVariantType::VT_Class:
+	case EBPVariantType::VT_Object:
+		return StoreObject == Other.StoreObject;
+	case EBPVariantType::VT_Array:
+		return StoreArray == Other.StoreArray || GetAsArray() == Other.GetAsArray();
+	case EBPVariantType::VT_Map:
+	{
+		if (StoreMap == Other.StoreMap)
+		{
+			return true;
+		}
+		const FBPVariantMap& Map = GetAsMap();
+		if (Map.Entries.Num() != Other.GetMapNum())
+		{
+			return false;
+		}
+		for (const auto& Entry : Map.Entries)
+		{
+			const FBPVariant* OtherValue = Other.FindMapValue(Entry.Key);
+			if (OtherValue == nullptr || *OtherValue != Entry.Value)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	case EBPVariantType::VT_IntArray:
+	case EBPVariantType::VT_FloatArray:
+	case EBPVariantType::VT_BoolArray:
+	case EBPVariantType::VT_VectorArray:
+		return StorePacked == Other.StorePacked || GetPacked().Identical(Type, Other.GetPacked());
+	default:
+	case EBPVariantType::VT_None:
+		return true;
+	}
+}
+
+bool FBPVariant::Equals(const UBPVariant* Variant) const
+{
+	const EBPVariantType OtherType = Variant != nullptr ? Variant->GetType() : EBPVariantType::VT_None;
+	if (Type != OtherType)
+	{
+		return false;
+	}
+
+	switch (Type)
+	{
+	case EBPVariantType::VT_Boolean:
+		return GetAsBoolean() == Variant->GetAsBoolean();
+	case EBPVariantType::VT_Integer:
+		return GetAsInteger() == Variant->GetAsInteger();
+	case EBPVariantType::VT_Float:
+		return GetAsFloat() == Variant->GetAsFloat();
+	case EBPVariantType::VT_String:
+		return StoreString.Equals(Variant->GetAsString(), ESearchCase::CaseSensitive);
+	case EBPVariantType::VT_Class:
+		return GetAsClass() == Variant->GetAsClass();
+	case EBPVariantType::VT_Object:
+		return GetAsObject() == Variant->GetAsObject();
+	case EBPVariantType::VT_Array:
+		return ArrayEquals(GetAsArray(), Variant->AsArray);
+	case EBPVariantType::VT_Map:
+	{
+		if (GetMapNum() != Variant->GetMapNum())
+		{
+			return false;
+		}
+		const TArray< FBPVariant >& Keys = Variant->GetMapKeys();
+		const TArray< UBPVariant* >& Values = Variant->GetMapValues();
+		for (int32 i = 0; i < Keys.Num(); ++i)
+		{
+			const FBPVariant* Value = FindMapValue(Keys[i]);
+			if (Value == nullptr || !Value->Equals(Values[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	case EBPVariantType::VT_IntArray:
+	case EBPVariantType::VT_FloatArray:
+	case EBPVariantType::VT_BoolArray:
+	case EBPVariantType::VT_VectorArray:
+		return GetPacked().Identical(Type, Variant->GetPacked());
+	default:
+	case EBPVariantType::VT_None:
+		return true;
+	}
+}
+
+uint32 GetTypeHash(const FBPVariant& Variant)
+{
+	if (Variant.Type == EBPVariantType::VT_Array)
+	{
+		return HashCombine(GetTypeHash(static_cast<uint8>(EBPVariantType::VT_Array)), FBPVariant::HashArray(Variant.GetAsArray()));
+	}
+	if (Variant.Type == EBPVariantType::VT_Map)
+	{
+		return FBPVariant::HashMap(Variant.GetAsMap());
+	}
+	if (FBPVariantPackedArray::IsPackedType(Variant.Type))
+	{
+		return Variant.GetPacked().GetHash(Variant.Type);
+	}
+	return HashVariantScalar(Variant.Type, Variant.GetAsBoolean(), Variant.GetAsInteger(), Variant.GetAsFloat(), Variant.StoreString, Variant.StoreObject);
+}
+
+uint32 FBPVariant::HashArray(const TArray< FBPVariant >& Values)
+{
+	uint32 Hash = GetTypeHash(Values.Num());
+	for (const FBPVariant& Value : Values)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(Value));
+	}
+	return Hash;
+}
+
+uint32 FBPVariant::HashArray(const TArray< UBPVariant* >& Variants)
+{
+	uint32 Hash = GetTypeHash(Variants.Num());
+	for (const UBPVariant* Variant : Variants)
+	{
+		Hash = HashCombine(Hash, UBPVariant::HashOf(Variant));
+	}
+	return Hash;
+}
+
+bool FBPVariant::ArrayEquals(const TArray< FBPVariant >& Values, const TArray< UBPVariant* >& Variants)
+{
+	if (Values.Num() != Variants.Num())
+	{
+		return false;
+	}
+	for (int32 i = 0; i < Values.Num(); ++i)
+	{
+		if (!Values[i].Equals(Variants[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FBPVariant::AddStructReferencedObjects(FReferenceCollector& Collector) const
+{
+	// a shared node is reported once per owner, which the collector tolerates
+	for (const FBPVariant& Element : GetAsArray())
+	{
+		if (Element.StoreObject != nullptr)
+		{
+			Collector.AddReferencedObject(const_cast<FBPVariant&>(Element).StoreObject);
+		}
+		Element.AddStructReferencedObjects(Collector);
+	}
+
+	// keys are only ever strings or integers, so just the values can hold references
+	if (StoreMap.IsValid())
+	{
+		for (auto& Entry : StoreMap->Entries)
+		{
+			if (Entry.Value.StoreObject != nullptr)
+			{
+				Collector.AddReferencedObject(Entry.Value.StoreObject);
+			}
+			Entry.Value.AddStructReferencedObjects(Collector);
+		}
+	}
+}
+
+static_assert(sizeof(FVector) == 3 * sizeof(float), "Vector arrays are processed as a flat run of floats");
+
+/**
+ * Float kernels of the packed arrays, four lanes at a time with an unaligned load so any TArray works
+ */
+static float SumFloats(const float* Values, int32 Num)
+{
+	// two accumulators hide the latency of the adds
+	VectorRegister Sum0 = VectorZero();
+	VectorRegister Sum1 = VectorZero();
+	int32 i = 0;
+	for (; i + 8 <= Num; i += 8)
+	{
+		Sum0 = VectorAdd(Sum0, VectorLoad(Values + i));
+		Sum1 = VectorAdd(Sum1, VectorLoad(Values + i + 4));
+	}
+	float Lanes[4];
+	VectorStore(VectorAdd(Sum0, Sum1), Lanes);
+	float Sum = (Lanes[0] + Lanes[1]) + (Lanes[2] + Lanes[3]);
+	for (; i < Num; ++i)
+	{
+		Sum += Values[i];
+	}
+	return Sum;
+}
+
+static void GetFloatRange(const float* Values, int32 Num, float& OutMin, float& OutMax)
+{
+	checkSlow(Num > 0);
+	OutMin = OutMax = Values[0];
+	int32 i = 0;
+	if (Num >= 4)
+	{
+		VectorRegister Min = VectorLoad(Values);
+		VectorRegister Max = Min;
+		for (i = 4; i + 4 <= Num; i += 4)
+		{
+			const VectorRegister Value = VectorLoad(Values + i);
+			Min = VectorMin(Min, Value);
+			Max = VectorMax(Max, Value);
+		}
+		float Lanes[4];
+		VectorStore(Min, Lanes);
+		OutMin = FMath::Min(FMath::Min(Lanes[0], Lanes[1]), FMath::Min(Lanes[2], Lanes[3]));
+		VectorStore(Max, Lanes);
+		OutMax = FMath::Max(FMath::Max(Lanes[0], Lanes[1]), FMath::Max(Lanes[2], Lanes[3]));
+	}
+	for (; i < Num; ++i)
+	{
+		OutMin = FMath::Min(OutMin, Values[i]);
+		OutMax = FMath::Max(OutMax, Values[i]);
+	}
+}
+
+static void ScaleFloats(float* Values, int32 Num, float Factor)
+{
+	const VectorRegister VectorFactor = VectorSetFloat1(Factor);
+	int32 i = 0;
+	for (; i + 4 <= Num; i += 4)
+	{
+		VectorStore(VectorMultiply(VectorLoad(Values + i), VectorFactor), Values + i);
+	}
+	for (; i < Num; ++i)
+	{
+		Values[i] *= Factor;
+	}
+}
+
+static void AddFloats(float* Values, const float* Others, int32 Num, float Factor)
+{
+	const VectorRegister VectorFactor = VectorSetFloat1(Factor);
+	int32 i = 0;
+	for (; i + 4 <= Num; i += 4)
+	{
+		VectorStore(VectorMultiplyAdd(VectorLoad(Others + i), VectorFactor, VectorLoad(Values + i)), Values + i);
+	}
+	for (; i < Num; ++i)
+	{
+		Values[i] += Others[i] * Factor;
+	}
+}
+
+/**
+ * Word of a bit array with the bits past its end cleared, TBitArray does not promise they are zero
+ */
+static uint32 GetBoolWord(const TBitArray<>& Bools, int32 WordIndex)
+{
+	const uint32 Word = Bools.GetData()[WordIndex];
+	const int32 BitsInWord = Bools.Num() - WordIndex * 32;
+	return BitsInWord >= 32 ? Word : Word & ((1u << BitsInWord) - 1);
+}
+
+static int32 CountBoolWordBits(uint32 Word)
+{
+	Word = Word - ((Word >> 1) & 0x55555555);
+	Word = (Word & 0x33333333) + ((Word >> 2) & 0x33333333);
+	return static_cast<int32>((((Word + (Word >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+}
+
+bool FBPVariantPackedArray::IsPackedType(EBPVariantType Type)
+{
+	return Type == EBPVariantType::VT_IntArray
+		|| Type == EBPVariantType::VT_FloatArray
+		|| Type == EBPVariantType::VT_BoolArray
+		|| Type == EBPVariantType::VT_VectorArray;
+}
+
+void FBPVariantPackedArray::Reset()
+{
+	Ints.Reset();
+	Floats.Reset();
+	Bools.Reset();
+	Vectors.Reset();
+}
+
+int32 FBPVariantPackedArray::Num(EBPVariantType Type) const
+{
+	switch (Type)
+	{
+	case EBPVariantType::VT_IntArray:
+		return Ints.Num();
+	case EBPVariantType::VT_FloatArray:
+		return Floats.Num();
+	case EBPVariantType::VT_BoolArray:
+		return Bools.Num();
+	case EBPVariantType::VT_VectorArray:
+		return Vectors.Num();
+	default:
+		return 0;
+	}
+}
+
+bool FBPVariantPackedArray::Identical(EBPVariantType Type, const FBPVariantPackedArray& Other) const
+{
+	if (Num(Type) != Other.Num(Type))
+	{
+		return false;
+	}
+
+	switch (Type)
+	{
+	case EBPVariantType::VT_IntArray:
+		return FMemory::Memcmp(Ints.GetData(), Other.Ints.GetData(), Ints.Num() * sizeof(int32)) == 0;
+	case EBPVariantType::VT_FloatArray:
+		return FMemory::Memcmp(Floats.GetData(), Other.Floats.GetData(), Floats.Num() * sizeof(float)) == 0;
+	case EBPVariantType::VT_VectorArray:
+		return FMemory::Memcmp(Vectors.GetData(), Other.Vectors.GetData(), Vectors.Num() * sizeof(FVector)) == 0;
+	case EBPVariantType::VT_BoolArray:
+		for (int32 Word = 0; Word < FMath::DivideAndRoundUp(Bools.Num(), 32); ++Word)
+		{
+			if (GetBoolWord(Bools, Word) != GetBoolWord(Other.Bools, Word))
+			{
+				return false;
+			}
+		}
+		return true;
+	default:
+		return true;
+	}
+}
+
+uint32 FBPVariantPackedArray::GetHash(EBPVariantType Type) const
+{
+	const uint32 Hash = HashCombine(GetTypeHash(static_cast<uint8>(Type)), GetTypeHash(Num(Type)));
+	switch (Type)
+	{
+	case EBPVariantType::VT_IntArray:
+		return FCrc::MemCrc32(Ints.GetData(), Ints.Num() * sizeof(int32), Hash);
+	case EBPVariantType::VT_FloatArray:
+		return FCrc::MemCrc32(Floats.GetData(), Floats.Num() * sizeof(float), Hash);
+	case EBPVariantType::VT_VectorArray:
+		return FCrc::MemCrc32(Vectors.GetData(), Vectors.Num() * sizeof(FVector), Hash);
+	case EBPVariantType::VT_BoolArray:
+	{
+		uint32 BoolHash = Hash;
+		for (int32 Word = 0; Word < FMath::DivideAndRoundUp(Bools.Num(), 32); ++Word)
+		{
+			BoolHash = HashCombine(BoolHash, GetBoolWord(Bools, Word));
+		}
+		return BoolHash;
+	}
+	default:
+		return Hash;
+	}
+}
+
+FString FBPVariantPackedArray::GetDebugValue(EBPVariantType Type) const
+{
+	// heightmaps and the like run to thousands of elements, just show the start
+	const int32 MaxShown = 16;
+	const int32 Count = Num(Type);
+	FString Out = FString::Printf(TEXT("%s(%d)["), FBPVariant::GetTypeName(Type), Count);
+	for (int32 i = 0; i < FMath::Min(Count, MaxShown); ++i)
+	{
+		if (i > 0) Out.Append(", ");
+		switch (Type)
+		{
+		case EBPVariantType::VT_IntArray:
+			Out.Append(FString::Printf(TEXT("%d"), Ints[i]));
+			break;
+		case EBPVariantType::VT_FloatArray:
+			Out.Append(FString::Printf(TEXT("%f"), Floats[i]));
+			break;
+		case EBPVariantType::VT_BoolArray:
+			Out.Append(Bools[i] ? TEXT("true") : TEXT("false"));
+			break;
+		case EBPVariantType::VT_VectorArray:
+			Out.Append(Vectors[i].ToString());
+			break;
+		default:
+			break;
+		}
+	}
+	if (Count > MaxShown)
+	{
+		Out.Append(", ...");
+	}
+	Out.Append("]");
+	return Out;
+}
+
+float FBPVariantPackedArray::Sum(EBPVariantType Type) const
+{
+	switch (Type)
+	{
+	case EBPVariantType::VT_IntArray:
+	{
+		int64 Sum = 0;
+		for (const int32 Value : Ints)
+		{
+			Sum += Value;
+		}
+		return static_cast<float>(Sum);
+	}
+	case EBPVariantType::VT_FloatArray:
+		return SumFloats(Floats.GetData(), Floats.Num());
+	case EBPVariantType::VT_BoolArray:
+	{
+		int32 Count = 0;
+		for (int32 Word = 0; Word < FMath::DivideAndRoundUp(Bools.Num(), 32); ++Word)
+		{
+			Count += CountBoolWordBits(GetBoolWord(Bools, Word));
+		}
+		return static_cast<float>(Count);
+	}
+	default:
+		return 0.0f;
+	}
+}
+
+bool FBPVariantPackedArray::GetRange(EBPVariantType Type, float& OutMin, float& OutMax) const
+{
+	OutMin = OutMax = 0.0f;
+	if (Type == EBPVariantType::VT_FloatArray && Floats.Num() > 0)
+	{
+		GetFloatRange(Floats.GetData(), Floats.Num(), OutMin, OutMax);
+		return true;
+	}
+	if (Type == EBPVariantType::VT_IntArray && Ints.Num() > 0)
+	{
+		int32 Min = Ints[0];
+		int32 Max = Ints[0];
+		for (const int32 Value : Ints)
+		{
+			Min = FMath::Min(Min, Value);
+			Max = FMath::Max(Max, Value);
+		}
+		OutMin = static_cast<float>(Min);
+		OutMax = static_cast<float>(Max);
+		return true;
+	}
+	return false;
+}
+
+FVector FBPVariantPackedArray::SumVectors() const
+{
+	FVector Sum = FVector::ZeroVector;
+	for (const FVector& Value : Vectors)
+	{
+		Sum += Value;
+	}
+	return Sum;
+}
+
+bool FBPVariantPackedArray::GetVectorBounds(FVector& OutMin, FVector& OutMax) const
+{
+	if (Vectors.Num() == 0)
+	{
+		OutMin = OutMax = FVector::ZeroVector;
+		return false;
+	}
+	OutMin = OutMax = Vectors[0];
+	for (const FVector& Value : Vectors)
+	{
+		OutMin = OutMin.ComponentMin(Value);
+		OutMax = OutMax.ComponentMax(Value);
+	}
+	return true;
+}
+
+bool FBPVariantPackedArray::Scale(EBPVariantType Type, float Factor)
+{
+	switch (Type)
+	{
+	case EBPVariantType::VT_IntArray:
+		for (int32& Value : Ints)
+		{
+			Value = FMath::RoundToInt(Value * Factor);
+		}
+		return true;
+	case EBPVariantType::VT_FloatArray:
+		ScaleFloats(Floats.GetData(), Floats.Num(), Factor);
+		return true;
+	case EBPVariantType::VT_VectorArray:
+		ScaleFloats(reinterpret_cast<float*>(Vectors.GetData()), Vectors.Num() * 3, Factor);
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool FBPVariantPackedArray::Add(EBPVariantType Type, const FBPVariantPackedArray& Other, float Factor)
+{
+	if (Num(Type) != Other.Num(Type))
+	{
+		return false;
+	}
+
+	switch (Type)
+	{
+	case EBPVariantType::VT_IntArray:
+		if (Factor == 1.0f)
+		{
+			for (int32 i = 0; i < Ints.Num(); ++i)
+			{
+				Ints[i] += Other.Ints[i];
+			}
+		}
+		else
+		{
+			for (int32 i = 0; i < Ints.Num(); ++i)
+			{
+				Ints[i] += FMath::RoundToInt(Other.Ints[i] * Factor);
+			}
+		}
+		return true;
+	case EBPVariantType::VT_FloatArray:
+		AddFloats(Floats.GetData(), Other.Floats.GetData(), Floats.Num(), Factor);
+		return true;
+	case EBPVariantType::VT_VectorArray:
+		AddFloats(reinterpret_cast<float*>(Vectors.GetData()), reinterpret_cast<const float*>(Other.Vectors.GetData()), Vectors.Num() * 3, Factor);
+		return true;
+	default:
+		return false;
+	}
+}
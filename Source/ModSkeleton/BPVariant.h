@@ -29,7 +29,292 @@ enum class EBPVariantType : uint8
 	VT_String UMETA(DisplayName="String"),
 	VT_Class UMETA(DisplayName="Class"),
 	VT_Object UMETA(DisplayName="Object"),
-	VT_Array UMETA(DisplayName="Array")
+	VT_Array UMETA(DisplayName="Array"),
+	VT_Map UMETA(DisplayName="Map"),
+	VT_IntArray UMETA(DisplayName="Integer Array"),
+	VT_FloatArray UMETA(DisplayName="Float Array"),
+	VT_BoolArray UMETA(DisplayName="Boolean Array"),
+	VT_VectorArray UMETA(DisplayName="Vector Array")
+};
+
+class UBPVariant;
+struct FBPVariantMap;
+
+/**
+ * Storage of the packed array kinds: contiguous integers, floats or vectors, or booleans one bit each.
+ * Only the array matching the variant's type holds anything.
+ * The bulk operations run four floats at a time on float and vector arrays.
+ */
+struct MODSKELETON_API FBPVariantPackedArray
+{
+	TArray<int32> Ints;
+	TArray<float> Floats;
+	TBitArray<> Bools;
+	TArray<FVector> Vectors;
+
+	static bool IsPackedType(EBPVariantType Type);
+
+	/**
+	 * Empty every array, keeping their allocations
+	 */
+	void Reset();
+
+	int32 Num(EBPVariantType Type) const;
+
+	/**
+	 * Bitwise comparison, so it agrees with GetHash (0.0 and -0.0 differ)
+	 */
+	bool Identical(EBPVariantType Type, const FBPVariantPackedArray& Other) const;
+	uint32 GetHash(EBPVariantType Type) const;
+	FString GetDebugValue(EBPVariantType Type) const;
+
+	/**
+	 * Sum of an Integer or Float array, or the number of true elements of a Boolean array
+	 */
+	float Sum(EBPVariantType Type) const;
+
+	/**
+	 * Smallest and largest element of an Integer or Float array. False if it is empty.
+	 */
+	bool GetRange(EBPVariantType Type, float& OutMin, float& OutMax) const;
+
+	FVector SumVectors() const;
+
+	/**
+	 * Component wise bounds of a Vector array. False if it is empty.
+	 */
+	bool GetVectorBounds(FVector& OutMin, FVector& OutMax) const;
+
+	/**
+	 * Multiply every element of an Integer, Float or Vector array by Factor (integers are rounded)
+	 */
+	bool Scale(EBPVariantType Type, float Factor);
+
+	/**
+	 * Element wise this += Other * Factor, for Integer, Float or Vector arrays of the same length
+	 */
+	bool Add(EBPVariantType Type, const FBPVariantPackedArray& Other, float Factor);
+};
+
+/**
+ * Value type counterpart of UBPVariant.
+ * Stores scalars, class / object references and strings inline, so hook IO can be carried
+ * as a contiguous TArray< FBPVariant > without one UObject allocation per argument.
+ * Arrays, maps and packed arrays are reference counted nodes shared between copies and copied on the first write,
+ * so a handler that changes one nested field copies only the path down to it.
+ * See UBPVariantBpFunctionLib for the blueprint accessors.
+ */
+USTRUCT(BlueprintType)
+struct MODSKELETON_API FBPVariant
+{
+	GENERATED_BODY()
+
+	FBPVariant();
+
+	EBPVariantType GetType() const;
+	FString GetDebugValue() const;
+
+	bool GetAsBoolean() const;
+	bool SetAsBoolean(bool Value);
+
+	int32 GetAsInteger() const;
+	int32 SetAsInteger(int32 Value);
+
+	float GetAsFloat() const;
+	float SetAsFloat(float Value);
+
+	const FString& GetAsString() const;
+	const FString& SetAsString(const FString& Value);
+
+	UClass* GetAsClass() const;
+	UClass* SetAsClass(UClass* Value);
+
+	UObject* GetAsObject() const;
+	UObject* SetAsObject(UObject* Value);
+
+	const TArray< FBPVariant >& GetAsArray() const;
+	TArray< FBPVariant >& SetAsArray();
+
+	/**
+	 * Elements of a VT_Array to edit in place. Only this level is unshared, the elements still share theirs.
+	 */
+	TArray< FBPVariant >& GetMutableArray();
+
+	/**
+	 * VT_Map: entries keyed by String or Integer variants (store FName keys as strings).
+	 * Copies of a map share its entries until one of them is modified.
+	 */
+	void SetAsMap();
+	const FBPVariantMap& GetAsMap() const;
+	int32 GetMapNum() const;
+	const FBPVariant* FindMapValue(const FBPVariant& Key) const;
+
+	/**
+	 * Value under Key, added as None if it is missing. Key must be a valid map key and this must be a VT_Map.
+	 */
+	FBPVariant& FindOrAddMapValue(const FBPVariant& Key);
+	FBPVariant* FindMutableMapValue(const FBPVariant& Key);
+	bool RemoveMapValue(const FBPVariant& Key);
+
+	static bool IsValidMapKey(const FBPVariant& Key);
+
+	/**
+	 * Packed arrays. The SetAs functions return the (emptied) storage to fill in bulk.
+	 * Like maps, copies share the elements until one of them is modified.
+	 */
+	TArray<int32>& SetAsIntArray();
+	TArray<float>& SetAsFloatArray();
+	TBitArray<>& SetAsBoolArray();
+	TArray<FVector>& SetAsVectorArray();
+
+	const TArray<int32>& GetAsIntArray() const;
+	const TArray<float>& GetAsFloatArray() const;
+	const TBitArray<>& GetAsBoolArray() const;
+	const TArray<FVector>& GetAsVectorArray() const;
+
+	/**
+	 * Elements of whichever packed array this is. Empty unless GetType() is a packed array type.
+	 */
+	const FBPVariantPackedArray& GetPacked() const;
+	int32 GetPackedNum() const;
+
+	/**
+	 * See FBPVariantPackedArray
+	 */
+	float GetPackedSum() const;
+	bool GetPackedRange(float& OutMin, float& OutMax) const;
+	FVector GetPackedVectorSum() const;
+	bool GetPackedVectorBounds(FVector& OutMin, FVector& OutMax) const;
+	bool ScalePacked(float Factor);
+	bool AddPacked(const FBPVariant& Other, float Factor = 1.0f);
+
+	/**
+	 * Unchecked accessors for native handlers of hooks with a HookIOTypes schema.
+	 * The registry has already validated the type, so these skip the branch (checkSlow only).
+	 */
+	bool GetAsBooleanUnchecked() const { checkSlow(Type == EBPVariantType::VT_Boolean); return StoreUnion.StoreBool; }
+	int32 GetAsIntegerUnchecked() const { checkSlow(Type == EBPVariantType::VT_Integer); return StoreUnion.StoreInt32; }
+	float GetAsFloatUnchecked() const { checkSlow(Type == EBPVariantType::VT_Float); return StoreUnion.StoreFloat; }
+	const FString& GetAsStringUnchecked() const { checkSlow(Type == EBPVariantType::VT_String); return StoreString; }
+	UClass* GetAsClassUnchecked() const { checkSlow(Type == EBPVariantType::VT_Class); return static_cast<UClass*>(StoreObject); }
+	UObject* GetAsObjectUnchecked() const { checkSlow(Type == EBPVariantType::VT_Object); return StoreObject; }
+	const TArray< FBPVariant >& GetAsArrayUnchecked() const { checkSlow(Type == EBPVariantType::VT_Array); return GetAsArray(); }
+
+	/**
+	 * True if this and Other are copies of the same array, map or packed array that neither has written to since
+	 */
+	bool SharesStorageWith(const FBPVariant& Other) const;
+
+	/**
+	 * Display name of a type, for diagnostics
+	 */
+	static const TCHAR* GetTypeName(EBPVariantType Type);
+
+	/**
+	 * Structural comparison, recursing into arrays. Strings compare case sensitively.
+	 */
+	bool operator==(const FBPVariant& Other) const;
+	bool operator!=(const FBPVariant& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	/**
+	 * Structural comparison against a UBPVariant tree, without converting it. A null Variant equals VT_None.
+	 */
+	bool Equals(const UBPVariant* Variant) const;
+
+	friend MODSKELETON_API uint32 GetTypeHash(const FBPVariant& Variant);
+
+	/**
+	 * Hash of a whole HookIO array, equal for a value array and an object array holding the same values
+	 */
+	static uint32 HashArray(const TArray< FBPVariant >& Values);
+	static uint32 HashArray(const TArray< UBPVariant* >& Variants);
+	static bool ArrayEquals(const TArray< FBPVariant >& Values, const TArray< UBPVariant* >& Variants);
+
+	/**
+	 * Conversion shims for code that still deals in UBPVariant objects
+	 */
+	static FBPVariant FromObject(const UBPVariant* Variant);
+	UBPVariant* ToObject(UObject* Outer) const;
+
+	static void FromObjectArray(const TArray< UBPVariant* >& Variants, TArray< FBPVariant >& OutValues);
+	static void ToObjectArray(UObject* Outer, const TArray< FBPVariant >& Values, TArray< UBPVariant* >& OutVariants);
+
+	/**
+	 * Nested array elements are not UPROPERTYs (UHT does not allow recursive structs), report them here
+	 */
+	void AddStructReferencedObjects(FReferenceCollector& Collector) const;
+
+private:
+	friend struct FBPVariantSerializer;
+
+	UPROPERTY()
+	EBPVariantType Type;
+
+	void SetType(EBPVariantType NewType);
+
+	union PrivStoreUnion
+	{
+		bool StoreBool;
+		int32 StoreInt32;
+		float StoreFloat;
+	};
+	PrivStoreUnion StoreUnion;
+
+	/**
+	 * Reused across type changes, so switching back to a string keeps the allocation
+	 */
+	UPROPERTY()
+	FString StoreString;
+
+	/**
+	 * Holds both VT_Class and VT_Object values
+	 */
+	UPROPERTY()
+	UObject* StoreObject;
+
+	/**
+	 * Shared between copies, copied on the first write (see MutableArray).
+	 * Kept (emptied) across type changes while unshared, so a warm value can be refilled without allocating.
+	 */
+	TSharedPtr< TArray< FBPVariant >, ESPMode::ThreadSafe > StoreArray;
+
+	TArray< FBPVariant >& MutableArray();
+
+	/**
+	 * Shared between copies like StoreArray
+	 */
+	TSharedPtr< FBPVariantMap, ESPMode::ThreadSafe > StoreMap;
+
+	FBPVariantMap& MutableMap();
+
+	/**
+	 * Shared between copies and kept across type changes like StoreArray
+	 */
+	TSharedPtr< FBPVariantPackedArray, ESPMode::ThreadSafe > StorePacked;
+
+	FBPVariantPackedArray& MutablePacked();
+
+	static uint32 HashMap(const FBPVariantMap& Map);
+};
+
+/**
+ * Entries of a VT_Map FBPVariant
+ */
+struct MODSKELETON_API FBPVariantMap
+{
+	TMap< FBPVariant, FBPVariant > Entries;
+};
+
+template<>
+struct TStructOpsTypeTraits<FBPVariant> : public TStructOpsTypeTraitsBase
+{
+	enum
+	{
+		WithAddStructReferencedObjects = true,
+	};
 };
 
 /**
@@ -47,6 +332,18 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, meta = (CompactNodeTitle = "DebugValue"))
 	virtual FString GetDebugValue() const;
 
+	/**
+	 * Hash of the type and value, recursing into arrays. Matches GetTypeHash of an FBPVariant holding the same value.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, meta = (CompactNodeTitle = "Hash"))
+	virtual int32 GetStructuralHash() const;
+
+	/**
+	 * True if Other holds the same type and value, comparing arrays element by element. None equals a null variant.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	virtual bool StructurallyEquals(const UBPVariant* Other) const;
+
 	UFUNCTION(BlueprintCallable, meta = (HidePin = Outer, DefaultToSelf = Outer))
 	static UBPVariant* NewBPVariantAsBoolean(UObject* Outer, bool Value);
 
@@ -110,7 +407,145 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BPVariant")
 	TArray< UBPVariant* > AsArray;
 
+	UFUNCTION(BlueprintCallable, meta = (HidePin = Outer, DefaultToSelf = Outer))
+	static UBPVariant* NewBPVariantAsMap(UObject* Outer);
+
+	/**
+	 * Become an empty VT_Map. Map keys are String or Integer variants - store FName keys as strings.
+	 */
+	UFUNCTION(BlueprintCallable)
+	virtual void SetAsMap();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	virtual int32 GetMapNum() const;
+
+	/**
+	 * Value stored under Key, or nullptr if there is none (or this is not a VT_Map)
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	virtual UBPVariant* FindMapValue(const FBPVariant& Key) const;
+
+	/**
+	 * Add or replace the value under Key. Returns false if this is not a VT_Map or Key is not a String or Integer.
+	 */
+	UFUNCTION(BlueprintCallable)
+	virtual bool SetMapValue(const FBPVariant& Key, UBPVariant* Value);
+
+	UFUNCTION(BlueprintCallable)
+	virtual bool RemoveMapValue(const FBPVariant& Key);
+
+	/**
+	 * Keys and values in matching order
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	virtual const TArray< FBPVariant >& GetMapKeys() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	virtual const TArray< UBPVariant* >& GetMapValues() const;
+
+	/**
+	 * Packed arrays hold every element in this one variant, instead of one UBPVariant per element
+	 */
+	UFUNCTION(BlueprintCallable, meta = (HidePin = Outer, DefaultToSelf = Outer))
+	static UBPVariant* NewBPVariantAsIntArray(UObject* Outer, const TArray<int32>& Values);
+
+	UFUNCTION(BlueprintCallable, meta = (HidePin = Outer, DefaultToSelf = Outer))
+	static UBPVariant* NewBPVariantAsFloatArray(UObject* Outer, const TArray<float>& Values);
+
+	UFUNCTION(BlueprintCallable, meta = (HidePin = Outer, DefaultToSelf = Outer))
+	static UBPVariant* NewBPVariantAsBoolArray(UObject* Outer, const TArray<bool>& Values);
+
+	UFUNCTION(BlueprintCallable, meta = (HidePin = Outer, DefaultToSelf = Outer))
+	static UBPVariant* NewBPVariantAsVectorArray(UObject* Outer, const TArray<FVector>& Values);
+
+	UFUNCTION(BlueprintCallable)
+	virtual void SetAsIntArray(const TArray<int32>& Values);
+
+	UFUNCTION(BlueprintCallable)
+	virtual void SetAsFloatArray(const TArray<float>& Values);
+
+	UFUNCTION(BlueprintCallable)
+	virtual void SetAsBoolArray(const TArray<bool>& Values);
+
+	UFUNCTION(BlueprintCallable)
+	virtual void SetAsVectorArray(const TArray<FVector>& Values);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, meta = (CompactNodeTitle = "Integer Array"))
+	virtual const TArray<int32>& GetAsIntArray() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, meta = (CompactNodeTitle = "Float Array"))
+	virtual const TArray<float>& GetAsFloatArray() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, meta = (CompactNodeTitle = "Boolean Array"))
+	virtual TArray<bool> GetAsBoolArray() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, meta = (CompactNodeTitle = "Vector Array"))
+	virtual const TArray<FVector>& GetAsVectorArray() const;
+
+	/**
+	 * Number of elements of a packed array, 0 for any other type
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	virtual int32 GetPackedNum() const;
+
+	/**
+	 * Sum of an Integer or Float array, or the number of true elements of a Boolean array
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	virtual float GetPackedSum() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	virtual bool GetPackedRange(float& Min, float& Max) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	virtual FVector GetPackedVectorSum() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	virtual bool GetPackedVectorBounds(FVector& Min, FVector& Max) const;
+
+	/**
+	 * Multiply every element of an Integer, Float or Vector array
+	 */
+	UFUNCTION(BlueprintCallable)
+	virtual bool ScalePacked(float Factor);
+
+	/**
+	 * Element wise this += Other * Factor, for packed arrays of the same type and length
+	 */
+	UFUNCTION(BlueprintCallable)
+	virtual bool AddPacked(const UBPVariant* Other, float Factor = 1.0f);
+
+	const FBPVariantPackedArray& GetPacked() const
+	{
+		return Packed;
+	}
+
+	/**
+	 * Unchecked accessors for native handlers of hooks with a HookIOTypes schema.
+	 * The registry has already validated the type, so these skip the branch (checkSlow only).
+	 */
+	bool GetAsBooleanUnchecked() const { checkSlow(Type == EBPVariantType::VT_Boolean); return StoreUnion.StoreBool; }
+	int32 GetAsIntegerUnchecked() const { checkSlow(Type == EBPVariantType::VT_Integer); return StoreUnion.StoreInt32; }
+	float GetAsFloatUnchecked() const { checkSlow(Type == EBPVariantType::VT_Float); return StoreUnion.StoreFloat; }
+	const FString& GetAsStringUnchecked() const { checkSlow(Type == EBPVariantType::VT_String); return StoreString; }
+	UClass* GetAsClassUnchecked() const { checkSlow(Type == EBPVariantType::VT_Class); return StoreUnion.StoreClass; }
+	UObject* GetAsObjectUnchecked() const { checkSlow(Type == EBPVariantType::VT_Object); return StoreObject; }
+
 private:
+	friend class UBPVariantPool;
+	friend struct FBPVariant;
+
+	/**
+	 * Allocates from the pool of the hook invocation in progress, if there is one
+	 */
+	static UBPVariant* NewBPVariant(UObject* Outer);
+
+	/**
+	 * GetStructuralHash / StructurallyEquals that also accept nullptr, which behaves as VT_None
+	 */
+	static uint32 HashOf(const UBPVariant* Variant);
+	static bool Equal(const UBPVariant* A, const UBPVariant* B);
+
 	EBPVariantType Type;
 	void SetType(EBPVariantType NewType);
 
@@ -119,11 +554,33 @@ private:
 		bool StoreBool;
 		int32 StoreInt32;
 		float StoreFloat;
-		FString* StoreString;
 		UClass* StoreClass;
 	};
 	PrivStoreUnion StoreUnion;
 
+	/**
+	 * Reused across type changes (and pool recycling), so switching back to a string keeps the allocation
+	 */
+	FString StoreString;
+
+	/**
+	 * VT_Map entries: MapKeys[i] -> MapValues[i]. MapIndex maps key hashes to positions for hashed lookup.
+	 */
+	TArray< FBPVariant > MapKeys;
+	TMultiMap< uint32, int32 > MapIndex;
+
+	int32 FindMapIndex(const FBPVariant& Key) const;
+
+	UPROPERTY()
+	TArray< UBPVariant* > MapValues;
+
+	FBPVariantPackedArray Packed;
+
+	/**
+	 * Set while this variant sits in a UBPVariantPool free list
+	 */
+	bool bInPool;
+
 	UPROPERTY()
 	UObject* StoreObject;
 };
@@ -0,0 +1,351 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ModSkeleton.h"
+#include "BPVariantBpFunctionLib.h"
+#include "BPVariantSerializer.h"
+
+EBPVariantType UBPVariantBpFunctionLib::GetVariantType(const FBPVariant& Variant)
+{
+	return Variant.GetType();
+}
+
+FString UBPVariantBpFunctionLib::GetVariantDebugValue(const FBPVariant& Variant)
+{
+	return Variant.GetDebugValue();
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsBoolean(bool Value)
+{
+	FBPVariant Out;
+	Out.SetAsBoolean(Value);
+	return Out;
+}
+
+bool UBPVariantBpFunctionLib::GetVariantAsBoolean(const FBPVariant& Variant)
+{
+	return Variant.GetAsBoolean();
+}
+
+bool UBPVariantBpFunctionLib::SetVariantAsBoolean(FBPVariant& Variant, bool Value)
+{
+	return Variant.SetAsBoolean(Value);
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsInteger(int32 Value)
+{
+	FBPVariant Out;
+	Out.SetAsInteger(Value);
+	return Out;
+}
+
+int32 UBPVariantBpFunctionLib::GetVariantAsInteger(const FBPVariant& Variant)
+{
+	return Variant.GetAsInteger();
+}
+
+int32 UBPVariantBpFunctionLib::SetVariantAsInteger(FBPVariant& Variant, int32 Value)
+{
+	return Variant.SetAsInteger(Value);
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsFloat(float Value)
+{
+	FBPVariant Out;
+	Out.SetAsFloat(Value);
+	return Out;
+}
+
+float UBPVariantBpFunctionLib::GetVariantAsFloat(const FBPVariant& Variant)
+{
+	return Variant.GetAsFloat();
+}
+
+float UBPVariantBpFunctionLib::SetVariantAsFloat(FBPVariant& Variant, float Value)
+{
+	return Variant.SetAsFloat(Value);
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsString(const FString& Value)
+{
+	FBPVariant Out;
+	Out.SetAsString(Value);
+	return Out;
+}
+
+FString UBPVariantBpFunctionLib::GetVariantAsString(const FBPVariant& Variant)
+{
+	return Variant.GetAsString();
+}
+
+FString UBPVariantBpFunctionLib::SetVariantAsString(FBPVariant& Variant, const FString& Value)
+{
+	return Variant.SetAsString(Value);
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsClass(UClass* Value)
+{
+	FBPVariant Out;
+	Out.SetAsClass(Value);
+	return Out;
+}
+
+UClass* UBPVariantBpFunctionLib::GetVariantAsClass(const FBPVariant& Variant)
+{
+	return Variant.GetAsClass();
+}
+
+UClass* UBPVariantBpFunctionLib::SetVariantAsClass(FBPVariant& Variant, UClass* Value)
+{
+	return Variant.SetAsClass(Value);
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsObject(UObject* Value)
+{
+	FBPVariant Out;
+	Out.SetAsObject(Value);
+	return Out;
+}
+
+UObject* UBPVariantBpFunctionLib::GetVariantAsObject(const FBPVariant& Variant)
+{
+	return Variant.GetAsObject();
+}
+
+UObject* UBPVariantBpFunctionLib::SetVariantAsObject(FBPVariant& Variant, UObject* Value)
+{
+	return Variant.SetAsObject(Value);
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsArray(const TArray< FBPVariant >& Value)
+{
+	FBPVariant Out;
+	Out.SetAsArray() = Value;
+	return Out;
+}
+
+TArray< FBPVariant > UBPVariantBpFunctionLib::GetVariantAsArray(const FBPVariant& Variant)
+{
+	return Variant.GetAsArray();
+}
+
+void UBPVariantBpFunctionLib::SetVariantAsArray(FBPVariant& Variant, const TArray< FBPVariant >& Value)
+{
+	Variant.SetAsArray() = Value;
+}
+
+bool UBPVariantBpFunctionLib::GetVariantArrayElement(const FBPVariant& Variant, int32 Index, FBPVariant& Element)
+{
+	const TArray< FBPVariant >& Elements = Variant.GetAsArray();
+	if (!Elements.IsValidIndex(Index))
+	{
+		Element = FBPVariant();
+		return false;
+	}
+	Element = Elements[Index];
+	return true;
+}
+
+bool UBPVariantBpFunctionLib::SetVariantArrayElement(FBPVariant& Variant, int32 Index, const FBPVariant& Element)
+{
+	if (Variant.GetType() != EBPVariantType::VT_Array || !Variant.GetAsArray().IsValidIndex(Index))
+	{
+		return false;
+	}
+	Variant.GetMutableArray()[Index] = Element;
+	return true;
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsMap()
+{
+	FBPVariant Out;
+	Out.SetAsMap();
+	return Out;
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantMapKeyFromName(FName Name)
+{
+	FBPVariant Out;
+	Out.SetAsString(Name.ToString());
+	return Out;
+}
+
+int32 UBPVariantBpFunctionLib::GetVariantMapNum(const FBPVariant& Variant)
+{
+	return Variant.GetMapNum();
+}
+
+bool UBPVariantBpFunctionLib::FindVariantMapValue(const FBPVariant& Variant, const FBPVariant& Key, FBPVariant& Value)
+{
+	const FBPVariant* Found = Variant.FindMapValue(Key);
+	if (Found == nullptr)
+	{
+		Value = FBPVariant();
+		return false;
+	}
+	Value = *Found;
+	return true;
+}
+
+bool UBPVariantBpFunctionLib::SetVariantMapValue(FBPVariant& Variant, const FBPVariant& Key, const FBPVariant& Value)
+{
+	if (Variant.GetType() != EBPVariantType::VT_Map || !FBPVariant::IsValidMapKey(Key))
+	{
+		return false;
+	}
+	Variant.FindOrAddMapValue(Key) = Value;
+	return true;
+}
+
+bool UBPVariantBpFunctionLib::RemoveVariantMapValue(FBPVariant& Variant, const FBPVariant& Key)
+{
+	return Variant.RemoveMapValue(Key);
+}
+
+void UBPVariantBpFunctionLib::GetVariantMapEntries(const FBPVariant& Variant, TArray< FBPVariant >& Keys, TArray< FBPVariant >& Values)
+{
+	const FBPVariantMap& Map = Variant.GetAsMap();
+	Map.Entries.GenerateKeyArray(Keys);
+	Map.Entries.GenerateValueArray(Values);
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsIntArray(const TArray<int32>& Values)
+{
+	FBPVariant Out;
+	Out.SetAsIntArray() = Values;
+	return Out;
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsFloatArray(const TArray<float>& Values)
+{
+	FBPVariant Out;
+	Out.SetAsFloatArray() = Values;
+	return Out;
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsBoolArray(const TArray<bool>& Values)
+{
+	FBPVariant Out;
+	TBitArray<>& Bools = Out.SetAsBoolArray();
+	Bools.Init(false, Values.Num());
+	for (int32 i = 0; i < Values.Num(); ++i)
+	{
+		Bools[i] = Values[i];
+	}
+	return Out;
+}
+
+FBPVariant UBPVariantBpFunctionLib::MakeVariantAsVectorArray(const TArray<FVector>& Values)
+{
+	FBPVariant Out;
+	Out.SetAsVectorArray() = Values;
+	return Out;
+}
+
+TArray<int32> UBPVariantBpFunctionLib::GetVariantAsIntArray(const FBPVariant& Variant)
+{
+	return Variant.GetAsIntArray();
+}
+
+TArray<float> UBPVariantBpFunctionLib::GetVariantAsFloatArray(const FBPVariant& Variant)
+{
+	return Variant.GetAsFloatArray();
+}
+
+TArray<bool> UBPVariantBpFunctionLib::GetVariantAsBoolArray(const FBPVariant& Variant)
+{
+	const TBitArray<>& Bools = Variant.GetAsBoolArray();
+	TArray<bool> Out;
+	Out.Reserve(Bools.Num());
+	for (int32 i = 0; i < Bools.Num(); ++i)
+	{
+		Out.Add(Bools[i]);
+	}
+	return Out;
+}
+
+TArray<FVector> UBPVariantBpFunctionLib::GetVariantAsVectorArray(const FBPVariant& Variant)
+{
+	return Variant.GetAsVectorArray();
+}
+
+int32 UBPVariantBpFunctionLib::GetVariantPackedNum(const FBPVariant& Variant)
+{
+	return Variant.GetPackedNum();
+}
+
+float UBPVariantBpFunctionLib::SumVariantPacked(const FBPVariant& Variant)
+{
+	return Variant.GetPackedSum();
+}
+
+bool UBPVariantBpFunctionLib::GetVariantPackedRange(const FBPVariant& Variant, float& Min, float& Max)
+{
+	return Variant.GetPackedRange(Min, Max);
+}
+
+FVector UBPVariantBpFunctionLib::SumVariantVectors(const FBPVariant& Variant)
+{
+	return Variant.GetPackedVectorSum();
+}
+
+bool UBPVariantBpFunctionLib::GetVariantVectorBounds(const FBPVariant& Variant, FVector& Min, FVector& Max)
+{
+	return Variant.GetPackedVectorBounds(Min, Max);
+}
+
+bool UBPVariantBpFunctionLib::ScaleVariantPacked(FBPVariant& Variant, float Factor)
+{
+	return Variant.ScalePacked(Factor);
+}
+
+bool UBPVariantBpFunctionLib::AddVariantPacked(FBPVariant& Variant, const FBPVariant& Other, float Factor)
+{
+	return Variant.AddPacked(Other, Factor);
+}
+
+FBPVariant UBPVariantBpFunctionLib::ToVariantValue(const UBPVariant* Variant)
+{
+	return FBPVariant::FromObject(Variant);
+}
+
+UBPVariant* UBPVariantBpFunctionLib::ToVariantObject(UObject* Outer, const FBPVariant& Variant)
+{
+	return Variant.ToObject(Outer);
+}
+
+TArray<uint8> UBPVariantBpFunctionLib::EncodeVariant(const FBPVariant& Variant)
+{
+	TArray<uint8> Bytes;
+	FBPVariantSerializer::Write(Variant, Bytes);
+	return Bytes;
+}
+
+bool UBPVariantBpFunctionLib::DecodeVariant(const TArray<uint8>& Bytes, FBPVariant& Variant)
+{
+	return FBPVariantSerializer::Read(Bytes, Variant);
+}
+
+TArray<uint8> UBPVariantBpFunctionLib::EncodeVariantObject(const UBPVariant* Variant)
+{
+	TArray<uint8> Bytes;
+	FBPVariantSerializer::Write(Variant, Bytes);
+	return Bytes;
+}
+
+UBPVariant* UBPVariantBpFunctionLib::DecodeVariantObject(UObject* Outer, const TArray<uint8>& Bytes)
+{
+	return FBPVariantSerializer::ReadObject(Outer, Bytes);
+}
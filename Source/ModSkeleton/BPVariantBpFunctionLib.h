@@ -0,0 +1,236 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "BPVariant.h"
+
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "BPVariantBpFunctionLib.generated.h"
+
+/**
+ * Blueprint accessors for the FBPVariant value type, mirroring the UBPVariant API
+ */
+UCLASS()
+class MODSKELETON_API UBPVariantBpFunctionLib : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Type"))
+	static EBPVariantType GetVariantType(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "DebugValue"))
+	static FString GetVariantDebugValue(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsBoolean(bool Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Boolean"))
+	static bool GetVariantAsBoolean(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static bool SetVariantAsBoolean(UPARAM(ref) FBPVariant& Variant, bool Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsInteger(int32 Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Integer"))
+	static int32 GetVariantAsInteger(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static int32 SetVariantAsInteger(UPARAM(ref) FBPVariant& Variant, int32 Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsFloat(float Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Float"))
+	static float GetVariantAsFloat(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static float SetVariantAsFloat(UPARAM(ref) FBPVariant& Variant, float Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsString(const FString& Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "String"))
+	static FString GetVariantAsString(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static FString SetVariantAsString(UPARAM(ref) FBPVariant& Variant, const FString& Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsClass(UClass* Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Class"))
+	static UClass* GetVariantAsClass(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static UClass* SetVariantAsClass(UPARAM(ref) FBPVariant& Variant, UClass* Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsObject(UObject* Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Object"))
+	static UObject* GetVariantAsObject(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static UObject* SetVariantAsObject(UPARAM(ref) FBPVariant& Variant, UObject* Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsArray(const TArray< FBPVariant >& Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Array"))
+	static TArray< FBPVariant > GetVariantAsArray(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static void SetVariantAsArray(UPARAM(ref) FBPVariant& Variant, const TArray< FBPVariant >& Value);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static bool GetVariantArrayElement(const FBPVariant& Variant, int32 Index, FBPVariant& Element);
+
+	/**
+	 * Replace one element of an array variant. Copies of the array keep their elements, and only this level is copied for it.
+	 * Returns false if Variant is not an array or Index is out of range.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static bool SetVariantArrayElement(UPARAM(ref) FBPVariant& Variant, int32 Index, const FBPVariant& Element);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsMap();
+
+	/**
+	 * Map key for an FName. Names are stored as String keys, so they compare case sensitively.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantMapKeyFromName(FName Name);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Num"))
+	static int32 GetVariantMapNum(const FBPVariant& Variant);
+
+	/**
+	 * Returns false if Key is not in the map
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static bool FindVariantMapValue(const FBPVariant& Variant, const FBPVariant& Key, FBPVariant& Value);
+
+	/**
+	 * Add or replace the value under Key. Returns false if Variant is not a map or Key is not a String or Integer.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static bool SetVariantMapValue(UPARAM(ref) FBPVariant& Variant, const FBPVariant& Key, const FBPVariant& Value);
+
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static bool RemoveVariantMapValue(UPARAM(ref) FBPVariant& Variant, const FBPVariant& Key);
+
+	/**
+	 * All entries, Keys[i] -> Values[i]
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static void GetVariantMapEntries(const FBPVariant& Variant, TArray< FBPVariant >& Keys, TArray< FBPVariant >& Values);
+
+	/**
+	 * Packed arrays hold every element in one variant, for bulk data like heightmaps, spawn tables and curves
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsIntArray(const TArray<int32>& Values);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsFloatArray(const TArray<float>& Values);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsBoolArray(const TArray<bool>& Values);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FBPVariant MakeVariantAsVectorArray(const TArray<FVector>& Values);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Integer Array"))
+	static TArray<int32> GetVariantAsIntArray(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Float Array"))
+	static TArray<float> GetVariantAsFloatArray(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Boolean Array"))
+	static TArray<bool> GetVariantAsBoolArray(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Vector Array"))
+	static TArray<FVector> GetVariantAsVectorArray(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "Num"))
+	static int32 GetVariantPackedNum(const FBPVariant& Variant);
+
+	/**
+	 * Sum of an Integer or Float array, or the number of true elements of a Boolean array
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static float SumVariantPacked(const FBPVariant& Variant);
+
+	/**
+	 * Smallest and largest element of an Integer or Float array. Returns false if it is empty.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static bool GetVariantPackedRange(const FBPVariant& Variant, float& Min, float& Max);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static FVector SumVariantVectors(const FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static bool GetVariantVectorBounds(const FBPVariant& Variant, FVector& Min, FVector& Max);
+
+	/**
+	 * Multiply every element of an Integer, Float or Vector array. Integers are rounded.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static bool ScaleVariantPacked(UPARAM(ref) FBPVariant& Variant, float Factor);
+
+	/**
+	 * Variant += Other * Factor, element wise. Returns false unless both are packed arrays of the same type and length.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static bool AddVariantPacked(UPARAM(ref) FBPVariant& Variant, const FBPVariant& Other, float Factor = 1.0f);
+
+	/**
+	 * Convert a UBPVariant (and any nested array elements) to the value type
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant", meta = (CompactNodeTitle = "ToValue"))
+	static FBPVariant ToVariantValue(const UBPVariant* Variant);
+
+	/**
+	 * Convert a value variant back to a UBPVariant, for mods using the object API
+	 */
+	UFUNCTION(BlueprintCallable, Category = "BPVariant", meta = (HidePin = Outer, DefaultToSelf = Outer))
+	static UBPVariant* ToVariantObject(UObject* Outer, const FBPVariant& Variant);
+
+	/**
+	 * Compact binary encoding of a variant, for save games and replays (see FBPVariantSerializer)
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static TArray<uint8> EncodeVariant(const FBPVariant& Variant);
+
+	/**
+	 * Decode bytes written by EncodeVariant or EncodeVariantObject. Returns false if they are malformed.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "BPVariant")
+	static bool DecodeVariant(const TArray<uint8>& Bytes, FBPVariant& Variant);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "BPVariant")
+	static TArray<uint8> EncodeVariantObject(const UBPVariant* Variant);
+
+	/**
+	 * Returns nullptr if Bytes are malformed
+	 */
+	UFUNCTION(BlueprintCallable, Category = "BPVariant", meta = (HidePin = Outer, DefaultToSelf = Outer))
+	static UBPVariant* DecodeVariantObject(UObject* Outer, const TArray<uint8>& Bytes);
+};
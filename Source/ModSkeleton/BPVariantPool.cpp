@@ -0,0 +1,163 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ModSkeleton.h"
+#include "BPVariantPool.h"
+
+UBPVariantPool* UBPVariantPool::ScopedPool = nullptr;
+
+static const ERenameFlags PoolRenameFlags = REN_DontCreateRedirectors | REN_NonTransactional | REN_ForceNoResetLoaders;
+
+UBPVariantPool::UBPVariantPool()
+	: MaxFreeVariants(1024)
+{
+}
+
+UBPVariant* UBPVariantPool::Acquire(UObject* Outer)
+{
+	if (Outer == nullptr)
+	{
+		Outer = this;
+	}
+
+	UBPVariant* Out;
+	if (FreeVariants.Num() > 0)
+	{
+		Out = FreeVariants.Pop(false);
+		Out->bInPool = false;
+		if (Out->GetOuter() != Outer)
+		{
+			Out->Rename(nullptr, Outer, PoolRenameFlags);
+		}
+		++Stats.Hits;
+	}
+	else
+	{
+		Out = NewObject<UBPVariant>(Outer, UBPVariant::StaticClass());
+		++Stats.Misses;
+	}
+
+	if (ScopeStarts.Num() > 0)
+	{
+		ScopedVariants.Add(Out);
+	}
+	return Out;
+}
+
+void UBPVariantPool::Release(UBPVariant* Variant)
+{
+	if (Variant == nullptr || Variant->bInPool)
+	{
+		return;
+	}
+
+	// SetType keeps the string and array allocations around for the next user
+	Variant->SetType(EBPVariantType::VT_None);
+	if (FreeVariants.Num() >= MaxFreeVariants)
+	{
+		++Stats.Discards;
+		return;
+	}
+
+	// Don't let the free list keep the previous owner's package alive
+	if (Variant->GetOuter() != this)
+	{
+		Variant->Rename(nullptr, this, PoolRenameFlags);
+	}
+	Variant->bInPool = true;
+	FreeVariants.Add(Variant);
+	++Stats.Releases;
+}
+
+void UBPVariantPool::BeginScope()
+{
+	check(IsInGameThread());
+	ScopeStarts.Add(ScopedVariants.Num());
+	OuterPools.Add(ScopedPool);
+	ScopedPool = this;
+}
+
+void UBPVariantPool::EndScope(const TArray< UBPVariant* >& Input, const TArray< UBPVariant* >& Result)
+{
+	check(ScopeStarts.Num() > 0);
+	const int32 ScopeStart = ScopeStarts.Pop(false);
+	ScopedPool = OuterPools.Pop(false);
+
+	if (ScopedVariants.Num() == ScopeStart)
+	{
+		return;
+	}
+
+	TSet< UBPVariant* > Reachable;
+	for (UBPVariant* Variant : Input)
+	{
+		MarkReachable(Variant, Reachable);
+	}
+	for (UBPVariant* Variant : Result)
+	{
+		MarkReachable(Variant, Reachable);
+	}
+
+	const bool bHasOuterScope = ScopeStarts.Num() > 0;
+	int32 Kept = ScopeStart;
+	for (int32 i = ScopeStart; i < ScopedVariants.Num(); ++i)
+	{
+		UBPVariant* Variant = ScopedVariants[i];
+		if (!Reachable.Contains(Variant))
+		{
+			Release(Variant);
+		}
+		else if (bHasOuterScope)
+		{
+			ScopedVariants[Kept++] = Variant;
+		}
+	}
+	ScopedVariants.SetNum(Kept, false);
+}
+
+UBPVariantPool* UBPVariantPool::GetScopedPool()
+{
+	return IsInGameThread() ? ScopedPool : nullptr;
+}
+
+FBPVariantPoolStats UBPVariantPool::GetStats() const
+{
+	FBPVariantPoolStats Out = Stats;
+	Out.Free = FreeVariants.Num();
+	return Out;
+}
+
+void UBPVariantPool::MarkReachable(UBPVariant* Variant, TSet< UBPVariant* >& Reachable)
+{
+	if (Variant == nullptr || Reachable.Contains(Variant))
+	{
+		return;
+	}
+	Reachable.Add(Variant);
+	if (Variant->GetType() == EBPVariantType::VT_Array)
+	{
+		for (UBPVariant* Element : Variant->AsArray)
+		{
+			MarkReachable(Element, Reachable);
+		}
+	}
+	else if (Variant->GetType() == EBPVariantType::VT_Map)
+	{
+		for (UBPVariant* Value : Variant->GetMapValues())
+		{
+			MarkReachable(Value, Reachable);
+		}
+	}
+}
@@ -0,0 +1,150 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "BPVariant.h"
+
+#include "UObject/NoExportTypes.h"
+#include "BPVariantPool.generated.h"
+
+/**
+ * Counters for a UBPVariantPool
+ */
+USTRUCT(BlueprintType, Category = "ModSkeleton")
+struct FBPVariantPoolStats
+{
+	GENERATED_BODY()
+
+	FBPVariantPoolStats()
+		: Hits(0)
+		, Misses(0)
+		, Releases(0)
+		, Discards(0)
+		, Free(0)
+	{
+	}
+
+	/**
+	 * Acquires served from the free list
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "BPVariantPoolStats")
+	int32 Hits;
+
+	/**
+	 * Acquires that had to NewObject a fresh variant
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "BPVariantPoolStats")
+	int32 Misses;
+
+	/**
+	 * Variants returned to the free list
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "BPVariantPoolStats")
+	int32 Releases;
+
+	/**
+	 * Released variants left to the garbage collector because the free list was full
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "BPVariantPoolStats")
+	int32 Discards;
+
+	/**
+	 * Variants currently waiting in the free list
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "BPVariantPoolStats")
+	int32 Free;
+};
+
+/**
+ * Recycles UBPVariant objects used for hook IO.
+ *
+ * While a scope is open (the registry opens one around every InvokeHook), the UBPVariant::NewBPVariantAs*
+ * constructors draw from this pool. When the scope ends, every variant acquired inside it that is not
+ * reachable from the invocation's input or result HookIO goes back to the free list.
+ * Don't hold on to temporary variants past the hook invocation that created them - copy them instead.
+ */
+UCLASS()
+class MODSKELETON_API UBPVariantPool : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UBPVariantPool();
+
+	/**
+	 * Take a variant from the free list, or allocate a new one. The variant is reset to VT_None and
+	 * renamed into Outer, so it is owned the same way a variant created outside the pool would be.
+	 * A null Outer leaves it owned by the pool.
+	 */
+	UBPVariant* Acquire(UObject* Outer = nullptr);
+
+	/**
+	 * Return a variant to the free list, moving it back under the pool. Once MaxFreeVariants are waiting,
+	 * further variants are dropped and left to the garbage collector. Nested array elements are not released.
+	 */
+	void Release(UBPVariant* Variant);
+
+	/**
+	 * Upper bound on the free list, so one hook that allocates a burst of variants doesn't pin them forever
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeleton")
+	int32 MaxFreeVariants;
+
+	/**
+	 * Start tracking every variant acquired until the matching EndScope
+	 */
+	void BeginScope();
+
+	/**
+	 * Release every variant acquired since the matching BeginScope that is not reachable from Input or Result.
+	 * Reachable variants are handed to the enclosing scope, if there is one.
+	 */
+	void EndScope(const TArray< UBPVariant* >& Input, const TArray< UBPVariant* >& Result);
+
+	/**
+	 * Pool with the innermost open scope, or nullptr when no hook invocation is in progress
+	 */
+	static UBPVariantPool* GetScopedPool();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeleton")
+	FBPVariantPoolStats GetStats() const;
+
+private:
+	UPROPERTY()
+	TArray< UBPVariant* > FreeVariants;
+
+	/**
+	 * Variants acquired inside open scopes, innermost scope last
+	 */
+	UPROPERTY()
+	TArray< UBPVariant* > ScopedVariants;
+
+	/**
+	 * ScopedVariants.Num() at each open BeginScope
+	 */
+	TArray< int32 > ScopeStarts;
+
+	/**
+	 * The pool that was scoped before each of our open scopes
+	 */
+	TArray< UBPVariantPool* > OuterPools;
+
+	FBPVariantPoolStats Stats;
+
+	static UBPVariantPool* ScopedPool;
+
+	static void MarkReachable(UBPVariant* Variant, TSet< UBPVariant* >& Reachable);
+};
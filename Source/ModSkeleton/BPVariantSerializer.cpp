@@ -0,0 +1,663 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ModSkeleton.h"
+#include "BPVariantSerializer.h"
+
+#include "Misc/StringAssetReference.h"
+
+namespace BPVariantSerializer
+{
+	const uint8 Magic[4] = { 'M', 'S', 'K', 'V' };
+
+	static uint32 ZigZagEncode(int32 Value)
+	{
+		return (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+	}
+
+	static int32 ZigZagDecode(uint32 Value)
+	{
+		return static_cast<int32>((Value >> 1) ^ (~(Value & 1) + 1));
+	}
+
+	static void WriteVarint(TArray<uint8>& Out, uint32 Value)
+	{
+		while (Value >= 0x80)
+		{
+			Out.Add(static_cast<uint8>(Value | 0x80));
+			Value >>= 7;
+		}
+		Out.Add(static_cast<uint8>(Value));
+	}
+
+	static void WriteFloat(TArray<uint8>& Out, float Value)
+	{
+		uint32 Bits;
+		FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+		const int32 Start = Out.AddUninitialized(4);
+		uint8* Dest = Out.GetData() + Start;
+		Dest[0] = static_cast<uint8>(Bits);
+		Dest[1] = static_cast<uint8>(Bits >> 8);
+		Dest[2] = static_cast<uint8>(Bits >> 16);
+		Dest[3] = static_cast<uint8>(Bits >> 24);
+	}
+
+	static void WriteString(TArray<uint8>& Out, const FString& Value)
+	{
+		const int32 Len = Value.Len();
+		const int32 Utf8Len = Len > 0 ? FTCHARToUTF8_Convert::ConvertedLength(*Value, Len) : 0;
+		WriteVarint(Out, Utf8Len);
+		if (Utf8Len > 0)
+		{
+			// convert straight into the output, no intermediate UTF-8 buffer
+			const int32 Start = Out.AddUninitialized(Utf8Len);
+			ANSICHAR* Dest = reinterpret_cast<ANSICHAR*>(Out.GetData() + Start);
+			FTCHARToUTF8_Convert::Convert(Dest, Utf8Len, *Value, Len);
+		}
+	}
+
+	static void WriteReference(TArray<uint8>& Out, const UObject* Object)
+	{
+		WriteString(Out, Object != nullptr ? Object->GetPathName() : FString());
+	}
+
+	static void WriteFloats(TArray<uint8>& Out, const float* Values, int32 Num)
+	{
+#if PLATFORM_LITTLE_ENDIAN
+		Out.Append(reinterpret_cast<const uint8*>(Values), Num * sizeof(float));
+#else
+		for (int32 i = 0; i < Num; ++i)
+		{
+			WriteFloat(Out, Values[i]);
+		}
+#endif
+	}
+
+	static void WritePacked(TArray<uint8>& Out, EBPVariantType Type, const FBPVariantPackedArray& Packed)
+	{
+		const int32 Num = Packed.Num(Type);
+		WriteVarint(Out, Num);
+		switch (Type)
+		{
+		case EBPVariantType::VT_IntArray:
+			// the same 4 byte layout as floats, so both copy straight through
+			static_assert(sizeof(int32) == sizeof(float), "Integer arrays are written like float arrays");
+			WriteFloats(Out, reinterpret_cast<const float*>(Packed.Ints.GetData()), Num);
+			break;
+		case EBPVariantType::VT_FloatArray:
+			WriteFloats(Out, Packed.Floats.GetData(), Num);
+			break;
+		case EBPVariantType::VT_VectorArray:
+			WriteFloats(Out, reinterpret_cast<const float*>(Packed.Vectors.GetData()), Num * 3);
+			break;
+		case EBPVariantType::VT_BoolArray:
+		{
+			const int32 Start = Out.AddZeroed(FMath::DivideAndRoundUp(Num, 8));
+			uint8* Dest = Out.GetData() + Start;
+			for (TConstSetBitIterator<> It(Packed.Bools); It; ++It)
+			{
+				Dest[It.GetIndex() / 8] |= 1 << (It.GetIndex() % 8);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	static void WriteHeader(TArray<uint8>& Out)
+	{
+		const uint8 Version = FBPVariantSerializer::Version;
+		Out.Append(Magic, ARRAY_COUNT(Magic));
+		Out.Add(Version);
+	}
+
+	static void WriteValue(TArray<uint8>& Out, const FBPVariant& Value)
+	{
+		const EBPVariantType Type = Value.GetType();
+		Out.Add(static_cast<uint8>(Type));
+		switch (Type)
+		{
+		case EBPVariantType::VT_Boolean:
+			Out.Add(Value.GetAsBooleanUnchecked() ? 1 : 0);
+			break;
+		case EBPVariantType::VT_Integer:
+			WriteVarint(Out, ZigZagEncode(Value.GetAsIntegerUnchecked()));
+			break;
+		case EBPVariantType::VT_Float:
+			WriteFloat(Out, Value.GetAsFloatUnchecked());
+			break;
+		case EBPVariantType::VT_String:
+			WriteString(Out, Value.GetAsStringUnchecked());
+			break;
+		case EBPVariantType::VT_Class:
+			WriteReference(Out, Value.GetAsClassUnchecked());
+			break;
+		case EBPVariantType::VT_Object:
+			WriteReference(Out, Value.GetAsObjectUnchecked());
+			break;
+		case EBPVariantType::VT_Array:
+		{
+			const TArray< FBPVariant >& Elements = Value.GetAsArrayUnchecked();
+			WriteVarint(Out, Elements.Num());
+			for (const FBPVariant& Element : Elements)
+			{
+				WriteValue(Out, Element);
+			}
+			break;
+		}
+		case EBPVariantType::VT_Map:
+		{
+			const FBPVariantMap& Map = Value.GetAsMap();
+			WriteVarint(Out, Map.Entries.Num());
+			for (const auto& Entry : Map.Entries)
+			{
+				WriteValue(Out, Entry.Key);
+				WriteValue(Out, Entry.Value);
+			}
+			break;
+		}
+		case EBPVariantType::VT_IntArray:
+		case EBPVariantType::VT_FloatArray:
+		case EBPVariantType::VT_BoolArray:
+		case EBPVariantType::VT_VectorArray:
+			WritePacked(Out, Type, Value.GetPacked());
+			break;
+		default:
+		case EBPVariantType::VT_None:
+			break;
+		}
+	}
+
+	static void WriteValue(TArray<uint8>& Out, const UBPVariant* Variant)
+	{
+		// a null element is written as None, like FBPVariant::FromObject treats it
+		const EBPVariantType Type = Variant != nullptr ? Variant->GetType() : EBPVariantType::VT_None;
+		Out.Add(static_cast<uint8>(Type));
+		switch (Type)
+		{
+		case EBPVariantType::VT_Boolean:
+			Out.Add(Variant->GetAsBooleanUnchecked() ? 1 : 0);
+			break;
+		case EBPVariantType::VT_Integer:
+			WriteVarint(Out, ZigZagEncode(Variant->GetAsIntegerUnchecked()));
+			break;
+		case EBPVariantType::VT_Float:
+			WriteFloat(Out, Variant->GetAsFloatUnchecked());
+			break;
+		case EBPVariantType::VT_String:
+			WriteString(Out, Variant->GetAsStringUnchecked());
+			break;
+		case EBPVariantType::VT_Class:
+			WriteReference(Out, Variant->GetAsClassUnchecked());
+			break;
+		case EBPVariantType::VT_Object:
+			WriteReference(Out, Variant->GetAsObjectUnchecked());
+			break;
+		case EBPVariantType::VT_Array:
+			WriteVarint(Out, Variant->AsArray.Num());
+			for (const UBPVariant* Element : Variant->AsArray)
+			{
+				WriteValue(Out, Element);
+			}
+			break;
+		case EBPVariantType::VT_Map:
+		{
+			const TArray< FBPVariant >& Keys = Variant->GetMapKeys();
+			const TArray< UBPVariant* >& Values = Variant->GetMapValues();
+			WriteVarint(Out, Keys.Num());
+			for (int32 i = 0; i < Keys.Num(); ++i)
+			{
+				WriteValue(Out, Keys[i]);
+				WriteValue(Out, Values[i]);
+			}
+			break;
+		}
+		case EBPVariantType::VT_IntArray:
+		case EBPVariantType::VT_FloatArray:
+		case EBPVariantType::VT_BoolArray:
+		case EBPVariantType::VT_VectorArray:
+			WritePacked(Out, Type, Variant->GetPacked());
+			break;
+		default:
+		case EBPVariantType::VT_None:
+			break;
+		}
+	}
+}
+
+/**
+ * Bounds checked cursor over the encoded bytes
+ */
+struct FBPVariantSerializer::FReader
+{
+	FReader(const uint8* Bytes, int32 NumBytes)
+		: Cursor(Bytes)
+		, End(Bytes + FMath::Max(NumBytes, 0))
+		, Depth(0)
+	{
+	}
+
+	int32 Remaining() const
+	{
+		return static_cast<int32>(End - Cursor);
+	}
+
+	bool ReadByte(uint8& OutByte)
+	{
+		if (Cursor >= End)
+		{
+			return false;
+		}
+		OutByte = *Cursor++;
+		return true;
+	}
+
+	bool ReadVarint(uint32& OutValue)
+	{
+		OutValue = 0;
+		for (int32 Shift = 0; Shift < 35; Shift += 7)
+		{
+			uint8 Byte;
+			if (!ReadByte(Byte))
+			{
+				return false;
+			}
+			OutValue |= static_cast<uint32>(Byte & 0x7F) << Shift;
+			if ((Byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ReadFloat(float& OutValue)
+	{
+		if (Remaining() < 4)
+		{
+			return false;
+		}
+		const uint32 Bits = Cursor[0] | (Cursor[1] << 8) | (Cursor[2] << 16) | (static_cast<uint32>(Cursor[3]) << 24);
+		FMemory::Memcpy(&OutValue, &Bits, sizeof(OutValue));
+		Cursor += 4;
+		return true;
+	}
+
+	bool ReadFloats(float* OutValues, int32 Num)
+	{
+		if (Remaining() / 4 < Num)
+		{
+			return false;
+		}
+#if PLATFORM_LITTLE_ENDIAN
+		FMemory::Memcpy(OutValues, Cursor, Num * sizeof(float));
+		Cursor += Num * sizeof(float);
+#else
+		for (int32 i = 0; i < Num; ++i)
+		{
+			ReadFloat(OutValues[i]);
+		}
+#endif
+		return true;
+	}
+
+	const uint8* Cursor;
+	const uint8* End;
+	int32 Depth;
+
+	/**
+	 * Reused for every reference in the payload
+	 */
+	FString ScratchPath;
+};
+
+void FBPVariantSerializer::Write(const FBPVariant& Value, TArray<uint8>& OutBytes)
+{
+	BPVariantSerializer::WriteHeader(OutBytes);
+	BPVariantSerializer::WriteValue(OutBytes, Value);
+}
+
+void FBPVariantSerializer::Write(const UBPVariant* Variant, TArray<uint8>& OutBytes)
+{
+	BPVariantSerializer::WriteHeader(OutBytes);
+	BPVariantSerializer::WriteValue(OutBytes, Variant);
+}
+
+void FBPVariantSerializer::WriteArray(const TArray< FBPVariant >& Values, TArray<uint8>& OutBytes)
+{
+	BPVariantSerializer::WriteHeader(OutBytes);
+	OutBytes.Add(static_cast<uint8>(EBPVariantType::VT_Array));
+	BPVariantSerializer::WriteVarint(OutBytes, Values.Num());
+	for (const FBPVariant& Value : Values)
+	{
+		BPVariantSerializer::WriteValue(OutBytes, Value);
+	}
+}
+
+void FBPVariantSerializer::WriteArray(const TArray< UBPVariant* >& Variants, TArray<uint8>& OutBytes)
+{
+	BPVariantSerializer::WriteHeader(OutBytes);
+	OutBytes.Add(static_cast<uint8>(EBPVariantType::VT_Array));
+	BPVariantSerializer::WriteVarint(OutBytes, Variants.Num());
+	for (const UBPVariant* Variant : Variants)
+	{
+		BPVariantSerializer::WriteValue(OutBytes, Variant);
+	}
+}
+
+bool FBPVariantSerializer::Read(const uint8* Bytes, int32 NumBytes, FBPVariant& OutValue, int32* OutBytesRead)
+{
+	FReader Reader(Bytes, NumBytes);
+	if (!ReadHeader(Reader) || !ReadValue(Reader, OutValue))
+	{
+		OutValue.SetType(EBPVariantType::VT_None);
+		return false;
+	}
+
+	if (OutBytesRead != nullptr)
+	{
+		*OutBytesRead = static_cast<int32>(Reader.Cursor - Bytes);
+	}
+	return true;
+}
+
+bool FBPVariantSerializer::Read(const TArray<uint8>& Bytes, FBPVariant& OutValue)
+{
+	return Read(Bytes.GetData(), Bytes.Num(), OutValue);
+}
+
+bool FBPVariantSerializer::ReadArray(const TArray<uint8>& Bytes, TArray< FBPVariant >& OutValues)
+{
+	FReader Reader(Bytes.GetData(), Bytes.Num());
+	uint8 Tag;
+	if (!ReadHeader(Reader) || !Reader.ReadByte(Tag) || Tag != static_cast<uint8>(EBPVariantType::VT_Array) || !ReadArrayElements(Reader, OutValues))
+	{
+		OutValues.Reset();
+		return false;
+	}
+	return true;
+}
+
+UBPVariant* FBPVariantSerializer::ReadObject(UObject* Outer, const TArray<uint8>& Bytes)
+{
+	FBPVariant Value;
+	if (!Read(Bytes, Value))
+	{
+		return nullptr;
+	}
+	return Value.ToObject(Outer);
+}
+
+bool FBPVariantSerializer::ReadHeader(FReader& Reader)
+{
+	const int32 MagicSize = ARRAY_COUNT(BPVariantSerializer::Magic);
+	if (Reader.Remaining() < MagicSize + 1 || FMemory::Memcmp(Reader.Cursor, BPVariantSerializer::Magic, MagicSize) != 0)
+	{
+		return false;
+	}
+	Reader.Cursor += MagicSize;
+
+	uint8 DataVersion;
+	Reader.ReadByte(DataVersion);
+	if (DataVersion != Version)
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Cannot read BPVariant data version %d, expected %d"), DataVersion, Version);
+		return false;
+	}
+	return true;
+}
+
+bool FBPVariantSerializer::ReadValue(FReader& Reader, FBPVariant& OutValue)
+{
+	uint8 Tag;
+	if (!Reader.ReadByte(Tag) || Tag > static_cast<uint8>(EBPVariantType::VT_VectorArray))
+	{
+		return false;
+	}
+
+	// Keeping the string / array storage of a value that already has this type is what lets a warm value decode without allocating
+	const EBPVariantType Type = static_cast<EBPVariantType>(Tag);
+	if (OutValue.Type != Type)
+	{
+		OutValue.SetType(Type);
+	}
+
+	switch (Type)
+	{
+	case EBPVariantType::VT_Boolean:
+	{
+		uint8 Byte;
+		if (!Reader.ReadByte(Byte) || Byte > 1)
+		{
+			return false;
+		}
+		OutValue.StoreUnion.StoreBool = Byte != 0;
+		return true;
+	}
+	case EBPVariantType::VT_Integer:
+	{
+		uint32 Encoded;
+		if (!Reader.ReadVarint(Encoded))
+		{
+			return false;
+		}
+		OutValue.StoreUnion.StoreInt32 = BPVariantSerializer::ZigZagDecode(Encoded);
+		return true;
+	}
+	case EBPVariantType::VT_Float:
+		return Reader.ReadFloat(OutValue.StoreUnion.StoreFloat);
+	case EBPVariantType::VT_String:
+		return ReadString(Reader, OutValue.StoreString);
+	case EBPVariantType::VT_Class:
+	{
+		UObject* Object;
+		if (!ReadReference(Reader, Object))
+		{
+			return false;
+		}
+		OutValue.StoreObject = Cast<UClass>(Object);
+		return true;
+	}
+	case EBPVariantType::VT_Object:
+		return ReadReference(Reader, OutValue.StoreObject);
+	case EBPVariantType::VT_Array:
+	{
+		if (Reader.Depth >= MaxDepth)
+		{
+			return false;
+		}
+		++Reader.Depth;
+		const bool bRead = ReadArrayElements(Reader, OutValue.MutableArray());
+		--Reader.Depth;
+		return bRead;
+	}
+	case EBPVariantType::VT_Map:
+	{
+		if (Reader.Depth >= MaxDepth)
+		{
+			return false;
+		}
+		++Reader.Depth;
+		const bool bRead = ReadMapEntries(Reader, OutValue);
+		--Reader.Depth;
+		return bRead;
+	}
+	case EBPVariantType::VT_IntArray:
+	case EBPVariantType::VT_FloatArray:
+	case EBPVariantType::VT_BoolArray:
+	case EBPVariantType::VT_VectorArray:
+		return ReadPackedArray(Reader, OutValue);
+	default:
+	case EBPVariantType::VT_None:
+		return true;
+	}
+}
+
+bool FBPVariantSerializer::ReadArrayElements(FReader& Reader, TArray< FBPVariant >& OutValues)
+{
+	// every element takes at least one byte, so a larger count is corrupt data rather than something to allocate for
+	uint32 Count;
+	if (!Reader.ReadVarint(Count) || Count > static_cast<uint32>(Reader.Remaining()))
+	{
+		return false;
+	}
+
+	OutValues.SetNum(Count, false);
+	for (uint32 i = 0; i < Count; ++i)
+	{
+		if (!ReadValue(Reader, OutValues[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FBPVariantSerializer::ReadMapEntries(FReader& Reader, FBPVariant& OutMap)
+{
+	// every entry takes at least two bytes
+	uint32 Count;
+	if (!Reader.ReadVarint(Count) || Count > static_cast<uint32>(Reader.Remaining() / 2))
+	{
+		return false;
+	}
+
+	FBPVariantMap& Map = OutMap.MutableMap();
+	Map.Entries.Reset();
+	Map.Entries.Reserve(Count);
+	FBPVariant Key;
+	for (uint32 i = 0; i < Count; ++i)
+	{
+		if (!ReadValue(Reader, Key) || !FBPVariant::IsValidMapKey(Key) || !ReadValue(Reader, Map.Entries.FindOrAdd(Key)))
+		{
+			return false;
+		}
+	}
+
+	// a repeated key is malformed data, not something to silently merge
+	return Map.Entries.Num() == static_cast<int32>(Count);
+}
+
+bool FBPVariantSerializer::ReadPackedArray(FReader& Reader, FBPVariant& OutArray)
+{
+	uint32 Count;
+	if (!Reader.ReadVarint(Count) || Count > static_cast<uint32>(MAX_int32 / 3))
+	{
+		return false;
+	}
+	const int32 Num = static_cast<int32>(Count);
+
+	// an unchanged type kept the storage, so a warm value is refilled in place
+	FBPVariantPackedArray& Packed = OutArray.MutablePacked();
+	switch (OutArray.Type)
+	{
+	case EBPVariantType::VT_IntArray:
+		if (Reader.Remaining() / 4 < Num)
+		{
+			return false;
+		}
+		Packed.Ints.SetNumUninitialized(Num, false);
+		return Reader.ReadFloats(reinterpret_cast<float*>(Packed.Ints.GetData()), Num);
+	case EBPVariantType::VT_FloatArray:
+		if (Reader.Remaining() / 4 < Num)
+		{
+			return false;
+		}
+		Packed.Floats.SetNumUninitialized(Num, false);
+		return Reader.ReadFloats(Packed.Floats.GetData(), Num);
+	case EBPVariantType::VT_VectorArray:
+		if (Reader.Remaining() / 12 < Num)
+		{
+			return false;
+		}
+		Packed.Vectors.SetNumUninitialized(Num, false);
+		return Reader.ReadFloats(reinterpret_cast<float*>(Packed.Vectors.GetData()), Num * 3);
+	case EBPVariantType::VT_BoolArray:
+	{
+		const int32 NumBytes = FMath::DivideAndRoundUp(Num, 8);
+		if (Reader.Remaining() < NumBytes)
+		{
+			return false;
+		}
+		Packed.Bools.Init(false, Num);
+		uint32* Words = Packed.Bools.GetData();
+		for (int32 i = 0; i < NumBytes; ++i)
+		{
+			Words[i / 4] |= static_cast<uint32>(Reader.Cursor[i]) << (8 * (i % 4));
+		}
+		Reader.Cursor += NumBytes;
+		// clear anything set past the end, so the array compares and hashes like one built bit by bit
+		if (Num % 32 != 0)
+		{
+			Words[Num / 32] &= (1u << (Num % 32)) - 1;
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+bool FBPVariantSerializer::ReadString(FReader& Reader, FString& OutString)
+{
+	uint32 ByteCount;
+	if (!Reader.ReadVarint(ByteCount) || ByteCount > static_cast<uint32>(Reader.Remaining()))
+	{
+		return false;
+	}
+
+	const ANSICHAR* Source = reinterpret_cast<const ANSICHAR*>(Reader.Cursor);
+	Reader.Cursor += ByteCount;
+	if (ByteCount == 0)
+	{
+		OutString.Reset();
+		return true;
+	}
+
+	// convert straight into the string's own buffer, which keeps its capacity between reads
+	const int32 Len = FUTF8ToTCHAR_Convert::ConvertedLength(Source, ByteCount);
+	TArray<TCHAR>& Chars = OutString.GetCharArray();
+	Chars.SetNumUninitialized(Len + 1, false);
+	FUTF8ToTCHAR_Convert::Convert(Chars.GetData(), Len, Source, ByteCount);
+	Chars[Len] = 0;
+	return true;
+}
+
+bool FBPVariantSerializer::ReadReference(FReader& Reader, UObject*& OutObject)
+{
+	OutObject = nullptr;
+	if (!ReadString(Reader, Reader.ScratchPath))
+	{
+		return false;
+	}
+	if (Reader.ScratchPath.IsEmpty())
+	{
+		return true;
+	}
+
+	// A reference that no longer resolves reads as nullptr rather than failing the whole payload
+	FStringAssetReference Reference(Reader.ScratchPath);
+	OutObject = Reference.ResolveObject();
+	if (OutObject == nullptr && IsInGameThread())
+	{
+		OutObject = Reference.TryLoad();
+	}
+	if (OutObject == nullptr)
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("BPVariant data references %s, which could not be found"), *Reader.ScratchPath);
+	}
+	return true;
+}
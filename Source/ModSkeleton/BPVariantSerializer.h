@@ -0,0 +1,87 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "BPVariant.h"
+
+/**
+ * Compact, versioned binary encoding of BPVariant trees, for save games and record / replay of hook payloads.
+ *
+ * Layout: "MSKV", a version byte, then one value. Each value is a type byte followed by
+ *   Boolean        - one byte
+ *   Integer        - zigzag varint
+ *   Float          - 4 bytes, little endian
+ *   String         - varint byte count, UTF-8
+ *   Class / Object - path name as a String, empty for nullptr. Resolved (and loaded on the game thread) when read.
+ *   Array          - varint element count, then each element
+ *   Map            - varint entry count, then each key (a String or Integer value) followed by its value
+ *   Integer / Float / Vector Array - varint element count, then the raw elements as 4 byte little endian values
+ *   Boolean Array  - varint element count, then the bits, 8 per byte, lowest first
+ *
+ * FBPVariant and UBPVariant trees holding the same values encode to the same bytes, except that map entries
+ * are written in the order each representation happens to hold them.
+ */
+struct MODSKELETON_API FBPVariantSerializer
+{
+	static const uint8 Version = 1;
+
+	/**
+	 * Nesting deeper than this is rejected when reading, so malformed data cannot exhaust the stack
+	 */
+	static const int32 MaxDepth = 256;
+
+	/**
+	 * Append the encoding of one value to OutBytes
+	 */
+	static void Write(const FBPVariant& Value, TArray<uint8>& OutBytes);
+	static void Write(const UBPVariant* Variant, TArray<uint8>& OutBytes);
+
+	/**
+	 * Append the encoding of a HookIO array, as a single VT_Array value
+	 */
+	static void WriteArray(const TArray< FBPVariant >& Values, TArray<uint8>& OutBytes);
+	static void WriteArray(const TArray< UBPVariant* >& Variants, TArray<uint8>& OutBytes);
+
+	/**
+	 * Decode into OutValue, reusing the string and array storage it (and its nested elements) already has,
+	 * so decoding repeatedly into the same value does not allocate once it is warm.
+	 * Returns false, leaving OutValue as None, for malformed or truncated data or an unknown version.
+	 * OutBytesRead, if given, receives the size of the encoding.
+	 */
+	static bool Read(const uint8* Bytes, int32 NumBytes, FBPVariant& OutValue, int32* OutBytesRead = nullptr);
+	static bool Read(const TArray<uint8>& Bytes, FBPVariant& OutValue);
+
+	/**
+	 * Decode a HookIO array written by WriteArray, reusing the elements already in OutValues
+	 */
+	static bool ReadArray(const TArray<uint8>& Bytes, TArray< FBPVariant >& OutValues);
+
+	/**
+	 * Decode into a new UBPVariant tree, or nullptr on failure
+	 */
+	static UBPVariant* ReadObject(UObject* Outer, const TArray<uint8>& Bytes);
+
+private:
+	struct FReader;
+
+	static bool ReadHeader(FReader& Reader);
+	static bool ReadValue(FReader& Reader, FBPVariant& OutValue);
+	static bool ReadArrayElements(FReader& Reader, TArray< FBPVariant >& OutValues);
+	static bool ReadMapEntries(FReader& Reader, FBPVariant& OutMap);
+	static bool ReadPackedArray(FReader& Reader, FBPVariant& OutArray);
+	static bool ReadString(FReader& Reader, FString& OutString);
+	static bool ReadReference(FReader& Reader, UObject*& OutObject);
+};
@@ -18,10 +18,13 @@ public class ModSkeleton : ModuleRules
 {
 	public ModSkeleton(TargetInfo Target)
 	{
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "UMG", "PakFile"});
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "UMG", "PakFile", "Projects", "Json"});
 
 		PrivateDependencyModuleNames.AddRange(new string[] {  });
 
+		// Optional: used to watch Content/Paks for new mods when the module is available, which is not the case in every build
+		PrivateIncludePathModuleNames.Add("DirectoryWatcher");
+
 		// Uncomment if you are using Slate UI
 		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
 		
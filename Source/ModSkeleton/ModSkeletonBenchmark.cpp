@@ -0,0 +1,1028 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ModSkeleton.h"
+#include "ModSkeletonProfiler.h"
+
+#if MODSKELETON_PROFILING
+
+#include "ModSkeletonRegistry.h"
+#include "BPVariantSerializer.h"
+#include "ModSkeletonPakLayer.h"
+#include "ModSkeletonModGraph.h"
+#include "ModSkeletonBenchmarkPlugin.h"
+
+#include "Async/Async.h"
+
+/**
+ * Registers a stand-in mod whose only plugin was created in memory, so UnloadMod can release it like one loaded from a pak
+ */
+struct FModSkeletonBenchmarkRegistryAccess
+{
+	static void AddMod(UModSkeletonRegistry* Registry, const FString& ModName, UObject* Plugin)
+	{
+		const FName ObjectPath(*Plugin->GetPathName());
+		FModSkeletonLoadedMod& Mod = Registry->LoadedMods.Add(ModName);
+		Mod.RootPath = TEXT("/") + ModName + TEXT("/");
+		Mod.ContentPath = FPaths::GameSavedDir() / TEXT("ModSkeleton") / ModName / TEXT("Content/");
+		Mod.PluginObjectPaths.Add(ObjectPath);
+		FPackageName::RegisterMountPoint(Mod.RootPath, Mod.ContentPath);
+		Registry->LoadedPlugins.Add(ObjectPath, Plugin);
+		Registry->LoadedPluginList.Add(Plugin);
+	}
+
+	static int32 GetNumRetiredSnapshots(const UModSkeletonRegistry* Registry)
+	{
+		return Registry->DispatchSnapshots.GetNumRetired();
+	}
+};
+
+namespace ModSkeletonBenchmark
+{
+	/**
+	 * Stand-in for handler work that the optimizer cannot remove and that scales with cores, not memory bandwidth
+	 */
+	static void SpinFor(double Seconds)
+	{
+		const double End = FPlatformTime::Seconds() + Seconds;
+		while (FPlatformTime::Seconds() < End)
+		{
+		}
+	}
+
+	static double TimeBroadcast(UModSkeletonRegistry* Registry, const FModSkeletonHookHandle& Hook, int32 Iterations)
+	{
+		TArray< FBPVariant > HookIO;
+		HookIO.AddDefaulted();
+		HookIO[0].SetAsInteger(0);
+
+		const double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			Registry->InvokeHookBroadcastByHandle(Hook, HookIO);
+		}
+		return FPlatformTime::Seconds() - Start;
+	}
+
+	static void ParallelBroadcast(const TArray<FString>& Args)
+	{
+		const int32 NumHandlers = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 32;
+		const double WorkSeconds = (Args.Num() > 1 ? FMath::Max(0.f, FCString::Atof(*Args[1])) : 200.f) / 1000000.0;
+		const int32 Iterations = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 20;
+
+		// A throwaway registry, so the benchmark hooks and handlers stay out of the game's
+		UModSkeletonRegistry* Registry = NewObject<UModSkeletonRegistry>(GetTransientPackage());
+
+		FModSkeletonHookDescription Description;
+		Description.HookDescription = TEXT("ModSkeleton.Benchmark.ParallelBroadcast");
+		Description.HookName = TEXT("ModSkeletonBenchmarkSerial");
+		const FModSkeletonHookHandle SerialHook = Registry->InstallHook(Description);
+		Description.HookName = TEXT("ModSkeletonBenchmarkParallel");
+		Description.ParallelBroadcast = true;
+		const FModSkeletonHookHandle ParallelHook = Registry->InstallHook(Description);
+
+		TFunction<void(const FString&, TArray< FBPVariant >&)> Handler = [WorkSeconds](const FString& HookName, TArray< FBPVariant >& HookIO)
+		{
+			SpinFor(WorkSeconds);
+			HookIO[0].SetAsInteger(HookIO[0].GetAsInteger() + 1);
+		};
+		for (int32 i = 0; i < NumHandlers; ++i)
+		{
+			Registry->ConnectNativeHook(SerialHook, 0, Handler);
+			Registry->ConnectNativeHook(ParallelHook, 0, Handler);
+		}
+
+		// warm up the task graph workers before measuring
+		TimeBroadcast(Registry, ParallelHook, 1);
+
+		const double SerialSeconds = TimeBroadcast(Registry, SerialHook, Iterations);
+		const double ParallelSeconds = TimeBroadcast(Registry, ParallelHook, Iterations);
+
+		UE_LOG(ModSkeletonLog, Log, TEXT("ParallelBroadcast benchmark: %d native handlers x %.0fus, %d iterations, %d task graph workers"),
+			NumHandlers, WorkSeconds * 1000000.0, Iterations, FTaskGraphInterface::Get().GetNumWorkerThreads());
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - serial:   %.3fms per broadcast"), SerialSeconds * 1000.0 / Iterations);
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - parallel: %.3fms per broadcast (%.2fx)"), ParallelSeconds * 1000.0 / Iterations, SerialSeconds / FMath::Max(ParallelSeconds, SMALL_NUMBER));
+	}
+
+	/**
+	 * Nested payload mixing every type. Every fourth element of an array is another array and every eighth a map, down to Depth.
+	 */
+	static void BuildPayload(FBPVariant& Out, int32 Breadth, int32 Depth, int32& Counter)
+	{
+		TArray< FBPVariant >& Elements = Out.SetAsArray();
+		Elements.SetNum(Breadth);
+		for (int32 i = 0; i < Breadth; ++i)
+		{
+			const int32 Seed = Counter++;
+			switch (i % 8)
+			{
+			case 0:
+				if (Depth > 0)
+				{
+					BuildPayload(Elements[i], Breadth, Depth - 1, Counter);
+				}
+				break;
+			case 1:
+				Elements[i].SetAsBoolean((Seed & 1) != 0);
+				break;
+			case 2:
+				Elements[i].SetAsInteger(Seed * 7919 - 1000000);
+				break;
+			case 3:
+				Elements[i].SetAsFloat(Seed * 0.25f);
+				break;
+			case 4:
+				if (Depth > 0)
+				{
+					BuildPayload(Elements[i], Breadth, Depth - 1, Counter);
+				}
+				else
+				{
+					Elements[i].SetAsString(FString::Printf(TEXT("Element %d \u00e9\u6f22"), Seed));
+				}
+				break;
+			case 5:
+				Elements[i].SetAsClass(UBPVariant::StaticClass());
+				break;
+			case 6:
+				Elements[i].SetAsObject(GetTransientPackage());
+				break;
+			default:
+				if (Depth > 0)
+				{
+					FBPVariant& Map = Elements[i];
+					Map.SetAsMap();
+					FBPVariant Key;
+					for (int32 Entry = 0; Entry < Breadth; ++Entry)
+					{
+						if (Entry % 2 == 0)
+						{
+							Key.SetAsString(FString::Printf(TEXT("Key_%d"), Entry));
+						}
+						else
+						{
+							Key.SetAsInteger(Entry);
+						}
+						Map.FindOrAddMapValue(Key).SetAsInteger(Counter++);
+					}
+				}
+				else
+				{
+					Elements[i].SetAsString(FString::Printf(TEXT("Item_%d"), Seed));
+				}
+				break;
+			}
+		}
+	}
+
+	static bool Check(bool bCondition, const TCHAR* What)
+	{
+		if (!bCondition)
+		{
+			UE_LOG(ModSkeletonLog, Error, TEXT(" - FAILED: %s"), What);
+		}
+		return bCondition;
+	}
+
+	static void Serialization(const TArray<FString>& Args)
+	{
+		const int32 Breadth = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 16;
+		const int32 Depth = Args.Num() > 1 ? FMath::Max(0, FCString::Atoi(*Args[1])) : 3;
+		const int32 Iterations = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 20;
+
+		FBPVariant Payload;
+		int32 Elements = 0;
+		BuildPayload(Payload, Breadth, Depth, Elements);
+
+		// Round trips
+		bool bPassed = true;
+		TArray<uint8> Bytes;
+		FBPVariantSerializer::Write(Payload, Bytes);
+
+		FBPVariant Decoded;
+		bPassed = Check(FBPVariantSerializer::Read(Bytes, Decoded) && Decoded == Payload, TEXT("value round trip")) && bPassed;
+		bPassed = Check(FBPVariantSerializer::Read(Bytes, Decoded) && Decoded == Payload, TEXT("decode into a warm value")) && bPassed;
+
+		UBPVariant* Object = Payload.ToObject(GetTransientPackage());
+		TArray<uint8> ObjectBytes;
+		FBPVariantSerializer::Write(Object, ObjectBytes);
+		bPassed = Check(ObjectBytes == Bytes, TEXT("UBPVariant encodes to the same bytes as FBPVariant")) && bPassed;
+		UBPVariant* DecodedObject = FBPVariantSerializer::ReadObject(GetTransientPackage(), Bytes);
+		bPassed = Check(DecodedObject != nullptr && DecodedObject->StructurallyEquals(Object), TEXT("UBPVariant round trip")) && bPassed;
+
+		TArray< FBPVariant > HookIO;
+		HookIO.Add(Payload);
+		HookIO.Add(Decoded);
+		TArray<uint8> HookIOBytes;
+		FBPVariantSerializer::WriteArray(HookIO, HookIOBytes);
+		TArray< FBPVariant > DecodedHookIO;
+		bPassed = Check(FBPVariantSerializer::ReadArray(HookIOBytes, DecodedHookIO) && DecodedHookIO == HookIO, TEXT("HookIO array round trip")) && bPassed;
+
+		bool bRejectedTruncated = true;
+		for (int32 Length = 0; Length < Bytes.Num(); Length += FMath::Max(1, Bytes.Num() / 64))
+		{
+			FBPVariant Truncated;
+			bRejectedTruncated = !FBPVariantSerializer::Read(Bytes.GetData(), Length, Truncated) && bRejectedTruncated;
+		}
+		bPassed = Check(bRejectedTruncated, TEXT("truncated data is rejected")) && bPassed;
+
+		// Throughput
+		TArray<uint8> Scratch;
+		Scratch.Reserve(Bytes.Num());
+		double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			Scratch.Reset();
+			FBPVariantSerializer::Write(Payload, Scratch);
+		}
+		const double WriteSeconds = FPlatformTime::Seconds() - Start;
+
+		Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			FBPVariantSerializer::Read(Bytes, Decoded);
+		}
+		const double ReadSeconds = FPlatformTime::Seconds() - Start;
+
+		const double Megabytes = static_cast<double>(Bytes.Num()) * Iterations / (1024.0 * 1024.0);
+		UE_LOG(ModSkeletonLog, Log, TEXT("Serialization benchmark: %d elements, %d bytes (GetDebugValue: %d characters), %d iterations - %s"),
+			Elements, Bytes.Num(), Payload.GetDebugValue().Len(), Iterations, bPassed ? TEXT("round trips passed") : TEXT("ROUND TRIPS FAILED"));
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - write:            %.3fms per payload, %.1f MB/s"), WriteSeconds * 1000.0 / Iterations, Megabytes / FMath::Max(WriteSeconds, SMALL_NUMBER));
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - read (warm value): %.3fms per payload, %.1f MB/s"), ReadSeconds * 1000.0 / Iterations, Megabytes / FMath::Max(ReadSeconds, SMALL_NUMBER));
+	}
+
+	/**
+	 * What copying HookIO cost before array nodes were shared: a fresh node for every array and map in the tree
+	 */
+	static void DeepCopy(const FBPVariant& In, FBPVariant& Out)
+	{
+		if (In.GetType() == EBPVariantType::VT_Array)
+		{
+			const TArray< FBPVariant >& Elements = In.GetAsArray();
+			TArray< FBPVariant >& OutElements = Out.SetAsArray();
+			OutElements.SetNum(Elements.Num());
+			for (int32 i = 0; i < Elements.Num(); ++i)
+			{
+				DeepCopy(Elements[i], OutElements[i]);
+			}
+		}
+		else if (In.GetType() == EBPVariantType::VT_Map)
+		{
+			Out.SetAsMap();
+			for (const auto& Entry : In.GetAsMap().Entries)
+			{
+				DeepCopy(Entry.Value, Out.FindOrAddMapValue(Entry.Key));
+			}
+		}
+		else
+		{
+			Out = In;
+		}
+	}
+
+	/**
+	 * Follow the nested arrays of a BuildPayload payload down to a leaf and bump the integer there.
+	 * Path picks element 0 or 4 (the two nested arrays) at each level.
+	 */
+	static void BumpLeaf(FBPVariant& Root, uint32 Path)
+	{
+		FBPVariant* Node = &Root;
+		while (Node->GetType() == EBPVariantType::VT_Array)
+		{
+			TArray< FBPVariant >& Elements = Node->GetMutableArray();
+			const int32 Next = (Path & 1) != 0 ? 4 : 0;
+			Path >>= 1;
+			if (!Elements.IsValidIndex(Next) || Elements[Next].GetType() != EBPVariantType::VT_Array)
+			{
+				if (Elements.IsValidIndex(2))
+				{
+					Elements[2].SetAsInteger(Elements[2].GetAsInteger() + 1);
+				}
+				return;
+			}
+			Node = &Elements[Next];
+		}
+	}
+
+	static double TimeInvoke(UModSkeletonRegistry* Registry, const FModSkeletonHookHandle& Hook, int32 Iterations, int32& OutValue)
+	{
+		TArray< FBPVariant > HookIO;
+		HookIO.AddDefaulted();
+
+		const double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			HookIO[0].SetAsInteger(0);
+			Registry->InvokeHookValuesInPlace(Hook, HookIO);
+		}
+		const double Seconds = FPlatformTime::Seconds() - Start;
+		OutValue = HookIO[0].GetAsInteger();
+		return Seconds;
+	}
+
+	/**
+	 * A hook with two handlers is invoked while more and more handlers are connected to a second hook: its cost should
+	 * stay flat, since only its own dispatch list is walked, while the busy hook's grows with its handlers
+	 */
+	static void DispatchScaling(const TArray<FString>& Args)
+	{
+		const int32 MaxConnections = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1024;
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 10000;
+		bool bPassed = true;
+
+		UModSkeletonRegistry* Registry = NewObject<UModSkeletonRegistry>(GetTransientPackage());
+		FModSkeletonHookDescription Description;
+		Description.HookDescription = TEXT("ModSkeleton.Benchmark.DispatchScaling");
+		Description.HookName = TEXT("ModSkeletonBenchmarkTarget");
+		const FModSkeletonHookHandle TargetHook = Registry->InstallHook(Description);
+		Description.HookName = TEXT("ModSkeletonBenchmarkBusy");
+		const FModSkeletonHookHandle BusyHook = Registry->InstallHook(Description);
+
+		// connected lowest priority first, so the result only reads 21 if the dispatch list was sorted
+		Registry->ConnectNativeHook(TargetHook, 1, [](const FString& HookName, TArray< FBPVariant >& HookIO)
+		{
+			HookIO[0].SetAsInteger(HookIO[0].GetAsInteger() * 10 + 1);
+		});
+		Registry->ConnectNativeHook(TargetHook, 2, [](const FString& HookName, TArray< FBPVariant >& HookIO)
+		{
+			HookIO[0].SetAsInteger(HookIO[0].GetAsInteger() * 10 + 2);
+		});
+		TFunction<void(const FString&, TArray< FBPVariant >&)> BusyHandler = [](const FString& HookName, TArray< FBPVariant >& HookIO)
+		{
+			HookIO[0].SetAsInteger(HookIO[0].GetAsInteger() + 1);
+		};
+
+		// warm up before measuring
+		int32 Value = 0;
+		TimeInvoke(Registry, TargetHook, 1, Value);
+
+		UE_LOG(ModSkeletonLog, Log, TEXT("DispatchScaling benchmark: up to %d connections on another hook, %d iterations"), MaxConnections, Iterations);
+		double BaseSeconds = 0.0;
+		int32 Connections = 0;
+		for (int32 Step = 1; ; Step = FMath::Min(Step * 4, MaxConnections))
+		{
+			for (; Connections < Step; ++Connections)
+			{
+				Registry->ConnectNativeHook(BusyHook, Connections % 7, BusyHandler);
+			}
+
+			const double TargetSeconds = TimeInvoke(Registry, TargetHook, Iterations, Value);
+			bPassed = Check(Value == 21, TEXT("the two handlers run once each, highest priority first")) && bPassed;
+			const double BusySeconds = TimeInvoke(Registry, BusyHook, Iterations, Value);
+			bPassed = Check(Value == Connections, TEXT("every handler of the busy hook runs once")) && bPassed;
+
+			if (BaseSeconds == 0.0)
+			{
+				BaseSeconds = TargetSeconds;
+			}
+			UE_LOG(ModSkeletonLog, Log, TEXT(" - %5d connections: 2 handlers %.3fus per invoke (%.2fx), %d handlers %.3fus per invoke"),
+				Connections + 2, TargetSeconds * 1000000.0 / Iterations, TargetSeconds / FMath::Max(BaseSeconds, SMALL_NUMBER),
+				Connections, BusySeconds * 1000000.0 / Iterations);
+
+			if (Connections >= MaxConnections)
+			{
+				break;
+			}
+		}
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - %s"), bPassed ? TEXT("checks passed") : TEXT("CHECKS FAILED"));
+	}
+
+	static double TimeChain(UModSkeletonRegistry* Registry, const FModSkeletonHookHandle& Hook, const TArray< FBPVariant >& HookIO, int32 Iterations, int32& OutNodeAllocations, TArray< FBPVariant >& OutResult)
+	{
+		const int32 StartNodes = FModSkeletonProfiler::Get().GetValueNodeAllocations();
+		const double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			OutResult = Registry->InvokeHookValuesByHandle(Hook, HookIO);
+		}
+		const double Seconds = FPlatformTime::Seconds() - Start;
+		OutNodeAllocations = (FModSkeletonProfiler::Get().GetValueNodeAllocations() - StartNodes) / Iterations;
+		return Seconds;
+	}
+
+	static void CopyOnWrite(const TArray<FString>& Args)
+	{
+		const int32 NumHandlers = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 16;
+		const int32 Breadth = Args.Num() > 1 ? FMath::Max(8, FCString::Atoi(*Args[1])) : 16;
+		const int32 Depth = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 4;
+		const int32 Iterations = Args.Num() > 3 ? FMath::Max(1, FCString::Atoi(*Args[3])) : 20;
+
+		TArray< FBPVariant > HookIO;
+		HookIO.AddDefaulted();
+		int32 Elements = 0;
+		BuildPayload(HookIO[0], Breadth, Depth, Elements);
+		const TArray< FBPVariant > Original = HookIO;
+		TArray< FBPVariant > OriginalCopy;
+		OriginalCopy.AddDefaulted();
+		DeepCopy(HookIO[0], OriginalCopy[0]);
+
+		// Each handler returns HookIO with one leaf changed, like a chain of value plugins.
+		// The deep copying chain is what every handler had to do before nodes were shared.
+		UModSkeletonRegistry* Registry = NewObject<UModSkeletonRegistry>(GetTransientPackage());
+		FModSkeletonHookDescription Description;
+		Description.HookDescription = TEXT("ModSkeleton.Benchmark.CopyOnWrite");
+		Description.HookName = TEXT("ModSkeletonBenchmarkShared");
+		const FModSkeletonHookHandle SharedHook = Registry->InstallHook(Description);
+		Description.HookName = TEXT("ModSkeletonBenchmarkDeepCopy");
+		const FModSkeletonHookHandle DeepCopyHook = Registry->InstallHook(Description);
+		for (int32 i = 0; i < NumHandlers; ++i)
+		{
+			const uint32 Path = static_cast<uint32>(i) * 2654435761u;
+			Registry->ConnectNativeHook(SharedHook, 0, [Path](const FString& HookName, TArray< FBPVariant >& InOut)
+			{
+				TArray< FBPVariant > Result = InOut;
+				BumpLeaf(Result[0], Path);
+				InOut = MoveTemp(Result);
+			});
+			Registry->ConnectNativeHook(DeepCopyHook, 0, [Path](const FString& HookName, TArray< FBPVariant >& InOut)
+			{
+				TArray< FBPVariant > Result;
+				Result.AddDefaulted();
+				DeepCopy(InOut[0], Result[0]);
+				BumpLeaf(Result[0], Path);
+				InOut = MoveTemp(Result);
+			});
+		}
+
+		int32 SharedNodes = 0;
+		int32 DeepCopyNodes = 0;
+		TArray< FBPVariant > SharedResult;
+		TArray< FBPVariant > DeepCopyResult;
+		const double SharedSeconds = TimeChain(Registry, SharedHook, HookIO, Iterations, SharedNodes, SharedResult);
+		const double DeepCopySeconds = TimeChain(Registry, DeepCopyHook, HookIO, Iterations, DeepCopyNodes, DeepCopyResult);
+
+		bool bPassed = true;
+		bPassed = Check(SharedResult == DeepCopyResult, TEXT("shared and deep copied chains agree")) && bPassed;
+		bPassed = Check(HookIO == OriginalCopy && Original[0].SharesStorageWith(HookIO[0]), TEXT("the caller's HookIO is untouched")) && bPassed;
+		bPassed = Check(SharedResult != HookIO, TEXT("the handlers changed the result")) && bPassed;
+		// element 7 is a map no handler writes to
+		bPassed = Check(SharedResult[0].GetAsArray()[7].SharesStorageWith(HookIO[0].GetAsArray()[7]), TEXT("untouched subtrees stay shared")) && bPassed;
+
+		UE_LOG(ModSkeletonLog, Log, TEXT("Copy-on-write benchmark: %d handlers each changing one leaf of a %d element payload, %d iterations - %s"),
+			NumHandlers, Elements, Iterations, bPassed ? TEXT("checks passed") : TEXT("CHECKS FAILED"));
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - shared nodes: %.3fms, %d node allocations per invocation"), SharedSeconds * 1000.0 / Iterations, SharedNodes);
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - deep copies:  %.3fms, %d node allocations per invocation"), DeepCopySeconds * 1000.0 / Iterations, DeepCopyNodes);
+	}
+
+	static void PackedArrays(const TArray<FString>& Args)
+	{
+		const int32 Num = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 65536;
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100;
+
+		// odd sizes on purpose, so the scalar tails of the vector loops run too
+		FBPVariant Floats;
+		FBPVariant Ints;
+		FBPVariant Bools;
+		FBPVariant Vectors;
+		TArray<float>& FloatValues = Floats.SetAsFloatArray();
+		TArray<int32>& IntValues = Ints.SetAsIntArray();
+		TBitArray<>& BoolValues = Bools.SetAsBoolArray();
+		TArray<FVector>& VectorValues = Vectors.SetAsVectorArray();
+		FRandomStream Random(Num);
+		for (int32 i = 0; i < Num + 3; ++i)
+		{
+			FloatValues.Add(Random.FRandRange(-1000.f, 1000.f));
+			IntValues.Add(Random.RandRange(-100000, 100000));
+			BoolValues.Add(Random.FRand() < 0.3f);
+			VectorValues.Add(Random.GetUnitVector() * Random.FRandRange(1.f, 100.f));
+		}
+
+		// Reductions and transforms against plain loops
+		bool bPassed = true;
+		double ExpectedSum = 0.0;
+		float ExpectedMin = FloatValues[0];
+		float ExpectedMax = FloatValues[0];
+		for (const float Value : FloatValues)
+		{
+			ExpectedSum += Value;
+			ExpectedMin = FMath::Min(ExpectedMin, Value);
+			ExpectedMax = FMath::Max(ExpectedMax, Value);
+		}
+		float Min;
+		float Max;
+		bPassed = Check(FMath::Abs(Floats.GetPackedSum() - ExpectedSum) <= 1e-3 * FloatValues.Num(), TEXT("float sum")) && bPassed;
+		bPassed = Check(Floats.GetPackedRange(Min, Max) && Min == ExpectedMin && Max == ExpectedMax, TEXT("float range")) && bPassed;
+
+		int32 ExpectedTrue = 0;
+		for (int32 i = 0; i < BoolValues.Num(); ++i)
+		{
+			ExpectedTrue += BoolValues[i] ? 1 : 0;
+		}
+		bPassed = Check(Bools.GetPackedSum() == ExpectedTrue, TEXT("boolean count")) && bPassed;
+
+		FBPVariant Shared = Floats;
+		bPassed = Check(Shared.ScalePacked(2.0f) && Shared.AddPacked(Floats, -1.0f) && Shared == Floats, TEXT("scale then add back to the original")) && bPassed;
+		bPassed = Check(Floats.GetAsFloatArray() == FloatValues, TEXT("copies do not see each other's transforms")) && bPassed;
+		FBPVariant ScaledVectors = Vectors;
+		ScaledVectors.ScalePacked(0.5f);
+		bPassed = Check(ScaledVectors.GetAsVectorArray()[Num] == VectorValues[Num] * 0.5f, TEXT("vector scale")) && bPassed;
+		bPassed = Check(!Ints.AddPacked(Floats), TEXT("adding a different type is refused")) && bPassed;
+
+		// Round trips
+		FBPVariant Packed;
+		TArray< FBPVariant >& Elements = Packed.SetAsArray();
+		Elements.Add(Floats);
+		Elements.Add(Ints);
+		Elements.Add(Bools);
+		Elements.Add(Vectors);
+		TArray<uint8> Bytes;
+		FBPVariantSerializer::Write(Packed, Bytes);
+		FBPVariant Decoded;
+		bPassed = Check(FBPVariantSerializer::Read(Bytes, Decoded) && Decoded == Packed && GetTypeHash(Decoded) == GetTypeHash(Packed), TEXT("serializer round trip")) && bPassed;
+		UBPVariant* Object = Packed.ToObject(GetTransientPackage());
+		TArray<uint8> ObjectBytes;
+		FBPVariantSerializer::Write(Object, ObjectBytes);
+		bPassed = Check(ObjectBytes == Bytes && FBPVariant::FromObject(Object) == Packed && Packed.Equals(Object), TEXT("UBPVariant round trip")) && bPassed;
+
+		// Throughput, against the same floats as one FBPVariant per element
+		FBPVariant Boxed;
+		TArray< FBPVariant >& BoxedValues = Boxed.SetAsArray();
+		BoxedValues.SetNum(FloatValues.Num());
+		for (int32 i = 0; i < FloatValues.Num(); ++i)
+		{
+			BoxedValues[i].SetAsFloat(FloatValues[i]);
+		}
+
+		float Sink = 0.0f;
+		double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			Sink += Floats.GetPackedSum();
+		}
+		const double PackedSeconds = FPlatformTime::Seconds() - Start;
+
+		Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			for (const FBPVariant& Value : Boxed.GetAsArray())
+			{
+				Sink += Value.GetAsFloat();
+			}
+		}
+		const double BoxedSeconds = FPlatformTime::Seconds() - Start;
+
+		FBPVariant Scaled = Floats;
+		Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			Scaled.AddPacked(Floats, 0.5f);
+		}
+		const double AddSeconds = FPlatformTime::Seconds() - Start;
+
+		const double Megabytes = static_cast<double>(FloatValues.Num()) * sizeof(float) * Iterations / (1024.0 * 1024.0);
+		UE_LOG(ModSkeletonLog, Log, TEXT("Packed array benchmark: %d elements, %d iterations - %s (%f)"),
+			FloatValues.Num(), Iterations, bPassed ? TEXT("checks passed") : TEXT("CHECKS FAILED"), Sink);
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - sum, packed:       %.3fms, %.1f MB/s"), PackedSeconds * 1000.0 / Iterations, Megabytes / FMath::Max(PackedSeconds, SMALL_NUMBER));
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - sum, VT_Array:     %.3fms, %.1f MB/s"), BoxedSeconds * 1000.0 / Iterations, Megabytes / FMath::Max(BoxedSeconds, SMALL_NUMBER));
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - add, packed:       %.3fms, %.1f MB/s"), AddSeconds * 1000.0 / Iterations, Megabytes / FMath::Max(AddSeconds, SMALL_NUMBER));
+	}
+
+	/**
+	 * Worker threads invoke a hook nonstop while the game thread loads a mod with a native plugin connected to it, then
+	 * unloads it again (which collects garbage), round after round
+	 */
+	static bool ConcurrentUnload(int32 NumWorkers, int32 Rounds)
+	{
+		UModSkeletonRegistry* Registry = NewObject<UModSkeletonRegistry>(GetTransientPackage());
+		FModSkeletonHookDescription Description;
+		Description.HookName = TEXT("ModSkeletonBenchmarkUnload");
+		Description.HookDescription = TEXT("ModSkeleton.Benchmark.ConcurrentDispatch");
+		const FModSkeletonHookHandle Hook = Registry->InstallHook(Description);
+
+		// The registry is only referenced from this stack frame, and UnloadMod collects garbage
+		Registry->AddToRoot();
+		UModSkeletonBenchmarkPlugin::CallsWhileDestroying.Reset();
+
+		FThreadSafeCounter StopWorkers;
+		TArray< TFuture<int32> > Workers;
+		for (int32 i = 0; i < NumWorkers; ++i)
+		{
+			Workers.Add(Async<int32>(EAsyncExecution::ThreadPool, [Registry, Hook, &StopWorkers]()
+			{
+				int32 Invocations = 0;
+				TArray< FBPVariant > HookIO;
+				HookIO.AddDefaulted();
+				while (StopWorkers.GetValue() == 0)
+				{
+					HookIO[0].SetAsInteger(0);
+					Registry->InvokeHookValuesInPlace(Hook, HookIO);
+					++Invocations;
+				}
+				return Invocations;
+			}));
+		}
+
+		TArray< TWeakObjectPtr<UObject> > Plugins;
+		int32 MaxRetired = 0;
+		const double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Rounds; ++i)
+		{
+			const FString ModName = FString::Printf(TEXT("ModSkeletonBenchmarkUnload%d"), i);
+			UModSkeletonBenchmarkPlugin* Plugin = NewObject<UModSkeletonBenchmarkPlugin>(GetTransientPackage());
+			Plugins.Add(Plugin);
+			FModSkeletonBenchmarkRegistryAccess::AddMod(Registry, ModName, Plugin);
+			Registry->ConnectHookByHandle(Hook, 0, Plugin);
+
+			// give the workers time to pin a snapshot that calls the plugin
+			FPlatformProcess::Sleep(0.002f);
+			Registry->UnloadMod(ModName);
+			MaxRetired = FMath::Max(MaxRetired, FModSkeletonBenchmarkRegistryAccess::GetNumRetiredSnapshots(Registry));
+		}
+		const double Seconds = FPlatformTime::Seconds() - Start;
+
+		StopWorkers.Increment();
+		int64 Invocations = 0;
+		for (TFuture<int32>& Worker : Workers)
+		{
+			Invocations += Worker.Get();
+		}
+
+		// A game thread invocation reclaims what the workers left pinned, after which the plugins can go
+		TArray< FBPVariant > HookIO;
+		HookIO.AddDefaulted();
+		HookIO[0].SetAsInteger(0);
+		Registry->InvokeHookValuesInPlace(Hook, HookIO);
+		const int32 Retired = FModSkeletonBenchmarkRegistryAccess::GetNumRetiredSnapshots(Registry);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		Registry->RemoveFromRoot();
+
+		int32 Surviving = 0;
+		for (const TWeakObjectPtr<UObject>& Plugin : Plugins)
+		{
+			Surviving += Plugin.IsValid() ? 1 : 0;
+		}
+
+		bool bPassed = true;
+		bPassed = Check(UModSkeletonBenchmarkPlugin::CallsWhileDestroying.GetValue() == 0, TEXT("no worker called a plugin being garbage collected")) && bPassed;
+		bPassed = Check(Retired == 0, TEXT("every retired snapshot is reclaimed once the workers stop")) && bPassed;
+		bPassed = Check(Surviving == 0, TEXT("unloaded plugins are collected once no snapshot refers to them")) && bPassed;
+
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - %d mods loaded and unloaded in %.3fms while workers made %lld invocations, at most %d retired snapshots pending"),
+			Rounds, Seconds * 1000.0, Invocations, MaxRetired);
+		return bPassed;
+	}
+
+	/**
+	 * Worker threads invoke a counting hook nonstop while the game thread connects handlers to it and installs other hooks
+	 */
+	static void ConcurrentDispatch(const TArray<FString>& Args)
+	{
+		const int32 NumWorkers = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 4;
+		const int32 NumConnections = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 256;
+		const int32 UnloadRounds = Args.Num() > 2 ? FMath::Max(0, FCString::Atoi(*Args[2])) : 16;
+
+		UModSkeletonRegistry* Registry = NewObject<UModSkeletonRegistry>(GetTransientPackage());
+
+		FModSkeletonHookDescription Description;
+		Description.HookName = TEXT("ModSkeletonBenchmarkConcurrent");
+		Description.HookDescription = TEXT("ModSkeleton.Benchmark.ConcurrentDispatch");
+		Description.HookIOTypes.Add(EBPVariantType::VT_Integer);
+		const FModSkeletonHookHandle Hook = Registry->InstallHook(Description);
+
+		// Every handler adds one, so an invocation returns the number of handlers in the snapshot it ran against
+		TSharedRef<FThreadSafeCounter, ESPMode::ThreadSafe> HandlerCalls = MakeShareable(new FThreadSafeCounter());
+		TFunction<void(const FString&, TArray< FBPVariant >&)> Handler = [HandlerCalls](const FString& HookName, TArray< FBPVariant >& HookIO)
+		{
+			HandlerCalls->Increment();
+			HookIO[0].SetAsInteger(HookIO[0].GetAsIntegerUnchecked() + 1);
+		};
+
+		struct FWorkerResult
+		{
+			FWorkerResult()
+				: Invocations(0)
+				, HandlerCalls(0)
+				, bMonotonic(true)
+				, LastResult(0)
+			{
+			}
+
+			int32 Invocations;
+			int64 HandlerCalls;
+			bool bMonotonic;
+			int32 LastResult;
+		};
+
+		FThreadSafeCounter StopWorkers;
+		TArray< TFuture<FWorkerResult> > Workers;
+		for (int32 i = 0; i < NumWorkers; ++i)
+		{
+			Workers.Add(Async<FWorkerResult>(EAsyncExecution::ThreadPool, [Registry, Hook, &StopWorkers]()
+			{
+				FWorkerResult Result;
+				TArray< FBPVariant > HookIO;
+				HookIO.AddDefaulted();
+				while (StopWorkers.GetValue() == 0)
+				{
+					HookIO[0].SetAsInteger(0);
+					Registry->InvokeHookValuesInPlace(Hook, HookIO);
+					const int32 Handlers = HookIO[0].GetAsInteger();
+
+					// Connections are only ever added, so no snapshot may have fewer handlers than an earlier one
+					Result.bMonotonic = Result.bMonotonic && Handlers >= Result.LastResult;
+					Result.LastResult = Handlers;
+					Result.HandlerCalls += Handlers;
+					++Result.Invocations;
+				}
+				return Result;
+			}));
+		}
+
+		const double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumConnections; ++i)
+		{
+			Registry->ConnectNativeHook(Hook, i % 7, Handler);
+
+			// Growing the hook table republishes too, and may reallocate RegisteredHooks
+			FModSkeletonHookDescription Other;
+			Other.HookName = FString::Printf(TEXT("ModSkeletonBenchmarkConcurrent%d"), i);
+			Registry->InstallHook(Other);
+		}
+		const double ConnectSeconds = FPlatformTime::Seconds() - Start;
+
+		// let the workers run against the final snapshot for a while
+		FPlatformProcess::Sleep(0.1f);
+		StopWorkers.Increment();
+
+		bool bPassed = true;
+		int64 Invocations = 0;
+		int64 WorkerHandlerCalls = 0;
+		for (TFuture<FWorkerResult>& Worker : Workers)
+		{
+			const FWorkerResult Result = Worker.Get();
+			Invocations += Result.Invocations;
+			WorkerHandlerCalls += Result.HandlerCalls;
+			bPassed = Check(Result.bMonotonic, TEXT("handler count never went backwards")) && bPassed;
+			bPassed = Check(Result.LastResult == NumConnections, TEXT("workers saw every connection")) && bPassed;
+		}
+		const double Seconds = FPlatformTime::Seconds() - Start;
+		bPassed = Check(WorkerHandlerCalls == HandlerCalls->GetValue(), TEXT("every handler call is accounted for")) && bPassed;
+
+		TArray< FBPVariant > HookIO;
+		HookIO.AddDefaulted();
+		HookIO[0].SetAsInteger(0);
+		Registry->InvokeHookValuesInPlace(Hook, HookIO);
+		bPassed = Check(HookIO[0].GetAsInteger() == NumConnections, TEXT("game thread dispatch agrees")) && bPassed;
+
+		UE_LOG(ModSkeletonLog, Log, TEXT("Concurrent dispatch benchmark: %d workers, %d connections made in %.3fms - %s"),
+			NumWorkers, NumConnections, ConnectSeconds * 1000.0, bPassed ? TEXT("checks passed") : TEXT("CHECKS FAILED"));
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - %lld invocations, %lld handler calls, %.0f invocations/s"),
+			Invocations, WorkerHandlerCalls, Invocations / FMath::Max(Seconds, SMALL_NUMBER));
+
+		if (UnloadRounds > 0)
+		{
+			const bool bUnloadPassed = ConcurrentUnload(NumWorkers, UnloadRounds);
+			UE_LOG(ModSkeletonLog, Log, TEXT("Concurrent unload - %s"), bUnloadPassed ? TEXT("checks passed") : TEXT("CHECKS FAILED"));
+		}
+	}
+
+	/**
+	 * Average time to open and close Filename through the platform file chain
+	 */
+	static double TimeFileOpens(const FString& Filename, int32 Opens)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		const double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Opens; ++i)
+		{
+			delete PlatformFile.OpenRead(*Filename);
+		}
+		return (FPlatformTime::Seconds() - Start) / Opens;
+	}
+
+	static double TimeIndexLookups(const FString& Filename, int32 Lookups)
+	{
+		const FModSkeletonPakLayer& PakLayer = FModSkeletonPakLayer::Get();
+		FString PakFilename;
+		const double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Lookups; ++i)
+		{
+			PakLayer.FindFile(Filename, PakFilename);
+		}
+		return (FPlatformTime::Seconds() - Start) / Lookups;
+	}
+
+	/**
+	 * Copies of the first mounted mod pak are mounted until NumPaks are, and file opens are timed before and after
+	 */
+	static void PakOpen(const TArray<FString>& Args)
+	{
+		const int32 NumPaks = Args.Num() > 0 ? FMath::Max(2, FCString::Atoi(*Args[0])) : 500;
+		const int32 Opens = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 2000;
+
+		FModSkeletonPakLayer& PakLayer = FModSkeletonPakLayer::Get();
+		PakLayer.GetPakPlatform();
+		TArray<FString> MountedPaks;
+		PakLayer.GetMountedPaks(MountedPaks);
+		MountedPaks.Sort();
+		FString PakFilename;
+		TArray<FString> Files;
+		for (const FString& MountedPak : MountedPaks)
+		{
+			PakLayer.GetFiles(MountedPak, Files);
+			if (Files.Num() > 0)
+			{
+				PakFilename = MountedPak;
+				break;
+			}
+		}
+		if (Files.Num() == 0)
+		{
+			UE_LOG(ModSkeletonLog, Error, TEXT("Pak open benchmark needs at least one mounted mod pak, run ScanForModPlugins with a mod in Content/Paks"));
+			return;
+		}
+
+		const FString HitFilename = Files[0];
+		const FString MissFilename = FPaths::GetPath(HitFilename) / TEXT("ModSkeletonBenchmarkMissing.uasset");
+		const int32 InitialPaks = MountedPaks.Num();
+
+		const double HitBefore = TimeFileOpens(HitFilename, Opens);
+		const double MissBefore = TimeFileOpens(MissFilename, Opens);
+		const double LookupBefore = TimeIndexLookups(HitFilename, Opens);
+
+		// Each copy gets its own mount point, so the original file stays where it was but every pak is probed for it
+		const FString CopyDir = FPaths::GameSavedDir() / TEXT("ModSkeleton") / TEXT("PakBenchmark");
+		TArray<FString> Copies;
+		for (int32 i = InitialPaks; i < NumPaks; ++i)
+		{
+			const FString CopyFilename = CopyDir / FString::Printf(TEXT("Copy%04d.pak"), i);
+			FString Error;
+			if (IFileManager::Get().Copy(*CopyFilename, *PakFilename) != COPY_OK || !PakLayer.Mount(CopyFilename, CopyDir / FString::Printf(TEXT("Copy%04d"), i), Error))
+			{
+				UE_LOG(ModSkeletonLog, Error, TEXT(" - could not mount a copy: %s"), *Error);
+				break;
+			}
+			Copies.Add(CopyFilename);
+		}
+
+		const double HitAfter = TimeFileOpens(HitFilename, Opens);
+		const double MissAfter = TimeFileOpens(MissFilename, Opens);
+		const double LookupAfter = TimeIndexLookups(HitFilename, Opens);
+		const int32 IndexedFiles = PakLayer.GetNumIndexedFiles();
+
+		for (const FString& CopyFilename : Copies)
+		{
+			PakLayer.Unmount(CopyFilename);
+		}
+		IFileManager::Get().DeleteDirectory(*CopyDir, false, true);
+
+		UE_LOG(ModSkeletonLog, Log, TEXT("Pak open benchmark: %s, %d opens"), *HitFilename, Opens);
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - %4d paks: open %.2fus, missing file %.2fus, index lookup %.3fus"),
+			InitialPaks, HitBefore * 1000000.0, MissBefore * 1000000.0, LookupBefore * 1000000.0);
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - %4d paks: open %.2fus, missing file %.2fus, index lookup %.3fus (%d files indexed)"),
+			InitialPaks + Copies.Num(), HitAfter * 1000000.0, MissAfter * 1000000.0, LookupAfter * 1000000.0, IndexedFiles);
+	}
+
+	/**
+	 * Every mod placed in a later wave than all of its dependencies in the graph
+	 */
+	static bool IsTopological(const FModSkeletonModInitOrder& Order, const TMap< FString, TArray<FString> >& Dependencies)
+	{
+		TMap<FString, int32> WaveOf;
+		for (int32 i = 0; i < Order.Waves.Num(); ++i)
+		{
+			for (const FString& ModName : Order.Waves[i])
+			{
+				WaveOf.Add(ModName, i);
+			}
+		}
+		for (const auto& Pair : Dependencies)
+		{
+			const int32* ModWave = WaveOf.Find(Pair.Key);
+			if (ModWave == nullptr)
+			{
+				return false;
+			}
+			for (const FString& Dependency : Pair.Value)
+			{
+				const int32* DependencyWave = WaveOf.Find(Dependency);
+				if (DependencyWave != nullptr && *DependencyWave >= *ModWave)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * A random layered dependency graph of Mods mods is ordered from two different insertion orders, then a cycle is added
+	 */
+	static void InitOrder(const TArray<FString>& Args)
+	{
+		const int32 NumMods = Args.Num() > 0 ? FMath::Max(4, FCString::Atoi(*Args[0])) : 1000;
+		const int32 MaxDependencies = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 4;
+
+		FRandomStream Random(NumMods);
+		TMap< FString, TArray<FString> > Dependencies;
+		TArray<FString> ModNames;
+		for (int32 i = 0; i < NumMods; ++i)
+		{
+			const FString ModName = FString::Printf(TEXT("Mod%05d"), i);
+			TArray<FString>& ModDependencies = Dependencies.Add(ModName);
+			const int32 NumDependencies = i > 0 ? Random.RandRange(0, MaxDependencies) : 0;
+			for (int32 d = 0; d < NumDependencies; ++d)
+			{
+				ModDependencies.AddUnique(ModNames[Random.RandRange(0, i - 1)]);
+			}
+			ModNames.Add(ModName);
+		}
+
+		bool bPassed = true;
+
+		FModSkeletonModGraph Graph;
+		for (const FString& ModName : ModNames)
+		{
+			Graph.AddMod(ModName, Dependencies.FindChecked(ModName));
+		}
+		const double Start = FPlatformTime::Seconds();
+		const FModSkeletonModInitOrder Order = Graph.BuildInitOrder(TSet<FString>());
+		const double Seconds = FPlatformTime::Seconds() - Start;
+		bPassed = Check(IsTopological(Order, Dependencies), TEXT("every mod is in a later wave than its dependencies")) && bPassed;
+		bPassed = Check(Order.Cycles.Num() == 0 && Order.Blocked.Num() == 0 && Order.MissingDependencies.Num() == 0, TEXT("an acyclic graph has nothing blocked")) && bPassed;
+
+		FModSkeletonModGraph Reversed;
+		for (int32 i = ModNames.Num() - 1; i >= 0; --i)
+		{
+			Reversed.AddMod(ModNames[i], Dependencies.FindChecked(ModNames[i]));
+		}
+		bPassed = Check(Reversed.BuildInitOrder(TSet<FString>()).Waves == Order.Waves, TEXT("order does not depend on the order mods were added")) && bPassed;
+
+		// Close a cycle through the first mod, which blocks every mod depending on it, and add unknown and loaded dependencies
+		Graph.AddMod(TEXT("Cycle"), { ModNames[0] });
+		Graph.AddMod(ModNames[0], { TEXT("Cycle") });
+		Graph.AddMod(TEXT("Missing"), { TEXT("NotAMod") });
+		TSet<FString> AlreadyLoaded;
+		AlreadyLoaded.Add(TEXT("Loaded"));
+		Graph.AddMod(TEXT("UsesLoaded"), { TEXT("Loaded") });
+		const FModSkeletonModInitOrder CycleOrder = Graph.BuildInitOrder(AlreadyLoaded);
+		bPassed = Check(CycleOrder.Cycles.Num() == 1 && CycleOrder.Cycles[0] == TEXT("Cycle -> ") + ModNames[0] + TEXT(" -> Cycle"), TEXT("the cycle is reported once")) && bPassed;
+		bPassed = Check(CycleOrder.Blocked.Contains(TEXT("Cycle")) && CycleOrder.Blocked.Contains(ModNames[0]), TEXT("mods on the cycle are blocked")) && bPassed;
+		bPassed = Check(CycleOrder.MissingDependencies.Num() == 1 && CycleOrder.MissingDependencies[0] == TEXT("Missing -> NotAMod"), TEXT("only the unknown dependency is missing")) && bPassed;
+		bPassed = Check(CycleOrder.Waves.Num() > 0 && CycleOrder.Waves[0].Contains(TEXT("Missing")) && CycleOrder.Waves[0].Contains(TEXT("UsesLoaded")), TEXT("mods with missing or loaded dependencies still initialize")) && bPassed;
+
+		int32 Widest = 0;
+		for (const TArray<FString>& Wave : Order.Waves)
+		{
+			Widest = FMath::Max(Widest, Wave.Num());
+		}
+		UE_LOG(ModSkeletonLog, Log, TEXT("Init order benchmark: %d mods, up to %d dependencies each"), NumMods, MaxDependencies);
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - %d waves, widest %d mods, ordered in %.3fms"), Order.Waves.Num(), Widest, Seconds * 1000.0);
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - %d mods blocked by the added cycle, %s"),
+			CycleOrder.Blocked.Num(), bPassed ? TEXT("checks passed") : TEXT("CHECKS FAILED"));
+	}
+}
+
+static FAutoConsoleCommand ModSkeletonBenchmarkParallelBroadcastCommand(
+	TEXT("ModSkeleton.Benchmark.ParallelBroadcast"),
+	TEXT("Compare serial and ParallelBroadcast dispatch of busy native handlers. Optional arguments: Handlers (32) WorkMicroseconds (200) Iterations (20)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ModSkeletonBenchmark::ParallelBroadcast));
+
+static FAutoConsoleCommand ModSkeletonBenchmarkDispatchScalingCommand(
+	TEXT("ModSkeleton.Benchmark.DispatchScaling"),
+	TEXT("Time invoking a hook with two handlers while more and more handlers are connected to another hook, and check priority order. Optional arguments: MaxConnections (1024) Iterations (10000)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ModSkeletonBenchmark::DispatchScaling));
+
+static FAutoConsoleCommand ModSkeletonBenchmarkSerializationCommand(
+	TEXT("ModSkeleton.Benchmark.Serialization"),
+	TEXT("Check BPVariant binary round trips on a large nested payload and measure encode / decode throughput. Optional arguments: Breadth (16) Depth (3) Iterations (20)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ModSkeletonBenchmark::Serialization));
+
+static FAutoConsoleCommand ModSkeletonBenchmarkCopyOnWriteCommand(
+	TEXT("ModSkeleton.Benchmark.CopyOnWrite"),
+	TEXT("Compare FBPVariant node allocations of a handler chain that edits one leaf each, with shared nodes and with deep copies. Optional arguments: Handlers (16) Breadth (16) Depth (4) Iterations (20)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ModSkeletonBenchmark::CopyOnWrite));
+
+static FAutoConsoleCommand ModSkeletonBenchmarkPackedArraysCommand(
+	TEXT("ModSkeleton.Benchmark.PackedArrays"),
+	TEXT("Check packed array reductions, transforms and round trips, and compare their throughput with VT_Array. Optional arguments: Num (65536) Iterations (100)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ModSkeletonBenchmark::PackedArrays));
+
+static FAutoConsoleCommand ModSkeletonBenchmarkConcurrentDispatchCommand(
+	TEXT("ModSkeleton.Benchmark.ConcurrentDispatch"),
+	TEXT("Invoke a hook from worker threads while the game thread connects handlers to it, and check every invocation saw a consistent handler list, then load and unload mods while they invoke. Optional arguments: Workers (4) Connections (256) UnloadRounds (16)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ModSkeletonBenchmark::ConcurrentDispatch));
+
+static FAutoConsoleCommand ModSkeletonBenchmarkPakOpenCommand(
+	TEXT("ModSkeleton.Benchmark.PakOpen"),
+	TEXT("Time file opens and mod file index lookups with the mounted mod paks, then again with copies of one mounted until there are Paks. Optional arguments: Paks (500) Opens (2000)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ModSkeletonBenchmark::PakOpen));
+
+static FAutoConsoleCommand ModSkeletonBenchmarkInitOrderCommand(
+	TEXT("ModSkeleton.Benchmark.InitOrder"),
+	TEXT("Check mod dependency waves and cycle detection on a random dependency graph, and time ordering it. Optional arguments: Mods (1000) MaxDependencies (4)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ModSkeletonBenchmark::InitOrder));
+
+#endif
@@ -0,0 +1,58 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "ModSkeletonNativePluginInterface.h"
+
+#include "ModSkeletonBenchmarkPlugin.generated.h"
+
+/**
+ * Native plugin used by ModSkeleton.Benchmark.ConcurrentDispatch. Adds one to the integer in HookIO[0], and counts
+ * any call that arrives after garbage collection has started destroying it.
+ * UHT reflects it in every configuration, so it is kept internal: not exported, not visible to Blueprint, and only
+ * created by the benchmarks, which are compiled out of Shipping.
+ */
+UCLASS(Transient, NotBlueprintable, NotBlueprintType, NotPlaceable)
+class UModSkeletonBenchmarkPlugin : public UObject, public IModSkeletonNativePluginInterface
+{
+	GENERATED_BODY()
+
+public:
+	UModSkeletonBenchmarkPlugin()
+		: bDestroying(false)
+	{
+	}
+
+	virtual void BeginDestroy() override
+	{
+		bDestroying = true;
+		Super::BeginDestroy();
+	}
+
+	virtual void ModSkeletonNativeHook(const FString& HookName, TArray< FBPVariant >& HookIO) override
+	{
+		if (bDestroying)
+		{
+			CallsWhileDestroying.Increment();
+		}
+		HookIO[0].SetAsInteger(HookIO[0].GetAsIntegerUnchecked() + 1);
+	}
+
+	static FThreadSafeCounter CallsWhileDestroying;
+
+private:
+	volatile bool bDestroying;
+};
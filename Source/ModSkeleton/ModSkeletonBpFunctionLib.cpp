@@ -34,4 +34,9 @@ FString UModSkeletonBpFunctionLib::GetFullDescription(const FModSkeletonHookDesc
 		out.Append(P);
 	}
 	return out;
+}
+
+bool UModSkeletonBpFunctionLib::IsValidHookHandle(const FModSkeletonHookHandle& Hook)
+{
+	return Hook.IsValid();
 }
\ No newline at end of file
@@ -44,6 +44,12 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeletonHookDescription", meta = (CompactNodeTitle = "FullDescription"))
 	static FString GetFullDescription(const FModSkeletonHookDescription& HookDescription);
 
+	/**
+	 * Check if a hook handle refers to a hook (InstallHook returns an invalid handle for duplicate hooks)
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeletonHookHandle", meta = (CompactNodeTitle = "IsValid"))
+	static bool IsValidHookHandle(const FModSkeletonHookHandle& Hook);
+
 private:
 	static UModSkeletonRegistry* GlobalModRegistryRef;
 };
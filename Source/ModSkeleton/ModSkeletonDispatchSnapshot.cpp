@@ -0,0 +1,104 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include "ModSkeleton.h"
+#include "ModSkeletonDispatchSnapshot.h"
+
+const FModSkeletonHookSnapshot* FModSkeletonDispatchSnapshot::FindHook(FName HookName, int32 Index) const
+{
+	if (Hooks.IsValidIndex(Index) && Hooks[Index].IsValid() && Hooks[Index]->Name == HookName)
+	{
+		return Hooks[Index].Get();
+	}
+
+	// handle was resolved against a different registry instance (or default constructed)
+	const int32* Found = HookIndices.Find(HookName);
+	return Found != nullptr && Hooks[*Found].IsValid() ? Hooks[*Found].Get() : nullptr;
+}
+
+FModSkeletonDispatchSnapshotPublisher::FModSkeletonDispatchSnapshotPublisher()
+	: Current(new FModSkeletonDispatchSnapshot())
+{
+}
+
+FModSkeletonDispatchSnapshotPublisher::~FModSkeletonDispatchSnapshotPublisher()
+{
+	Reclaim();
+	ensureMsgf(Retired.Num() == 0 && Current->Readers.GetValue() == 0, TEXT("ModSkeleton registry destroyed while another thread is invoking its hooks"));
+	delete Current;
+	for (FModSkeletonDispatchSnapshot* Snapshot : Retired)
+	{
+		delete Snapshot;
+	}
+}
+
+void FModSkeletonDispatchSnapshotPublisher::Publish(FModSkeletonDispatchSnapshot* NewSnapshot)
+{
+	check(IsInGameThread());
+	FModSkeletonDispatchSnapshot* Previous = static_cast<FModSkeletonDispatchSnapshot*>(FPlatformAtomics::InterlockedExchangePtr(reinterpret_cast<void**>(const_cast<FModSkeletonDispatchSnapshot**>(&Current)), NewSnapshot));
+	Retired.Add(Previous);
+	Reclaim();
+}
+
+void FModSkeletonDispatchSnapshotPublisher::Reclaim()
+{
+	check(IsInGameThread());
+
+	// A reader still entering may have loaded a retired snapshot without having counted itself on it yet.
+	// Any reader that enters from now on loads the current snapshot, none of the retired ones.
+	if (Retired.Num() == 0 || EnteringReaders.GetValue() != 0)
+	{
+		return;
+	}
+	FPlatformMisc::MemoryBarrier();
+
+	Retired.RemoveAll([](FModSkeletonDispatchSnapshot* Snapshot)
+	{
+		if (Snapshot->Readers.GetValue() != 0)
+		{
+			return false;
+		}
+		delete Snapshot;
+		return true;
+	});
+}
+
+void FModSkeletonDispatchSnapshotPublisher::AddReferencedObjects(UObject* Referencer, FReferenceCollector& Collector) const
+{
+	auto AddSnapshot = [Referencer, &Collector](const FModSkeletonDispatchSnapshot* Snapshot)
+	{
+		for (const TSharedPtr<const FModSkeletonHookSnapshot, ESPMode::ThreadSafe>& Hook : Snapshot->Hooks)
+		{
+			if (!Hook.IsValid())
+			{
+				continue;
+			}
+			for (const FModSkeletonSnapshotHandler& Handler : Hook->Handlers)
+			{
+				// A copy, so the collector never writes into a snapshot a worker may be reading.
+				// For native handler connections this is the object the delegate is bound to.
+				UObject* Plugin = Handler.Plugin;
+				Collector.AddReferencedObject(Plugin, Referencer);
+			}
+		}
+	};
+
+	AddSnapshot(Current);
+	for (const FModSkeletonDispatchSnapshot* Snapshot : Retired)
+	{
+		AddSnapshot(Snapshot);
+	}
+}
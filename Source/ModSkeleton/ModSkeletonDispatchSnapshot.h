@@ -0,0 +1,187 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#pragma once
+
+#include "BPVariant.h"
+#include "ModSkeletonNativePluginInterface.h"
+
+/**
+ * One handler a worker thread may call: a native handler connection, or a plugin implementing ModSkeletonNativePluginInterface
+ */
+struct FModSkeletonSnapshotHandler
+{
+	FModSkeletonSnapshotHandler()
+		: NativePlugin(nullptr)
+		, Plugin(nullptr)
+	{
+	}
+
+	TSharedPtr<FModSkeletonNativeHookDelegate> Delegate;
+	IModSkeletonNativePluginInterface* NativePlugin;
+
+	/**
+	 * Reported in broadcast results, like FModSkeletonPluginResult::Plugin.
+	 * Kept alive for garbage collection by FModSkeletonDispatchSnapshotPublisher::AddReferencedObjects.
+	 */
+	UObject* Plugin;
+
+	void Execute(const FString& HookName, TArray< FBPVariant >& HookIO) const
+	{
+		if (Delegate.IsValid())
+		{
+			Delegate->ExecuteIfBound(HookName, HookIO);
+		}
+		else
+		{
+			NativePlugin->ModSkeletonNativeHook(HookName, HookIO);
+		}
+	}
+};
+
+/**
+ * Immutable copy of what dispatch off the game thread needs to know about one installed hook
+ */
+struct FModSkeletonHookSnapshot
+{
+	FModSkeletonHookSnapshot()
+		: bParallelBroadcast(false)
+		, bHasDeferredPlugins(false)
+		, GameThreadHandlers(0)
+	{
+	}
+
+	FName Name;
+	FString HookName;
+	TArray<EBPVariantType> HookIOTypes;
+	bool bParallelBroadcast;
+	bool bHasDeferredPlugins;
+
+	/**
+	 * Native handlers in dispatch order
+	 */
+	TArray<FModSkeletonSnapshotHandler> Handlers;
+
+	/**
+	 * Blueprint plugin connections, which only the game thread can call and which are left out of Handlers
+	 */
+	int32 GameThreadHandlers;
+};
+
+/**
+ * Immutable view of every installed hook. Unchanged hooks are shared with the previous snapshot.
+ */
+struct FModSkeletonDispatchSnapshot
+{
+	/**
+	 * Indexed like the registry's hook table, null for hooks that are not installed
+	 */
+	TArray< TSharedPtr<const FModSkeletonHookSnapshot, ESPMode::ThreadSafe> > Hooks;
+	TMap<FName, int32> HookIndices;
+
+	/**
+	 * FReadScopes pinning this snapshot
+	 */
+	mutable FThreadSafeCounter Readers;
+
+	/**
+	 * The hook a handle refers to, or nullptr if it is not installed
+	 */
+	const FModSkeletonHookSnapshot* FindHook(FName HookName, int32 Index) const;
+};
+
+/**
+ * Read-copy-update publication of FModSkeletonDispatchSnapshots.
+ * Readers on any thread pin the current snapshot with an FReadScope, which never blocks: it costs a few atomic increments and decrements.
+ * The game thread publishes replacements. A replaced snapshot is retired, and freed by a later Publish or Reclaim once its
+ * own readers have left, so no reader ever sees a snapshot freed under it and a steady stream of readers on newer
+ * snapshots does not hold older ones back.
+ */
+class MODSKELETON_API FModSkeletonDispatchSnapshotPublisher : public FNoncopyable
+{
+public:
+	FModSkeletonDispatchSnapshotPublisher();
+	~FModSkeletonDispatchSnapshotPublisher();
+
+	class FReadScope
+	{
+	public:
+		explicit FReadScope(const FModSkeletonDispatchSnapshotPublisher& InPublisher)
+			: Publisher(InPublisher)
+		{
+			// Between loading the pointer and counting ourselves on the snapshot we are only announced as entering
+			// (the increments are full barriers), so Reclaim never frees a snapshot a reader is about to pin
+			Publisher.EnteringReaders.Increment();
+			Snapshot = Publisher.Current;
+			Snapshot->Readers.Increment();
+			Publisher.EnteringReaders.Decrement();
+		}
+
+		~FReadScope()
+		{
+			Snapshot->Readers.Decrement();
+		}
+
+		const FModSkeletonDispatchSnapshot* operator->() const
+		{
+			return Snapshot;
+		}
+
+	private:
+		const FModSkeletonDispatchSnapshotPublisher& Publisher;
+		const FModSkeletonDispatchSnapshot* Snapshot;
+	};
+
+	/**
+	 * Current snapshot, for the game thread to copy from when building the next one
+	 */
+	const FModSkeletonDispatchSnapshot& GetCurrent() const
+	{
+		return *Current;
+	}
+
+	/**
+	 * Replace the current snapshot, taking ownership of NewSnapshot. Game thread only.
+	 */
+	void Publish(FModSkeletonDispatchSnapshot* NewSnapshot);
+
+	/**
+	 * Free retired snapshots that no reader has pinned. Game thread only.
+	 */
+	void Reclaim();
+
+	/**
+	 * Snapshots replaced but still pinned by a reader
+	 */
+	int32 GetNumRetired() const
+	{
+		return Retired.Num();
+	}
+
+	/**
+	 * Report the plugins of the current and every retired snapshot, so none is collected while a worker may call it
+	 */
+	void AddReferencedObjects(UObject* Referencer, FReferenceCollector& Collector) const;
+
+private:
+	FModSkeletonDispatchSnapshot* volatile Current;
+
+	/**
+	 * Readers between loading Current and pinning it
+	 */
+	mutable FThreadSafeCounter EnteringReaders;
+	TArray<FModSkeletonDispatchSnapshot*> Retired;
+};
@@ -16,11 +16,30 @@
 #include "ModSkeletonGameInstance.h"
 #include "ModSkeletonBpFunctionLib.h"
 
+UModSkeletonGameInstance::UModSkeletonGameInstance()
+	: bAsyncModScan(false)
+	, bUseModScanCache(true)
+	, bWatchModPaks(false)
+{
+}
+
 void UModSkeletonGameInstance::Init()
 {
 	ModRegistry = NewObject<UModSkeletonRegistry>(this, UModSkeletonRegistry::StaticClass());
 	UModSkeletonBpFunctionLib::GlobalModRegistryRef = ModRegistry;
-	ModRegistry->ScanForModPlugins();
+	ModRegistry->bUseScanCache = bUseModScanCache;
+	if (bAsyncModScan)
+	{
+		ModRegistry->ScanForModPluginsAsync();
+	}
+	else
+	{
+		ModRegistry->ScanForModPlugins();
+	}
+	if (bWatchModPaks)
+	{
+		ModRegistry->StartWatchingModPaks();
+	}
 	UPlatformGameInstance::Init();
 }
 
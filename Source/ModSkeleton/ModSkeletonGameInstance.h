@@ -28,10 +28,31 @@ class MODSKELETON_API UModSkeletonGameInstance : public UPlatformGameInstance
 	GENERATED_BODY()
 	
 public:
+	UModSkeletonGameInstance();
 
 	virtual void Init() override;
 	virtual void Shutdown() override;
 	
 	UPROPERTY(BlueprintReadOnly, Category="ModSkeleton")
 	UModSkeletonRegistry* ModRegistry;
+
+	/**
+	 * Scan for mods with ScanForModPluginsAsync so Init does not block on loading them.
+	 * Bind to ModRegistry->OnScanProgress / OnScanComplete to drive a loading screen.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="ModSkeleton")
+	bool bAsyncModScan;
+
+	/**
+	 * Passed on to ModRegistry->bUseScanCache before the first scan
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="ModSkeleton")
+	bool bUseModScanCache;
+
+	/**
+	 * Call ModRegistry->StartWatchingModPaks after the first scan, so mods dropped into (or removed from) Content/Paks
+	 * while the game runs are loaded (or unloaded) without a restart
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="ModSkeleton")
+	bool bWatchModPaks;
 };
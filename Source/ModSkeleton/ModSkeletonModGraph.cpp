@@ -0,0 +1,192 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ModSkeleton.h"
+#include "ModSkeletonModGraph.h"
+
+void FModSkeletonModInitOrder::GetOrderedMods(TArray<FString>& OutMods) const
+{
+	for (const TArray<FString>& Wave : Waves)
+	{
+		OutMods.Append(Wave);
+	}
+}
+
+void FModSkeletonModInitOrder::Log() const
+{
+	for (const FString& Missing : MissingDependencies)
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Mod dependency not found, initializing without it: %s"), *Missing);
+	}
+	for (const FString& Cycle : Cycles)
+	{
+		UE_LOG(ModSkeletonLog, Error, TEXT("Mod dependency cycle: %s"), *Cycle);
+	}
+	if (Blocked.Num() > 0)
+	{
+		UE_LOG(ModSkeletonLog, Error, TEXT("Not initializing mods on or behind a dependency cycle: %s"), *FString::Join(Blocked, TEXT(", ")));
+	}
+
+	if (Waves.Num() == 0)
+	{
+		return;
+	}
+	UE_LOG(ModSkeletonLog, Log, TEXT("Mod init order, %d waves:"), Waves.Num());
+	for (int32 i = 0; i < Waves.Num(); ++i)
+	{
+		UE_LOG(ModSkeletonLog, Log, TEXT(" %4d. %s"), i + 1, *FString::Join(Waves[i], TEXT(", ")));
+	}
+}
+
+void FModSkeletonModGraph::AddMod(const FString& ModName, const TArray<FString>& ModDependencies)
+{
+	TArray<FString>& Entry = Dependencies.FindOrAdd(ModName);
+	Entry.Reset();
+	for (const FString& Dependency : ModDependencies)
+	{
+		Entry.AddUnique(Dependency);
+	}
+}
+
+const TArray<FString>& FModSkeletonModGraph::GetDependencies(const FString& ModName) const
+{
+	static const TArray<FString> None;
+	const TArray<FString>* ModDependencies = Dependencies.Find(ModName);
+	return ModDependencies != nullptr ? *ModDependencies : None;
+}
+
+FModSkeletonModInitOrder FModSkeletonModGraph::BuildInitOrder(const TSet<FString>& AlreadyLoaded) const
+{
+	FModSkeletonModInitOrder Order;
+
+	TArray<FString> ModNames;
+	Dependencies.GenerateKeyArray(ModNames);
+	ModNames.Sort();
+
+	// Kahn's algorithm, one wave at a time
+	TMap<FString, int32> Unmet;
+	TMap< FString, TArray<FString> > Dependents;
+	for (const FString& ModName : ModNames)
+	{
+		int32& ModUnmet = Unmet.Add(ModName, 0);
+		for (const FString& Dependency : Dependencies.FindChecked(ModName))
+		{
+			if (Dependencies.Contains(Dependency))
+			{
+				++ModUnmet;
+				Dependents.FindOrAdd(Dependency).Add(ModName);
+			}
+			else if (!AlreadyLoaded.Contains(Dependency))
+			{
+				Order.MissingDependencies.Add(ModName + TEXT(" -> ") + Dependency);
+			}
+		}
+	}
+
+	TArray<FString> Wave;
+	for (const FString& ModName : ModNames)
+	{
+		if (Unmet.FindChecked(ModName) == 0)
+		{
+			Wave.Add(ModName);
+		}
+	}
+
+	int32 Placed = 0;
+	while (Wave.Num() > 0)
+	{
+		TArray<FString> NextWave;
+		for (const FString& ModName : Wave)
+		{
+			if (const TArray<FString>* ModDependents = Dependents.Find(ModName))
+			{
+				for (const FString& Dependent : *ModDependents)
+				{
+					if (--Unmet.FindChecked(Dependent) == 0)
+					{
+						NextWave.Add(Dependent);
+					}
+				}
+			}
+		}
+		Placed += Wave.Num();
+		NextWave.Sort();
+		Order.Waves.Add(MoveTemp(Wave));
+		Wave = MoveTemp(NextWave);
+	}
+
+	if (Placed == ModNames.Num())
+	{
+		return Order;
+	}
+
+	// Whatever is left never got all its dependencies met, so it is on a cycle or behind one
+	TSet<FString> Remaining;
+	for (const FString& ModName : ModNames)
+	{
+		if (Unmet.FindChecked(ModName) > 0)
+		{
+			Remaining.Add(ModName);
+		}
+	}
+
+	TMap<FString, int32> State;
+	TArray<FString> Path;
+	for (const FString& ModName : ModNames)
+	{
+		if (Remaining.Contains(ModName))
+		{
+			FindCycles(ModName, Remaining, State, Path, Order);
+			Order.Blocked.Add(ModName);
+		}
+	}
+	return Order;
+}
+
+void FModSkeletonModGraph::FindCycles(const FString& ModName, const TSet<FString>& Remaining, TMap<FString, int32>& State, TArray<FString>& Path, FModSkeletonModInitOrder& OutOrder) const
+{
+	int32& ModState = State.FindOrAdd(ModName);
+	if (ModState != 0)
+	{
+		return;
+	}
+	ModState = 1;
+	Path.Add(ModName);
+
+	for (const FString& Dependency : Dependencies.FindChecked(ModName))
+	{
+		if (!Remaining.Contains(Dependency))
+		{
+			continue;
+		}
+
+		const int32* DependencyState = State.Find(Dependency);
+		if (DependencyState != nullptr && *DependencyState == 1)
+		{
+			// Back on the current path: everything from Dependency onwards is the cycle
+			const int32 CycleStart = Path.Find(Dependency);
+			TArray<FString> Cycle(Path.GetData() + CycleStart, Path.Num() - CycleStart);
+			Cycle.Add(Dependency);
+			OutOrder.Cycles.Add(FString::Join(Cycle, TEXT(" -> ")));
+		}
+		else
+		{
+			FindCycles(Dependency, Remaining, State, Path, OutOrder);
+		}
+	}
+
+	Path.Pop(false);
+	State.FindChecked(ModName) = 2;
+}
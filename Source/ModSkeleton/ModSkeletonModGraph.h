@@ -0,0 +1,86 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+/**
+ * The order to ModSkeletonInit a set of mods in, worked out by FModSkeletonModGraph
+ */
+struct MODSKELETON_API FModSkeletonModInitOrder
+{
+	/**
+	 * Each wave only depends on mods in earlier waves, and is sorted by name
+	 */
+	TArray< TArray<FString> > Waves;
+
+	/**
+	 * "Mod -> Dependency" for every dependency that is neither in the graph nor already loaded. It is ignored.
+	 */
+	TArray<FString> MissingDependencies;
+
+	/**
+	 * Every dependency cycle found, as "A -> B -> A"
+	 */
+	TArray<FString> Cycles;
+
+	/**
+	 * Mods on a cycle or depending on one. They are left out of Waves.
+	 */
+	TArray<FString> Blocked;
+
+	/**
+	 * Every mod in Waves, wave by wave
+	 */
+	void GetOrderedMods(TArray<FString>& OutMods) const;
+
+	void Log() const;
+};
+
+/**
+ * Dependencies between mods, as declared by the "Dependencies" of each mod's manifest.
+ * Mods are initialized in topological waves: the first wave depends on nothing in the graph, each later wave only on
+ * the waves before it. Ties are broken by name, so the order does not depend on the order mods were found in.
+ */
+class MODSKELETON_API FModSkeletonModGraph
+{
+public:
+	/**
+	 * Add a mod, or replace the dependencies of one already added
+	 */
+	void AddMod(const FString& ModName, const TArray<FString>& Dependencies);
+
+	int32 Num() const
+	{
+		return Dependencies.Num();
+	}
+
+	/**
+	 * Dependencies declared by ModName, empty if it is not in the graph
+	 */
+	const TArray<FString>& GetDependencies(const FString& ModName) const;
+
+	/**
+	 * Dependencies on mods in AlreadyLoaded count as met, anything else outside the graph is reported missing
+	 */
+	FModSkeletonModInitOrder BuildInitOrder(const TSet<FString>& AlreadyLoaded) const;
+
+private:
+	/**
+	 * Record every cycle reachable from ModName through mods in Remaining. State is 0 unvisited, 1 on the path, 2 done.
+	 */
+	void FindCycles(const FString& ModName, const TSet<FString>& Remaining, TMap<FString, int32>& State, TArray<FString>& Path, FModSkeletonModInitOrder& OutOrder) const;
+
+	TMap< FString, TArray<FString> > Dependencies;
+};
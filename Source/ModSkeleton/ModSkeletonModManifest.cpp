@@ -0,0 +1,46 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ModSkeleton.h"
+#include "ModSkeletonModManifest.h"
+
+#include "Json.h"
+
+FString FModSkeletonModManifest::GetManifestFilename(const FString& PakFilename)
+{
+	return FPaths::GetPath(PakFilename) / FPaths::GetBaseFilename(PakFilename) + TEXT(".json");
+}
+
+bool FModSkeletonModManifest::LoadFromFile(const FString& Filename, FString& OutError)
+{
+	FString Contents;
+	if (!FPaths::FileExists(Filename) || !FFileHelper::LoadFileToString(Contents, *Filename))
+	{
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Contents);
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+	{
+		OutError = FString::Printf(TEXT("Malformed mod manifest: %s"), *Filename);
+		return true;
+	}
+
+	Root->TryGetBoolField(TEXT("EagerInit"), bEagerInit);
+	Root->TryGetStringArrayField(TEXT("Hooks"), Hooks);
+	Root->TryGetStringArrayField(TEXT("Dependencies"), Dependencies);
+	return true;
+}
@@ -0,0 +1,64 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+/**
+ * Optional per-mod metadata, read from "<ModName>.json" next to the mod's .pak and .bin in Content/Paks.
+ * It is readable without mounting the pak or loading any of the mod's classes:
+ *
+ *   {
+ *     "EagerInit": false,
+ *     "Hooks": [ "PopulateMainMenu", "ItemStats" ],
+ *     "Dependencies": [ "CoreItems" ]
+ *   }
+ *
+ * A mod with "EagerInit": false is not loaded during the scan. Its MOD_SKELETON plugins are loaded
+ * (and sent ModSkeletonInit) the first time one of the listed Hooks is invoked.
+ *
+ * Dependencies names other mods (by .pak name, without the extension) that must be sent ModSkeletonInit first.
+ */
+struct MODSKELETON_API FModSkeletonModManifest
+{
+	FModSkeletonModManifest()
+		: bEagerInit(true)
+	{
+	}
+
+	/**
+	 * Load and ModSkeletonInit this mod's plugins during the scan (the default)
+	 */
+	bool bEagerInit;
+
+	/**
+	 * Hooks this mod connects to (or handles as AlwaysInvoke hooks)
+	 */
+	TArray<FString> Hooks;
+
+	/**
+	 * Mods to initialize before this one
+	 */
+	TArray<FString> Dependencies;
+
+	/**
+	 * Path of the manifest for a mod pak
+	 */
+	static FString GetManifestFilename(const FString& PakFilename);
+
+	/**
+	 * Parse a manifest file. Returns false if it does not exist; OutError is set if it exists but is malformed.
+	 */
+	bool LoadFromFile(const FString& Filename, FString& OutError);
+};
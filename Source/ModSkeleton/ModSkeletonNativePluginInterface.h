@@ -0,0 +1,50 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "BPVariant.h"
+
+#include "ModSkeletonNativePluginInterface.generated.h"
+
+/**
+ * Native hook handler, see UModSkeletonRegistry::ConnectNativeHook
+ * HookIO is modified in place, and is passed on to the next handler afterwards.
+ */
+DECLARE_DELEGATE_TwoParams(FModSkeletonNativeHookDelegate, const FString&, TArray< FBPVariant >&);
+
+UINTERFACE(MinimalAPI, meta = (CannotImplementInterfaceInBlueprint))
+class UModSkeletonNativePluginInterface : public UInterface
+{
+	GENERATED_UINTERFACE_BODY()
+};
+
+/**
+ * C++ flavor of ModSkeletonValuePluginInterface.
+ * The registry calls ModSkeletonNativeHook as a plain virtual, so no ProcessEvent parameter frame is built or copied.
+ * Takes precedence over the other plugin interfaces if a class implements more than one.
+ */
+class MODSKELETON_API IModSkeletonNativePluginInterface
+{
+	GENERATED_IINTERFACE_BODY()
+
+public:
+
+	/**
+	 * Any "Connected" Hook that is invoked will invoke this function.
+	 * If your uclass begins with the case-sensitive string "MOD_SKELETON" then "ModSkeletonInit" will also be invoked.
+	 */
+	virtual void ModSkeletonNativeHook(const FString& HookName, TArray< FBPVariant >& HookIO) = 0;
+};
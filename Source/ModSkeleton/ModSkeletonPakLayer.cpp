@@ -0,0 +1,225 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include "ModSkeleton.h"
+#include "ModSkeletonPakLayer.h"
+
+#include "Runtime/PakFile/Public/IPlatformFilePak.h"
+
+FModSkeletonPakLayer& FModSkeletonPakLayer::Get()
+{
+	static FModSkeletonPakLayer Layer;
+	return Layer;
+}
+
+FModSkeletonPakLayer::FModSkeletonPakLayer()
+	: PakPlatform(nullptr)
+{
+}
+
+FPakPlatformFile* FModSkeletonPakLayer::GetPakPlatform()
+{
+	FScopeLock Lock(&CriticalSection);
+	if (PakPlatform != nullptr)
+	{
+		return PakPlatform;
+	}
+
+	check(IsInGameThread());
+	PakPlatform = static_cast<FPakPlatformFile*>(FPlatformFileManager::Get().FindPlatformFile(FPakPlatformFile::GetTypeName()));
+	if (PakPlatform != nullptr)
+	{
+		UE_LOG(ModSkeletonLog, Log, TEXT("Mounting mod paks into the existing pak platform layer"));
+		return PakPlatform;
+	}
+
+	// Never deleted: other layers may be installed on top of it, and open file handles point into it
+	IPlatformFile& InnerPlatform = FPlatformFileManager::Get().GetPlatformFile();
+	PakPlatform = new FPakPlatformFile();
+	PakPlatform->Initialize(&InnerPlatform, TEXT(""));
+	FPlatformFileManager::Get().SetPlatformFile(*PakPlatform);
+	UE_LOG(ModSkeletonLog, Log, TEXT("Installed the mod pak platform layer"));
+	return PakPlatform;
+}
+
+IPlatformFile* FModSkeletonPakLayer::GetLowerLevel()
+{
+	return GetPakPlatform()->GetLowerLevel();
+}
+
+bool FModSkeletonPakLayer::ReadPakFiles(IPlatformFile* LowerPlatform, const FString& PakFilename, TArray<FString>& OutRelativeFiles)
+{
+	OutRelativeFiles.Reset();
+	FPakFile PakFile(LowerPlatform, *PakFilename, false);
+	if (!PakFile.IsValid())
+	{
+		return false;
+	}
+
+	for (FPakFile::FFileIterator It(PakFile); It; ++It)
+	{
+		OutRelativeFiles.Add(It.Filename());
+	}
+	return true;
+}
+
+bool FModSkeletonPakLayer::Mount(const FString& PakFilename, const FString& MountPoint, FString& OutError)
+{
+	// Read the pak's directory for the index before taking the lock
+	TArray<FString> RelativeFiles;
+	if (!ReadPakFiles(GetLowerLevel(), PakFilename, RelativeFiles))
+	{
+		OutError = FString::Printf(TEXT("Invalid pak file: %s"), *PakFilename);
+		return false;
+	}
+	return Mount(PakFilename, MountPoint, RelativeFiles, OutError);
+}
+
+bool FModSkeletonPakLayer::Mount(const FString& PakFilename, const FString& MountPoint, const TArray<FString>& RelativeFiles, FString& OutError)
+{
+	FPakPlatformFile* Platform = GetPakPlatform();
+
+	// The pak layer resolves the pak's files relative to the directory it was mounted at
+	FMountedPak Pak;
+	Pak.MountPoint = MountPoint;
+	if (!Pak.MountPoint.EndsWith(TEXT("/")))
+	{
+		Pak.MountPoint += TEXT("/");
+	}
+	Pak.Files.Reserve(RelativeFiles.Num());
+	for (const FString& RelativeFile : RelativeFiles)
+	{
+		Pak.Files.Add(Pak.MountPoint + RelativeFile);
+	}
+
+	// Held across the mount, so two threads mounting the same pak can't both get past the check
+	FScopeLock Lock(&CriticalSection);
+	if (MountedPaks.Contains(PakFilename))
+	{
+		OutError = FString::Printf(TEXT("Pak file is already mounted: %s"), *PakFilename);
+		return false;
+	}
+
+	if (!Platform->Mount(*PakFilename, 0, *MountPoint))
+	{
+		OutError = FString::Printf(TEXT("Failed to mount pak file: %s"), *PakFilename);
+		return false;
+	}
+
+	IndexFiles(MountedPaks.Add(PakFilename, MoveTemp(Pak)), PakFilename);
+	return true;
+}
+
+bool FModSkeletonPakLayer::Unmount(const FString& PakFilename)
+{
+	FPakPlatformFile* Platform = GetPakPlatform();
+
+	FScopeLock Lock(&CriticalSection);
+	FMountedPak Pak;
+	if (!MountedPaks.RemoveAndCopyValue(PakFilename, Pak))
+	{
+		return false;
+	}
+	UnindexFiles(Pak, PakFilename);
+
+	if (!Platform->Unmount(*PakFilename))
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Pak platform layer did not have pak file mounted: %s"), *PakFilename);
+	}
+	return true;
+}
+
+bool FModSkeletonPakLayer::IsMounted(const FString& PakFilename) const
+{
+	FScopeLock Lock(&CriticalSection);
+	return MountedPaks.Contains(PakFilename);
+}
+
+bool FModSkeletonPakLayer::FindFile(const FString& Filename, FString& OutPakFilename) const
+{
+	FString FullFilename = Filename;
+	FPaths::MakeStandardFilename(FullFilename);
+
+	FScopeLock Lock(&CriticalSection);
+	const TArray<FString>* Owners = FileIndex.Find(Filename);
+	if (Owners == nullptr)
+	{
+		Owners = FileIndex.Find(FullFilename);
+	}
+	if (Owners == nullptr)
+	{
+		return false;
+	}
+	OutPakFilename = (*Owners)[0];
+	return true;
+}
+
+void FModSkeletonPakLayer::GetFiles(const FString& PakFilename, TArray<FString>& OutFiles) const
+{
+	FScopeLock Lock(&CriticalSection);
+	if (const FMountedPak* Pak = MountedPaks.Find(PakFilename))
+	{
+		OutFiles = Pak->Files;
+	}
+	else
+	{
+		OutFiles.Reset();
+	}
+}
+
+void FModSkeletonPakLayer::GetMountedPaks(TArray<FString>& OutPakFilenames) const
+{
+	FScopeLock Lock(&CriticalSection);
+	MountedPaks.GenerateKeyArray(OutPakFilenames);
+}
+
+int32 FModSkeletonPakLayer::GetNumIndexedFiles() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return FileIndex.Num();
+}
+
+void FModSkeletonPakLayer::IndexFiles(const FMountedPak& Pak, const FString& PakFilename)
+{
+	for (const FString& File : Pak.Files)
+	{
+		TArray<FString>& Owners = FileIndex.FindOrAdd(File);
+		if (Owners.Num() > 0)
+		{
+			UE_LOG(ModSkeletonLog, Verbose, TEXT("%s in %s is hidden by %s"), *File, *PakFilename, *Owners[0]);
+		}
+		Owners.Add(PakFilename);
+	}
+}
+
+void FModSkeletonPakLayer::UnindexFiles(const FMountedPak& Pak, const FString& PakFilename)
+{
+	for (const FString& File : Pak.Files)
+	{
+		TArray<FString>* Owners = FileIndex.Find(File);
+		if (Owners == nullptr)
+		{
+			continue;
+		}
+
+		// if this pak provided the file, whichever was mounted after it (if any) takes over
+		Owners->RemoveSingle(PakFilename);
+		if (Owners->Num() == 0)
+		{
+			FileIndex.Remove(File);
+		}
+	}
+}
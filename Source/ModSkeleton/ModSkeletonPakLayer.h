@@ -0,0 +1,116 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#pragma once
+
+class FPakPlatformFile;
+class IPlatformFile;
+
+/**
+ * The one pak platform layer mod paks are mounted into, shared by every registry in the process.
+ * The engine's own pak layer is reused if the game was started with one (as packaged games are), otherwise a layer is
+ * created and installed on first use. Either way it stays in the platform file chain for the lifetime of the process,
+ * so rescans never stack another layer in front of every file open.
+ *
+ * Alongside the pak layer it keeps a merged index of every file in a mounted mod pak, so finding the mod that provides
+ * a path (FindFile) is one hash lookup instead of a probe of every pak in turn. File opens themselves still go through
+ * the engine's pak layer, which checks each mounted pak in turn.
+ * Mount, Unmount and the lookups are thread safe. GetPakPlatform must first be called on the game thread.
+ */
+class MODSKELETON_API FModSkeletonPakLayer
+{
+public:
+	static FModSkeletonPakLayer& Get();
+
+	/**
+	 * The pak layer, found or installed on first call. Game thread only the first time.
+	 */
+	FPakPlatformFile* GetPakPlatform();
+
+	/**
+	 * The platform file below the pak layer, for reading pak files directly
+	 */
+	IPlatformFile* GetLowerLevel();
+
+	/**
+	 * Mount a pak at MountPoint and add its files to the index. Returns false, with OutError set, on failure.
+	 * Mod paks share one pak order, and the pak layer serves the first match among equal orders, so a file in
+	 * several mods is provided (and indexed) by the one mounted first.
+	 */
+	bool Mount(const FString& PakFilename, const FString& MountPoint, FString& OutError);
+
+	/**
+	 * Mount a pak whose file list was already read with ReadPakFiles, so its directory is not read twice
+	 */
+	bool Mount(const FString& PakFilename, const FString& MountPoint, const TArray<FString>& RelativeFiles, FString& OutError);
+
+	/**
+	 * Validate a pak and list its files, relative to wherever it is mounted. Returns false for an invalid pak.
+	 */
+	static bool ReadPakFiles(IPlatformFile* LowerPlatform, const FString& PakFilename, TArray<FString>& OutRelativeFiles);
+
+	/**
+	 * Unmount a pak mounted with Mount, and drop its files from the index. Returns false if it was not mounted.
+	 */
+	bool Unmount(const FString& PakFilename);
+
+	bool IsMounted(const FString& PakFilename) const;
+
+	/**
+	 * The pak providing Filename, or false if no mounted mod pak contains it
+	 */
+	bool FindFile(const FString& Filename, FString& OutPakFilename) const;
+
+	/**
+	 * Full paths of the files a mounted pak provides
+	 */
+	void GetFiles(const FString& PakFilename, TArray<FString>& OutFiles) const;
+
+	void GetMountedPaks(TArray<FString>& OutPakFilenames) const;
+
+	int32 GetNumIndexedFiles() const;
+
+private:
+	FModSkeletonPakLayer();
+
+	struct FMountedPak
+	{
+		FString MountPoint;
+		TArray<FString> Files;
+	};
+
+	/**
+	 * Append Pak to the owners of each of its files, or take it off them again
+	 */
+	void IndexFiles(const FMountedPak& Pak, const FString& PakFilename);
+	void UnindexFiles(const FMountedPak& Pak, const FString& PakFilename);
+
+	FPakPlatformFile* PakPlatform;
+
+	/**
+	 * Mounted mod paks, by pak filename
+	 */
+	TMap<FString, FMountedPak> MountedPaks;
+
+	/**
+	 * Full path of every file in a mounted mod pak to the paks providing it, in the order they were mounted.
+	 * The first one provides the file, and when it is unmounted the next one takes over.
+	 * A file is rarely in more than a couple of paks, so mounting and unmounting cost about one lookup per file.
+	 */
+	TMap< FString, TArray<FString> > FileIndex;
+
+	mutable FCriticalSection CriticalSection;
+};
@@ -0,0 +1,170 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include "ModSkeleton.h"
+#include "ModSkeletonPakWatcher.h"
+
+#include "DirectoryWatcherModule.h"
+#include "IDirectoryWatcher.h"
+
+static const FName DirectoryWatcherModuleName(TEXT("DirectoryWatcher"));
+
+static bool IsModPakFile(const FString& Filename)
+{
+	return Filename.EndsWith(TEXT(".pak")) || Filename.EndsWith(TEXT(".bin"));
+}
+
+FModSkeletonPakWatcher::FModSkeletonPakWatcher(const FString& InDirectory, float InDebounceSeconds, float InPollSeconds, FOnChanged InOnChanged)
+	: Directory(InDirectory)
+	, DebounceSeconds(FMath::Max(0.f, InDebounceSeconds))
+	, PollSeconds(FMath::Max(0.1f, InPollSeconds))
+	, OnChanged(MoveTemp(InOnChanged))
+	, bRefreshPending(false)
+	, LastChangeSeconds(0.0)
+	, NextPollSeconds(0.0)
+{
+	check(IsInGameThread());
+	ListFiles(KnownFiles);
+
+	// DirectoryWatcher is a developer module, it is not there in every build
+	FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::LoadModulePtr<FDirectoryWatcherModule>(DirectoryWatcherModuleName);
+	IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule != nullptr ? DirectoryWatcherModule->Get() : nullptr;
+	if (DirectoryWatcher == nullptr || !DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(Directory, IDirectoryWatcher::FDirectoryChanged::CreateRaw(this, &FModSkeletonPakWatcher::OnDirectoryChanged), WatcherHandle))
+	{
+		WatcherHandle.Reset();
+	}
+
+	UE_LOG(ModSkeletonLog, Log, TEXT("Watching for mod paks in %s (%s)"), *Directory,
+		IsUsingDirectoryWatcher() ? TEXT("directory watcher") : *FString::Printf(TEXT("polling every %.1fs"), PollSeconds));
+	NextPollSeconds = FPlatformTime::Seconds() + PollSeconds;
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FModSkeletonPakWatcher::Tick));
+}
+
+FModSkeletonPakWatcher::~FModSkeletonPakWatcher()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	if (WatcherHandle.IsValid())
+	{
+		// may already be gone at shutdown
+		if (FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>(DirectoryWatcherModuleName))
+		{
+			if (IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule->Get())
+			{
+				DirectoryWatcher->UnregisterDirectoryChangedCallback_Handle(Directory, WatcherHandle);
+			}
+		}
+	}
+}
+
+bool FModSkeletonPakWatcher::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (IsUsingDirectoryWatcher())
+	{
+		// The editor ticks the directory watcher, a game has to do it itself
+		if (!GIsEditor)
+		{
+			if (FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>(DirectoryWatcherModuleName))
+			{
+				DirectoryWatcherModule->Get()->Tick(DeltaTime);
+			}
+		}
+		if (bRefreshPending && Now - LastChangeSeconds >= DebounceSeconds)
+		{
+			bRefreshPending = false;
+			Refresh();
+		}
+	}
+	else if (Now >= NextPollSeconds)
+	{
+		// a file still being written differs on every poll, wait until one finds it settled
+		NextPollSeconds = Now + PollSeconds;
+		if (Refresh())
+		{
+			LastChangeSeconds = Now;
+		}
+	}
+
+	if (PendingFiles.Num() > 0 && Now - LastChangeSeconds >= DebounceSeconds)
+	{
+		TArray<FString> ChangedFiles = PendingFiles.Array();
+		ChangedFiles.Sort();
+		if (OnChanged(ChangedFiles))
+		{
+			PendingFiles.Reset();
+		}
+	}
+	return true;
+}
+
+void FModSkeletonPakWatcher::OnDirectoryChanged(const TArray<FFileChangeData>& Changes)
+{
+	// The events only say something happened, Refresh works out what once they stop
+	for (const FFileChangeData& Change : Changes)
+	{
+		if (IsModPakFile(Change.Filename))
+		{
+			bRefreshPending = true;
+			LastChangeSeconds = FPlatformTime::Seconds();
+		}
+	}
+}
+
+void FModSkeletonPakWatcher::ListFiles(TMap<FString, FFileKey>& OutFiles) const
+{
+	OutFiles.Reset();
+	IFileManager::Get().IterateDirectoryStat(*Directory, [&OutFiles](const TCHAR* FilenameOrDirectory, const FFileStatData& StatData)
+	{
+		FString Filename(FilenameOrDirectory);
+		if (!StatData.bIsDirectory && IsModPakFile(Filename))
+		{
+			FPaths::MakeStandardFilename(Filename);
+			FFileKey& Key = OutFiles.Add(Filename);
+			Key.Size = StatData.FileSize;
+			Key.Timestamp = StatData.ModificationTime;
+		}
+		return true;
+	});
+}
+
+bool FModSkeletonPakWatcher::Refresh()
+{
+	TMap<FString, FFileKey> CurrentFiles;
+	ListFiles(CurrentFiles);
+
+	bool bChanged = false;
+	for (const auto& Current : CurrentFiles)
+	{
+		const FFileKey* Known = KnownFiles.Find(Current.Key);
+		if (Known == nullptr || !(*Known == Current.Value))
+		{
+			PendingFiles.Add(Current.Key);
+			bChanged = true;
+		}
+	}
+	for (const auto& Known : KnownFiles)
+	{
+		if (!CurrentFiles.Contains(Known.Key))
+		{
+			PendingFiles.Add(Known.Key);
+			bChanged = true;
+		}
+	}
+	KnownFiles = MoveTemp(CurrentFiles);
+	return bChanged;
+}
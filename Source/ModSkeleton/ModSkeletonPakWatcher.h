@@ -0,0 +1,87 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#pragma once
+
+#include "Containers/Ticker.h"
+
+struct FFileChangeData;
+
+/**
+ * Watches a directory for added, changed or removed .pak / .bin files.
+ * Uses the engine's DirectoryWatcher module (inotify on Linux) where it can be loaded, and polls the directory otherwise.
+ * Changes are collected until none have arrived for DebounceSeconds, so a mod still being copied is reported once,
+ * then passed to OnChanged on the game thread. If OnChanged returns false the same files are offered again on a later tick.
+ */
+class MODSKELETON_API FModSkeletonPakWatcher
+{
+public:
+	typedef TFunction<bool(const TArray<FString>& ChangedFiles)> FOnChanged;
+
+	FModSkeletonPakWatcher(const FString& InDirectory, float InDebounceSeconds, float InPollSeconds, FOnChanged InOnChanged);
+	~FModSkeletonPakWatcher();
+
+	/**
+	 * False if the directory is being polled every PollSeconds instead
+	 */
+	bool IsUsingDirectoryWatcher() const
+	{
+		return WatcherHandle.IsValid();
+	}
+
+private:
+	struct FFileKey
+	{
+		int64 Size;
+		FDateTime Timestamp;
+
+		bool operator==(const FFileKey& Other) const
+		{
+			return Size == Other.Size && Timestamp == Other.Timestamp;
+		}
+	};
+
+	bool Tick(float DeltaTime);
+	void OnDirectoryChanged(const TArray<FFileChangeData>& Changes);
+
+	/**
+	 * Current .pak / .bin files in Directory
+	 */
+	void ListFiles(TMap<FString, FFileKey>& OutFiles) const;
+
+	/**
+	 * Compare the directory against KnownFiles, adding every difference to PendingFiles. Returns true if there were any.
+	 */
+	bool Refresh();
+
+	FString Directory;
+	float DebounceSeconds;
+	float PollSeconds;
+	FOnChanged OnChanged;
+
+	FDelegateHandle WatcherHandle;
+	FDelegateHandle TickerHandle;
+
+	TMap<FString, FFileKey> KnownFiles;
+	TSet<FString> PendingFiles;
+
+	/**
+	 * Set by a directory watcher event, the directory is then compared with KnownFiles once things are quiet
+	 */
+	bool bRefreshPending;
+	double LastChangeSeconds;
+	double NextPollSeconds;
+};
@@ -0,0 +1,181 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ModSkeleton.h"
+#include "ModSkeletonPluginLoader.h"
+
+FModSkeletonPluginLoader::FModSkeletonPluginLoader(const TArray<FName>& ObjectPaths, int32 InMaxConcurrentLoads, FOnLoaded InOnLoaded, FOnComplete InOnComplete)
+	: MaxConcurrentLoads(InMaxConcurrentLoads > 0 ? InMaxConcurrentLoads : MAX_int32)
+	, OnLoaded(MoveTemp(InOnLoaded))
+	, OnComplete(MoveTemp(InOnComplete))
+	, NextToIssue(0)
+	, NextToInit(0)
+	, InFlight(0)
+	, MaxInFlight(0)
+	, bIssuing(false)
+	, bInitializing(false)
+	, bComplete(false)
+	, StartSeconds(0.0)
+{
+	Requests.SetNum(ObjectPaths.Num());
+	for (int32 i = 0; i < ObjectPaths.Num(); ++i)
+	{
+		Requests[i].ObjectPath = ObjectPaths[i];
+		Requests[i].PackageName = FPackageName::ObjectPathToPackageName(ObjectPaths[i].ToString());
+	}
+}
+
+void FModSkeletonPluginLoader::Start()
+{
+	check(IsInGameThread());
+	StartSeconds = FPlatformTime::Seconds();
+	IssueLoads();
+	InitLoaded();
+}
+
+void FModSkeletonPluginLoader::WaitUntilComplete()
+{
+	// From inside our own OnLoaded, the plugin being initialized could never finish
+	check(!bInitializing);
+
+	// Keep ourselves alive, OnComplete may release the last outside reference
+	TSharedRef<FModSkeletonPluginLoader> Self = AsShared();
+	while (!bComplete)
+	{
+		// Waiting on the plugin that is next in order lets every load in flight progress meanwhile
+		const int32 Index = NextToInit;
+		FlushAsyncLoading(Requests[Index].RequestId);
+
+		// Normally the completion callback has run by now, don't spin if it has not
+		if (!Requests[Index].bLoaded)
+		{
+			OnPackageLoaded(Index, EAsyncLoadingResult::Failed);
+		}
+	}
+}
+
+void FModSkeletonPluginLoader::IssueLoads()
+{
+	// A completion callback can fire from inside LoadPackageAsync, and would call back in here
+	if (bIssuing)
+	{
+		return;
+	}
+	TGuardValue<bool> IssuingGuard(bIssuing, true);
+
+	TSharedRef<FModSkeletonPluginLoader> Self = AsShared();
+	while (NextToIssue < Requests.Num() && InFlight < MaxConcurrentLoads)
+	{
+		const int32 Index = NextToIssue++;
+		FRequest& Request = Requests[Index];
+		Request.IssueSeconds = FPlatformTime::Seconds();
+		++InFlight;
+		MaxInFlight = FMath::Max(MaxInFlight, InFlight);
+
+		// the delegate holds a reference, so the loader lives until its last load has completed
+		const int32 RequestId = LoadPackageAsync(Request.PackageName, FLoadPackageAsyncDelegate::CreateLambda([Self, Index](const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result)
+		{
+			Self->OnPackageLoaded(Index, Result);
+		}));
+
+		Requests[Index].RequestId = RequestId;
+	}
+}
+
+void FModSkeletonPluginLoader::OnPackageLoaded(int32 Index, EAsyncLoadingResult::Type Result)
+{
+	FRequest& Request = Requests[Index];
+	if (Request.bLoaded)
+	{
+		return;
+	}
+	Request.bLoaded = true;
+	Request.LoadedSeconds = FPlatformTime::Seconds();
+	--InFlight;
+
+	if (Result == EAsyncLoadingResult::Succeeded)
+	{
+		const FString ClassPath = Request.ObjectPath.ToString() + TEXT("_C");
+		Request.PluginClass = FindObject<UClass>(nullptr, *ClassPath);
+		if (Request.PluginClass == nullptr)
+		{
+			// redirected or renamed asset, let the synchronous path resolve it
+			Request.PluginClass = LoadObject<UClass>(nullptr, *(TEXT("Class'") + ClassPath + TEXT("'")));
+		}
+	}
+	if (Request.PluginClass == nullptr)
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Failed to load MOD_SKELETON plugin class: %s"), *Request.ObjectPath.ToString());
+	}
+
+	IssueLoads();
+	InitLoaded();
+}
+
+void FModSkeletonPluginLoader::InitLoaded()
+{
+	// OnLoaded runs ModSkeletonInit, which may block on other loads and so complete more of ours
+	if (bInitializing)
+	{
+		return;
+	}
+	TGuardValue<bool> InitializingGuard(bInitializing, true);
+
+	TSharedRef<FModSkeletonPluginLoader> Self = AsShared();
+	while (NextToInit < Requests.Num() && Requests[NextToInit].bLoaded)
+	{
+		FRequest& Request = Requests[NextToInit++];
+		Request.InitSeconds = FPlatformTime::Seconds();
+		OnLoaded(Request.ObjectPath, Request.PluginClass);
+	}
+
+	if (NextToInit == Requests.Num() && !bComplete)
+	{
+		bComplete = true;
+		LogReport();
+		OnComplete();
+	}
+}
+
+void FModSkeletonPluginLoader::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	// Only those not yet handed to OnLoaded, which owns them from then on
+	for (int32 i = NextToInit; i < Requests.Num(); ++i)
+	{
+		Collector.AddReferencedObject(Requests[i].PluginClass);
+	}
+}
+
+void FModSkeletonPluginLoader::LogReport() const
+{
+	if (Requests.Num() == 0)
+	{
+		return;
+	}
+
+	UE_LOG(ModSkeletonLog, Log, TEXT("Loaded %d MOD_SKELETON plugin classes in %.1fms, at most %d loads in flight. Init order:"),
+		Requests.Num(), (FPlatformTime::Seconds() - StartSeconds) * 1000.0, MaxInFlight);
+	for (int32 i = 0; i < Requests.Num(); ++i)
+	{
+		const FRequest& Request = Requests[i];
+		if (Request.PluginClass == nullptr)
+		{
+			UE_LOG(ModSkeletonLog, Log, TEXT(" %4d. %s - failed to load"), i + 1, *Request.ObjectPath.ToString());
+			continue;
+		}
+		UE_LOG(ModSkeletonLog, Log, TEXT(" %4d. %s - loaded in %.1fms, waited %.1fms for earlier plugins"), i + 1, *Request.ObjectPath.ToString(),
+			(Request.LoadedSeconds - Request.IssueSeconds) * 1000.0, (Request.InitSeconds - Request.LoadedSeconds) * 1000.0);
+	}
+}
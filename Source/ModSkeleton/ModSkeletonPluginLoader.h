@@ -0,0 +1,105 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+/**
+ * Streams in the classes of MOD_SKELETON plugins through the async package loader, up to MaxConcurrentLoads at a time,
+ * so the I/O of different mods overlaps instead of each LoadObject blocking on one mod before the next is asked for.
+ *
+ * OnLoaded is called on the game thread for every plugin in the order the paths were given (with a nullptr class if
+ * it failed to load), as soon as that plugin and every one before it has loaded. Init order is therefore the same from
+ * run to run however the loads complete. OnComplete is called once after the last OnLoaded.
+ * A class that has loaded but is still waiting for earlier plugins is referenced, so garbage collection in between
+ * frames cannot take it.
+ */
+class MODSKELETON_API FModSkeletonPluginLoader : public TSharedFromThis<FModSkeletonPluginLoader>, public FGCObject
+{
+public:
+	typedef TFunction<void(const FName& ObjectPath, UClass* PluginClass)> FOnLoaded;
+	typedef TFunction<void()> FOnComplete;
+
+	/**
+	 * MaxConcurrentLoads of 0 or less issues every load at once
+	 */
+	FModSkeletonPluginLoader(const TArray<FName>& ObjectPaths, int32 InMaxConcurrentLoads, FOnLoaded InOnLoaded, FOnComplete InOnComplete);
+
+	/**
+	 * Issue the first loads. Game thread only.
+	 */
+	void Start();
+
+	/**
+	 * Block until every plugin has been passed to OnLoaded, still keeping MaxConcurrentLoads in flight
+	 */
+	void WaitUntilComplete();
+
+	bool IsComplete() const
+	{
+		return bComplete;
+	}
+
+	/**
+	 * Log every plugin in init order, with how long it took to load and how long it then waited for those before it
+	 */
+	void LogReport() const;
+
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+private:
+	struct FRequest
+	{
+		FRequest()
+			: RequestId(INDEX_NONE)
+			, PluginClass(nullptr)
+			, bLoaded(false)
+			, IssueSeconds(0.0)
+			, LoadedSeconds(0.0)
+			, InitSeconds(0.0)
+		{
+		}
+
+		FName ObjectPath;
+		FString PackageName;
+		int32 RequestId;
+		UClass* PluginClass;
+		bool bLoaded;
+		double IssueSeconds;
+		double LoadedSeconds;
+		double InitSeconds;
+	};
+
+	void IssueLoads();
+	void OnPackageLoaded(int32 Index, EAsyncLoadingResult::Type Result);
+
+	/**
+	 * Pass every loaded plugin that is next in order to OnLoaded
+	 */
+	void InitLoaded();
+
+	TArray<FRequest> Requests;
+	int32 MaxConcurrentLoads;
+	FOnLoaded OnLoaded;
+	FOnComplete OnComplete;
+
+	int32 NextToIssue;
+	int32 NextToInit;
+	int32 InFlight;
+	int32 MaxInFlight;
+	bool bIssuing;
+	bool bInitializing;
+	bool bComplete;
+	double StartSeconds;
+};
@@ -0,0 +1,207 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ModSkeleton.h"
+#include "ModSkeletonProfiler.h"
+
+#if MODSKELETON_PROFILING
+
+DEFINE_STAT(STAT_ModSkeletonInvokeHook);
+DEFINE_STAT(STAT_ModSkeletonInitModPlugins);
+DEFINE_STAT(STAT_ModSkeletonBroadcastNative);
+DEFINE_STAT(STAT_ModSkeletonPluginCalls);
+DEFINE_STAT(STAT_ModSkeletonVariantAllocations);
+DEFINE_STAT(STAT_ModSkeletonValueNodeAllocations);
+DEFINE_STAT(STAT_ModSkeletonPureCacheHits);
+DEFINE_STAT(STAT_ModSkeletonPureCacheMisses);
+
+static FAutoConsoleCommand ModSkeletonProfileDumpCommand(
+	TEXT("ModSkeleton.Profile.Dump"),
+	TEXT("Log per hook / plugin call counts and timings, slowest first"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FModSkeletonProfiler::Get().Dump();
+	}));
+
+static FAutoConsoleCommand ModSkeletonProfileWriteCsvCommand(
+	TEXT("ModSkeleton.Profile.WriteCsv"),
+	TEXT("Write per hook / plugin call counts and timings to a CSV file. Optional argument: output filename"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FModSkeletonProfiler::Get().WriteCsv(Args.Num() > 0 ? Args[0] : FString());
+	}));
+
+static FAutoConsoleCommand ModSkeletonProfileResetCommand(
+	TEXT("ModSkeleton.Profile.Reset"),
+	TEXT("Clear all ModSkeleton hook profiling counters"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FModSkeletonProfiler::Get().Reset();
+	}));
+
+void FModSkeletonHookProfile::AddSample(double Seconds, int32 Allocations)
+{
+	++Calls;
+	TotalSeconds += Seconds;
+	MaxSeconds = FMath::Max(MaxSeconds, Seconds);
+	VariantAllocations += Allocations;
+
+	// ring buffer, so percentiles follow recent behaviour without unbounded memory
+	if (Samples.Num() < MaxSamples)
+	{
+		Samples.Add(static_cast<float>(Seconds));
+	}
+	else
+	{
+		Samples[NextSample] = static_cast<float>(Seconds);
+		NextSample = (NextSample + 1) % MaxSamples;
+	}
+}
+
+double FModSkeletonHookProfile::GetPercentileSeconds(float Percentile) const
+{
+	if (Samples.Num() == 0)
+	{
+		return 0.0;
+	}
+
+	TArray<float> Sorted = Samples;
+	Sorted.Sort();
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile / 100.f * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+	return Sorted[Index];
+}
+
+FModSkeletonProfiler& FModSkeletonProfiler::Get()
+{
+	static FModSkeletonProfiler Profiler;
+	return Profiler;
+}
+
+TSharedRef<FModSkeletonHookProfile> FModSkeletonProfiler::FindOrAdd(const FName& HookName, const UObject* Plugin)
+{
+	FProfileKey Key;
+	Key.HookName = HookName;
+	Key.Plugin = FObjectKey(Plugin);
+
+	if (const TSharedRef<FModSkeletonHookProfile>* Existing = Profiles.Find(Key))
+	{
+		return *Existing;
+	}
+
+	TSharedRef<FModSkeletonHookProfile> Profile = MakeShareable(new FModSkeletonHookProfile());
+	Profile->HookName = HookName.ToString();
+	// Every mod's plugin class is called MOD_SKELETON_C, the package path is what tells them apart
+	// Native handlers that are not bound to a UObject are all reported together
+	Profile->PluginName = Plugin != nullptr ? Plugin->GetClass()->GetPathName() : TEXT("Native");
+#if STATS
+	Profile->StatId = FDynamicStats::CreateStatId<FStatGroup_STATGROUP_ModSkeleton>(Profile->HookName + TEXT(" - ") + Profile->PluginName);
+#endif
+	Profiles.Add(Key, Profile);
+	return Profile;
+}
+
+void FModSkeletonProfiler::Reset()
+{
+	Profiles.Reset();
+}
+
+void FModSkeletonProfiler::GetSortedProfiles(TArray<const FModSkeletonHookProfile*>& OutProfiles) const
+{
+	OutProfiles.Reset(Profiles.Num());
+	for (const auto& Pair : Profiles)
+	{
+		OutProfiles.Add(&Pair.Value.Get());
+	}
+	OutProfiles.Sort([](const FModSkeletonHookProfile& A, const FModSkeletonHookProfile& B)
+	{
+		return A.TotalSeconds > B.TotalSeconds;
+	});
+}
+
+void FModSkeletonProfiler::Dump() const
+{
+	TArray<const FModSkeletonHookProfile*> Sorted;
+	GetSortedProfiles(Sorted);
+
+	UE_LOG(ModSkeletonLog, Log, TEXT("ModSkeleton hook profile, %d hook / plugin pairs (times in ms):"), Sorted.Num());
+	UE_LOG(ModSkeletonLog, Log, TEXT("%8s %10s %8s %8s %8s %8s %8s  %s / %s"), TEXT("Calls"), TEXT("Total"), TEXT("Avg"), TEXT("P50"), TEXT("P95"), TEXT("Max"), TEXT("Allocs"), TEXT("Hook"), TEXT("Plugin"));
+	for (const FModSkeletonHookProfile* Profile : Sorted)
+	{
+		UE_LOG(ModSkeletonLog, Log, TEXT("%8d %10.3f %8.3f %8.3f %8.3f %8.3f %8d  %s / %s"),
+			Profile->Calls,
+			Profile->TotalSeconds * 1000.0,
+			Profile->TotalSeconds * 1000.0 / FMath::Max(Profile->Calls, 1),
+			Profile->GetPercentileSeconds(50.f) * 1000.0,
+			Profile->GetPercentileSeconds(95.f) * 1000.0,
+			Profile->MaxSeconds * 1000.0,
+			Profile->VariantAllocations,
+			*Profile->HookName,
+			*Profile->PluginName);
+	}
+}
+
+bool FModSkeletonProfiler::WriteCsv(const FString& Filename) const
+{
+	FString OutFilename = Filename;
+	if (OutFilename.IsEmpty())
+	{
+		OutFilename = FPaths::ProfilingDir() / TEXT("ModSkeleton") / FString::Printf(TEXT("HookProfile-%s.csv"), *FDateTime::Now().ToString());
+	}
+
+	TArray<const FModSkeletonHookProfile*> Sorted;
+	GetSortedProfiles(Sorted);
+
+	FString Csv = TEXT("Hook,Plugin,Calls,TotalMs,AvgMs,P50Ms,P95Ms,P99Ms,MaxMs,VariantAllocations\n");
+	for (const FModSkeletonHookProfile* Profile : Sorted)
+	{
+		Csv += FString::Printf(TEXT("%s,%s,%d,%f,%f,%f,%f,%f,%f,%d\n"),
+			*Profile->HookName,
+			*Profile->PluginName,
+			Profile->Calls,
+			Profile->TotalSeconds * 1000.0,
+			Profile->TotalSeconds * 1000.0 / FMath::Max(Profile->Calls, 1),
+			Profile->GetPercentileSeconds(50.f) * 1000.0,
+			Profile->GetPercentileSeconds(95.f) * 1000.0,
+			Profile->GetPercentileSeconds(99.f) * 1000.0,
+			Profile->MaxSeconds * 1000.0,
+			Profile->VariantAllocations);
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *OutFilename))
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Failed to write hook profile: %s"), *OutFilename);
+		return false;
+	}
+	UE_LOG(ModSkeletonLog, Log, TEXT("Wrote hook profile: %s"), *OutFilename);
+	return true;
+}
+
+FModSkeletonPluginCallScope::FModSkeletonPluginCallScope(const FName& HookName, const UObject* Plugin)
+	: Profile(FModSkeletonProfiler::Get().FindOrAdd(HookName, Plugin))
+	, StartSeconds(FPlatformTime::Seconds())
+	, StartAllocations(FModSkeletonProfiler::Get().GetVariantAllocations())
+#if STATS
+	, CycleCounter(Profile->StatId)
+#endif
+{
+	INC_DWORD_STAT(STAT_ModSkeletonPluginCalls);
+}
+
+FModSkeletonPluginCallScope::~FModSkeletonPluginCallScope()
+{
+	Profile->AddSample(FPlatformTime::Seconds() - StartSeconds, FModSkeletonProfiler::Get().GetVariantAllocations() - StartAllocations);
+}
+
+#endif
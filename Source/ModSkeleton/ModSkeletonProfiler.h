@@ -0,0 +1,215 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "UObject/ObjectKey.h"
+
+/**
+ * Per (hook, plugin) timing of every plugin invocation. Compiled out of Shipping builds.
+ *
+ * Console commands:
+ *   stat ModSkeleton                    - live totals, plus one cycle counter per hook / plugin pair
+ *   ModSkeleton.Profile.Dump            - log a table of every pair, slowest total time first
+ *   ModSkeleton.Profile.WriteCsv [File] - write the same table to Saved/Profiling/ModSkeleton/
+ *   ModSkeleton.Profile.Reset           - clear all counters
+ */
+#ifndef MODSKELETON_PROFILING
+#define MODSKELETON_PROFILING !UE_BUILD_SHIPPING
+#endif
+
+#if MODSKELETON_PROFILING
+
+DECLARE_STATS_GROUP(TEXT("ModSkeleton"), STATGROUP_ModSkeleton, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("InvokeHook"), STAT_ModSkeletonInvokeHook, STATGROUP_ModSkeleton, MODSKELETON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("InitModPlugins"), STAT_ModSkeletonInitModPlugins, STATGROUP_ModSkeleton, MODSKELETON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast Native Handlers"), STAT_ModSkeletonBroadcastNative, STATGROUP_ModSkeleton, MODSKELETON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Plugin Calls"), STAT_ModSkeletonPluginCalls, STATGROUP_ModSkeleton, MODSKELETON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("UBPVariant Allocations"), STAT_ModSkeletonVariantAllocations, STATGROUP_ModSkeleton, MODSKELETON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("FBPVariant Node Allocations"), STAT_ModSkeletonValueNodeAllocations, STATGROUP_ModSkeleton, MODSKELETON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pure Cache Hits"), STAT_ModSkeletonPureCacheHits, STATGROUP_ModSkeleton, MODSKELETON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pure Cache Misses"), STAT_ModSkeletonPureCacheMisses, STATGROUP_ModSkeleton, MODSKELETON_API);
+
+/**
+ * Everything recorded for one (hook, plugin) pair
+ */
+struct MODSKELETON_API FModSkeletonHookProfile
+{
+	FModSkeletonHookProfile()
+		: Calls(0)
+		, TotalSeconds(0.0)
+		, MaxSeconds(0.0)
+		, VariantAllocations(0)
+		, NextSample(0)
+	{
+	}
+
+	FString HookName;
+	FString PluginName;
+
+	int32 Calls;
+
+	/**
+	 * Inclusive of any hooks the plugin invoked in turn
+	 */
+	double TotalSeconds;
+	double MaxSeconds;
+
+	/**
+	 * UBPVariants created (pooled or not) while the plugin was running
+	 */
+	int32 VariantAllocations;
+
+	/**
+	 * The most recent MaxSamples call durations, used for percentiles
+	 */
+	TArray<float> Samples;
+	int32 NextSample;
+
+#if STATS
+	TStatId StatId;
+#endif
+
+	static const int32 MaxSamples = 1024;
+
+	void AddSample(double Seconds, int32 Allocations);
+
+	/**
+	 * Call duration at Percentile (0 - 100) over the retained samples
+	 */
+	double GetPercentileSeconds(float Percentile) const;
+};
+
+/**
+ * Collects FModSkeletonHookProfiles. Game thread only, like hook dispatch itself.
+ */
+class MODSKELETON_API FModSkeletonProfiler
+{
+public:
+	static FModSkeletonProfiler& Get();
+
+	/**
+	 * Keyed on the FName the hook entry already holds, so a plugin call does no string or name table work
+	 */
+	TSharedRef<FModSkeletonHookProfile> FindOrAdd(const FName& HookName, const UObject* Plugin);
+
+	void Reset();
+
+	/**
+	 * All profiles, highest TotalSeconds first
+	 */
+	void GetSortedProfiles(TArray<const FModSkeletonHookProfile*>& OutProfiles) const;
+
+	void Dump() const;
+
+	/**
+	 * Write every profile to Filename, or to a timestamped file under Saved/Profiling/ModSkeleton/ if it is empty
+	 */
+	bool WriteCsv(const FString& Filename) const;
+
+	void CountVariantAllocation()
+	{
+		// only hook dispatch is profiled, and that happens on the game thread
+		if (!IsInGameThread())
+		{
+			return;
+		}
+		++VariantAllocations;
+		INC_DWORD_STAT(STAT_ModSkeletonVariantAllocations);
+	}
+
+	/**
+	 * Running total, sampled around each plugin call. Not cleared by Reset, so calls in flight stay consistent.
+	 */
+	int32 GetVariantAllocations() const
+	{
+		return VariantAllocations;
+	}
+
+	/**
+	 * FBPVariant array / map / packed array nodes, new or copied on write. Counted on any thread.
+	 */
+	void CountValueNodeAllocation()
+	{
+		ValueNodeAllocations.Increment();
+		INC_DWORD_STAT(STAT_ModSkeletonValueNodeAllocations);
+	}
+
+	int32 GetValueNodeAllocations() const
+	{
+		return ValueNodeAllocations.GetValue();
+	}
+
+private:
+	FModSkeletonProfiler()
+		: VariantAllocations(0)
+	{
+	}
+
+	struct FProfileKey
+	{
+		FName HookName;
+		FObjectKey Plugin;
+
+		bool operator==(const FProfileKey& Other) const
+		{
+			return HookName == Other.HookName && Plugin == Other.Plugin;
+		}
+
+		friend uint32 GetTypeHash(const FProfileKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.HookName), GetTypeHash(Key.Plugin));
+		}
+	};
+
+	/**
+	 * Shared so a call scope keeps its profile even if a nested call grows the map, or it is Reset mid-call
+	 */
+	TMap<FProfileKey, TSharedRef<FModSkeletonHookProfile>> Profiles;
+
+	int32 VariantAllocations;
+	FThreadSafeCounter ValueNodeAllocations;
+};
+
+/**
+ * Times one plugin invocation into its FModSkeletonHookProfile
+ */
+class MODSKELETON_API FModSkeletonPluginCallScope
+{
+public:
+	FModSkeletonPluginCallScope(const FName& HookName, const UObject* Plugin);
+	~FModSkeletonPluginCallScope();
+
+private:
+	TSharedRef<FModSkeletonHookProfile> Profile;
+	double StartSeconds;
+	int32 StartAllocations;
+#if STATS
+	FScopeCycleCounter CycleCounter;
+#endif
+};
+
+#define MODSKELETON_PROFILE_PLUGIN_CALL(HookName, Plugin) FModSkeletonPluginCallScope ModSkeletonPluginCallScope(HookName, Plugin)
+#define MODSKELETON_COUNT_VARIANT_ALLOCATION() FModSkeletonProfiler::Get().CountVariantAllocation()
+#define MODSKELETON_COUNT_VALUE_NODE_ALLOCATION() FModSkeletonProfiler::Get().CountValueNodeAllocation()
+
+#else
+
+#define MODSKELETON_PROFILE_PLUGIN_CALL(HookName, Plugin)
+#define MODSKELETON_COUNT_VARIANT_ALLOCATION()
+#define MODSKELETON_COUNT_VALUE_NODE_ALLOCATION()
+
+#endif
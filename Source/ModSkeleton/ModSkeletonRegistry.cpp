@@ -21,243 +21,1858 @@
 #include "Runtime/PakFile/Public/IPlatformFilePak.h"
 
 #include "AssetRegistryModule.h"
+#include "Interfaces/IPluginManager.h"
+
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
 
 #include "ModSkeletonPluginInterface.h"
+#include "ModSkeletonValuePluginInterface.h"
+#include "ModSkeletonNativePluginInterface.h"
+#include "ModSkeletonScanCache.h"
+#include "ModSkeletonPakLayer.h"
+#include "ModSkeletonPakWatcher.h"
+#include "ModSkeletonPluginLoader.h"
+#include "ModSkeletonModGraph.h"
+#include "ModSkeletonProfiler.h"
 
-UModSkeletonRegistry::UModSkeletonRegistry()
+/**
+ * UnmountMod renames the packages of an unloaded mod into this path
+ */
+static const TCHAR* UnloadedModPackagePrefix = TEXT("/Temp/ModSkeletonUnloaded_");
+
+static EBPVariantType GetHookIOElementType(const FBPVariant& Value)
 {
-	FModSkeletonHookDescription InitHook;
-	InitHook.AlwaysInvoke = true;
-	InitHook.HookName = "ModSkeletonInit";
-	InitHook.HookDescription = "ModSkeleton Bootstrap Entrypoint. This will be invoked on every Mod as they are loaded.";
+	return Value.GetType();
+}
 
-	InstallHook(InitHook);
+static EBPVariantType GetHookIOElementType(const UBPVariant* Variant)
+{
+	return Variant != nullptr ? Variant->GetType() : EBPVariantType::VT_None;
 }
 
-void UModSkeletonRegistry::ScanForModPlugins()
+/**
+ * False, with an error and an ensure, if HookIO does not match the HookIOTypes Schema of HookName
+ */
+template <typename ElementType>
+static bool MatchesHookIOTypes(const FString& HookName, const TArray< EBPVariantType >& Schema, const TArray< ElementType >& HookIO, const TCHAR* Boundary)
 {
-	FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	IAssetRegistry& AssetRegistry = AssetRegistryModule.Get();
+	if (Schema.Num() == 0)
+	{
+		return true;
+	}
 
-	// Uncomment this and the "PakPlatform->IterateDirectoryRecursively" below to dump out pak contents on load
-	//struct StructDumpVisitor : public IPlatformFile::FDirectoryVisitor
-	//{
-	//	virtual bool Visit(const TCHAR* FilenameOrDirectory, bool bIsDirectory)
-	//	{
-	//		if (bIsDirectory)
-	//		{
-	//			UE_LOG(ModSkeletonLog, Log, TEXT(" - DumpVisitor Directory: %s"), FilenameOrDirectory);
-	//		}
-	//		else
-	//		{
-	//			UE_LOG(ModSkeletonLog, Log, TEXT(" - DumpVisitor File: %s"), FilenameOrDirectory);
-	//		}
-	//		return true;
-	//	}
-	//};
-	//StructDumpVisitor DumpVisitor;
-	
-	IPlatformFile& InnerPlatform = FPlatformFileManager::Get().GetPlatformFile();
-	FPakPlatformFile* PakPlatform = new FPakPlatformFile();
-	PakPlatform->Initialize(&InnerPlatform, TEXT(""));
-	FPlatformFileManager::Get().SetPlatformFile(*PakPlatform);
+	if (HookIO.Num() != Schema.Num())
+	{
+		UE_LOG(ModSkeletonLog, Error, TEXT("Hook %s %s: HookIO has %d elements, HookIOTypes declares %d"), *HookName, Boundary, HookIO.Num(), Schema.Num());
+		ensureMsgf(false, TEXT("HookIO does not match the HookIOTypes of hook %s"), *HookName);
+		return false;
+	}
 
-	IFileManager& FileManager = IFileManager::Get();
-	FString PakPath = FPaths::GameContentDir() + TEXT("Paks");
-	FPaths::NormalizeDirectoryName(PakPath);
-	FString BinSearch = PakPath + "/*.bin";
+	for (int32 i = 0; i < Schema.Num(); ++i)
+	{
+		const EBPVariantType Actual = GetHookIOElementType(HookIO[i]);
+		if (Actual != Schema[i])
+		{
+			UE_LOG(ModSkeletonLog, Error, TEXT("Hook %s %s: HookIO[%d] is %s, HookIOTypes declares %s"), *HookName, Boundary, i, FBPVariant::GetTypeName(Actual), FBPVariant::GetTypeName(Schema[i]));
+			ensureMsgf(false, TEXT("HookIO does not match the HookIOTypes of hook %s"), *HookName);
+			return false;
+		}
+	}
+	return true;
+}
 
-	// First, search for all AssetRegistry *.bin files in the Paks directory
-	TArray<FString> Files;
-	FileManager.FindFiles(Files, *BinSearch, true, false);
-	UE_LOG(ModSkeletonLog, Log, TEXT("Searching for Pak AssetRegistries: %s"), *BinSearch);
+/**
+ * Counts one dispatch (or plugin init) in UModSkeletonRegistry::DispatchDepth for its lifetime
+ */
+struct FModSkeletonDispatchDepthScope
+{
+	explicit FModSkeletonDispatchDepthScope(int32& InDepth)
+		: Depth(InDepth)
+	{
+		++Depth;
+	}
 
-	for (int32 i = 0; i < Files.Num(); ++i)
+	~FModSkeletonDispatchDepthScope()
 	{
-		FString BinFilename = PakPath + TEXT("/") + Files[i];
-		FPaths::MakeStandardFilename(BinFilename);
-		UE_LOG(ModSkeletonLog, Log, TEXT(" - AssetRegistry: %s"), *BinFilename);
+		--Depth;
+	}
 
-		FString PathPart;
-		FString FilenamePart;
-		FString ExtensionPart;
-		FPaths::Split(BinFilename, PathPart, FilenamePart, ExtensionPart);
-		FString PakFilename = PathPart + "/" + FilenamePart + ".pak";
-		FPaths::MakeStandardFilename(PakFilename);
+private:
+	int32& Depth;
+};
+
+/**
+ * HookIO for one invocation, held in whichever representation the previous handler produced.
+ * UBPVariant objects and FBPVariant values are only converted at a boundary between the two kinds of handler.
+ * Values are moved from one handler to the next. Their nested arrays and maps are shared copy-on-write, so a value
+ * handler that returns a modified copy of its HookIO has only copied the path to what it changed.
+ */
+struct FModSkeletonHookIOFrame
+{
+	explicit FModSkeletonHookIOFrame(UObject* InOuter)
+		: Outer(InOuter)
+		, bHoldsValues(false)
+	{
+	}
 
-		if (LoadedPaks.Contains(PakFilename))
+	TArray< UBPVariant* >& GetObjects()
+	{
+		if (bHoldsValues)
 		{
-			continue;
+			FBPVariant::ToObjectArray(Outer, Values, Objects);
+			bHoldsValues = false;
 		}
+		return Objects;
+	}
 
-		// Only process Mods that have BOTH the .bin registry and the .pak content files
-		if (FPaths::FileExists(PakFilename))
+	TArray< FBPVariant >& GetValues()
+	{
+		if (!bHoldsValues)
 		{
-			UE_LOG(ModSkeletonLog, Log, TEXT("Attempting PakLoad: %s"), *PakFilename);
+			FBPVariant::FromObjectArray(Objects, Values);
+			bHoldsValues = true;
+		}
+		return Values;
+	}
+
+	void SetObjects(TArray< UBPVariant* >&& InObjects)
+	{
+		Objects = MoveTemp(InObjects);
+		bHoldsValues = false;
+	}
+
+	void SetValues(TArray< FBPVariant >&& InValues)
+	{
+		Values = MoveTemp(InValues);
+		bHoldsValues = true;
+	}
 
-			// Mount the .pak content file
+	/**
+	 * Copy out the current HookIO as values, without changing which representation the frame holds
+	 */
+	void CopyValues(TArray< FBPVariant >& OutValues) const
+	{
+		if (bHoldsValues)
+		{
+			OutValues = Values;
+		}
+		else
+		{
+			FBPVariant::FromObjectArray(Objects, OutValues);
+		}
+	}
 
-			// TODO - Would prefer to use this, but I cannot seem to make the mount paths correct for it
-			//if (!FCoreDelegates::OnMountPak.Execute(PakFilename, 0, &DumpVisitor))
-			//{
-			//	UE_LOG(ModSkeletonLog, Error, TEXT("Failed to mount pak file: %s"), *PakFilename);
-			//	GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Red, FString::Printf(TEXT("Failed to mount pak file: %s"), *PakFilename));
-			//	continue;
-			//}
+	uint32 GetStructuralHash() const
+	{
+		return bHoldsValues ? FBPVariant::HashArray(Values) : FBPVariant::HashArray(Objects);
+	}
 
-			FString MountPoint(FPaths::GetPath(PakFilename));
+	bool StructurallyEquals(const TArray< FBPVariant >& Other) const
+	{
+		return bHoldsValues ? Values == Other : FBPVariant::ArrayEquals(Other, Objects);
+	}
 
-			FPakFile PakFile(&InnerPlatform, *PakFilename, false);
-			if (!PakFile.IsValid())
-			{
-				UE_LOG(ModSkeletonLog, Error, TEXT("Invalid pak file: %s"), *PakFilename);
-				GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Red, FString::Printf(TEXT("Invalid pak file: %s"), *PakFilename));
-				continue;
-			}
+	/**
+	 * Check the current HookIO against a hook's HookIOTypes without converting it
+	 */
+	bool MatchesHookIOTypes(const FModSkeletonHookEntry& Entry, const TCHAR* Boundary) const
+	{
+		const TArray< EBPVariantType >& Schema = Entry.Description.HookIOTypes;
+		return bHoldsValues ? ::MatchesHookIOTypes(Entry.HookName, Schema, Values, Boundary) : ::MatchesHookIOTypes(Entry.HookName, Schema, Objects, Boundary);
+	}
 
-			PakFile.SetMountPoint(*MountPoint);
-			if (!PakPlatform->Mount(*PakFilename, 0, *MountPoint))
-			{
-				UE_LOG(ModSkeletonLog, Error, TEXT("Failed to mount pak file: %s"), *PakFilename);
-				GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Red, FString::Printf(TEXT("Failed to mount pak file: %s"), *PakFilename));
-				continue;
-			}
+private:
+	UObject* Outer;
+	TArray< UBPVariant* > Objects;
+	TArray< FBPVariant > Values;
+	bool bHoldsValues;
+};
 
-			LoadedPaks.Add(PakFilename, true);
+UModSkeletonRegistry::UModSkeletonRegistry()
+	: MaxConcurrentPluginLoads(16)
+	, bBlockOnPluginLoads(false)
+	, bUseScanCache(true)
+	, bRecycleHookVariants(false)
+	, bScanInProgress(false)
+	, DispatchDepth(0)
+	, bScannedBaseContent(false)
+{
+	VariantPool = CreateDefaultSubobject<UBPVariantPool>(TEXT("VariantPool"));
+
+	FModSkeletonHookDescription InitHook;
+	InitHook.AlwaysInvoke = true;
+	InitHook.HookName = "ModSkeletonInit";
+	InitHook.HookDescription = "ModSkeleton Bootstrap Entrypoint. This will be invoked on every Mod as they are loaded.";
 
-			FString MountTarget = FPaths::Combine(*MountPoint, TEXT("Plugins"), *FilenamePart, TEXT("Content/"));
-			UE_LOG(ModSkeletonLog, Log, TEXT(" - Mounting At: %s"), *MountTarget);
-			FPackageName::RegisterMountPoint(TEXT("/") + FilenamePart + TEXT("/"), MountTarget);
+	InstallHook(InitHook);
+}
 
-			// Load the asset registry .bin file into the in-memory AssetRegistry
+void UModSkeletonRegistry::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	UModSkeletonRegistry* This = CastChecked<UModSkeletonRegistry>(InThis);
 
-			FArrayReader SerializedAssetData;
-			if (FFileHelper::LoadFileToArray(SerializedAssetData, *BinFilename))
-			{
-				AssetRegistry.Serialize(SerializedAssetData);
-				UE_LOG(ModSkeletonLog, Log, TEXT(" - AssetRegistry Loaded (%d bytes): %s"), SerializedAssetData.Num(), *BinFilename);
-				//GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Emerald, FString::Printf(TEXT(" - AssetRegistry Loaded (%d bytes): %s"), SerializedAssetData.Num(), *BinFilename));
-			}
+	// UnmountMod collects garbage right after releasing a mod, while workers may still be calling its plugins through
+	// the snapshot they pinned before. Those plugins go once the last retired snapshot naming them has been reclaimed.
+	This->DispatchSnapshots.AddReferencedObjects(This, Collector);
+	Super::AddReferencedObjects(InThis, Collector);
+}
 
-			//PakPlatform->IterateDirectoryRecursively(*MountTarget, DumpVisitor);
-		}
+void UModSkeletonRegistry::ScanForModPlugins()
+{
+	if (bScanInProgress)
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("ScanForModPlugins ignored, an asynchronous scan is in progress"));
+		return;
 	}
 
-	// now that the content assets have been added, and the asset registry has been updated
-	// we need to search the in-memory AssetRegistry to find any MOD_SKELETON init interfaces
-	
-	TArray<FAssetData> AssetData;
-	AssetRegistry.GetAllAssets(AssetData);
+	TSharedPtr<FModSkeletonScanCache, ESPMode::ThreadSafe> Cache = GetScanCache();
+	TArray<FModSkeletonPakScanEntry> Entries;
+	FindModPaks(GetLoadedPakNames(), Entries, Cache.Get());
 
-	UE_LOG(ModSkeletonLog, Log, TEXT("Searching for ModSkeleton Mod Assets:"));
+	FModSkeletonPakLayer& PakLayer = FModSkeletonPakLayer::Get();
+	PakLayer.GetPakPlatform();
+	PrepareAndMountModPaks(Entries, PakLayer, Cache.Get(), TFunction<void(int32, int32, const FString&)>());
 
-	for (int32 i = 0; i < AssetData.Num(); ++i)
+	FinishScan(Entries);
+}
+
+bool UModSkeletonRegistry::ScanForModPluginsAsync()
+{
+	if (bScanInProgress)
 	{
-		FString name = AssetData[i].AssetName.ToString();
-		if (name.StartsWith("MOD_SKELETON", ESearchCase::CaseSensitive))
-		{
-			UE_LOG(ModSkeletonLog, Log, TEXT(" - Asset: %s %s %s %s"), *name, *AssetData[i].PackagePath.ToString(), *AssetData[i].ObjectPath.ToString(), *AssetData[i].AssetClass.ToString());
+		return false;
+	}
+	bScanInProgress = true;
 
-			if (LoadedPlugins.Contains(AssetData[i].ObjectPath))
-			{
-				continue;
-			}
+	// The pak layer has to be installed from the game thread, before any worker mounts into it
+	FModSkeletonPakLayer::Get().GetPakPlatform();
+	TSharedPtr<FModSkeletonScanCache, ESPMode::ThreadSafe> Cache = GetScanCache();
+	TSet<FString> LoadedPakNames = GetLoadedPakNames();
+	TWeakObjectPtr<UModSkeletonRegistry> WeakThis(this);
 
-			// TODO - this is loading Blueprint Interfaces
-			// make this work with C++ interfaces as well!
+	Async<void>(EAsyncExecution::ThreadPool, [WeakThis, Cache, LoadedPakNames]()
+	{
+		TSharedRef<TArray<FModSkeletonPakScanEntry>, ESPMode::ThreadSafe> Entries = MakeShareable(new TArray<FModSkeletonPakScanEntry>());
+		FindModPaks(LoadedPakNames, *Entries, Cache.Get());
 
-			UClass* AssetClass = LoadObject<UClass>(nullptr, *(TEXT("Class'") + AssetData[i].ObjectPath.ToString() + TEXT("_C'")));
-			if (AssetClass != nullptr)
+		PrepareAndMountModPaks(*Entries, FModSkeletonPakLayer::Get(), Cache.Get(), [WeakThis](int32 Completed, int32 Total, const FString& ModName)
+		{
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, Completed, Total, ModName]()
 			{
-				UObject *RealObj = NewObject<UObject>(this, AssetClass);
-				if (RealObj->GetClass()->ImplementsInterface(UModSkeletonPluginInterface::StaticClass()))
+				if (UModSkeletonRegistry* Registry = WeakThis.Get())
 				{
-					// Invoke the ModSkeletonInit hook - this is invoked exactly once for every mod right at load.
-
-					TArray< UBPVariant* > HookIO;
-					IModSkeletonPluginInterface::Execute_ModSkeletonHook(RealObj, TEXT("ModSkeletonInit"), HookIO);
-
-					LoadedPlugins.Add(AssetData[i].ObjectPath, RealObj);
+					Registry->OnScanProgress.Broadcast(Completed, Total, ModName);
 				}
+			});
+		});
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Entries]()
+		{
+			if (UModSkeletonRegistry* Registry = WeakThis.Get())
+			{
+				Registry->FinishScan(*Entries, true, [WeakThis]()
+				{
+					if (UModSkeletonRegistry* Scanned = WeakThis.Get())
+					{
+						Scanned->bScanInProgress = false;
+					}
+				});
 			}
-		}
-	}
+		});
+	});
+	return true;
 }
 
-void UModSkeletonRegistry::ListModPlugins(TArray< UObject* >& OutPluginList)
+bool UModSkeletonRegistry::IsScanInProgress() const
 {
-	LoadedPlugins.GenerateValueArray(OutPluginList);
+	return bScanInProgress;
 }
 
-bool UModSkeletonRegistry::InstallHook(FModSkeletonHookDescription HookDescription)
+TSharedPtr<FModSkeletonScanCache, ESPMode::ThreadSafe> UModSkeletonRegistry::GetScanCache()
 {
-	if (RegisteredHooks.Contains(HookDescription.HookName))
+	if (!bUseScanCache)
 	{
-		return false;
+		return nullptr;
 	}
-	RegisteredHooks.Add(HookDescription.HookName, HookDescription);
-	return true;
+	if (!ScanCache.IsValid())
+	{
+		ScanCache = MakeShareable(new FModSkeletonScanCache());
+		ScanCache->Load();
+	}
+	return ScanCache;
 }
 
-TArray< FModSkeletonHookDescription > UModSkeletonRegistry::ListHooks()
+TSet<FString> UModSkeletonRegistry::GetLoadedPakNames() const
 {
-	TArray< FModSkeletonHookDescription > OutArray;
-	RegisteredHooks.GenerateValueArray(OutArray);
-	return OutArray;
+	TSet<FString> Out;
+	for (const auto& LoadedMod : LoadedMods)
+	{
+		Out.Add(LoadedMod.Value.PakFilename);
+	}
+	return Out;
 }
 
-FModSkeletonHookDescription UModSkeletonRegistry::GetHookDescription(FString HookName)
+FString UModSkeletonRegistry::GetModPakDirectory()
 {
-	if (RegisteredHooks.Contains(HookName))
-	{
-		return RegisteredHooks[HookName];
-	}
-	return FModSkeletonHookDescription();
+	FString PakPath = FPaths::GameContentDir() + TEXT("Paks");
+	FPaths::NormalizeDirectoryName(PakPath);
+	return PakPath;
 }
 
-void UModSkeletonRegistry::ConnectHook(FString HookName, int32 Priority, UObject *ModSkeletonPluginInterface)
+void UModSkeletonRegistry::StartWatchingModPaks(float DebounceSeconds, float PollSeconds)
 {
-	if (!ModSkeletonPluginInterface->GetClass()->ImplementsInterface(UModSkeletonPluginInterface::StaticClass())) {
+	check(IsInGameThread());
+	if (PakWatcher.IsValid())
+	{
 		return;
 	}
 
-	FModSkeletonConnectHook NewHook;
-	NewHook.HookName = HookName;
-	NewHook.Priority = Priority;
-	NewHook.ModSkeletonPluginInterface = ModSkeletonPluginInterface;
+	TWeakObjectPtr<UModSkeletonRegistry> WeakThis(this);
+	PakWatcher = MakeShareable(new FModSkeletonPakWatcher(GetModPakDirectory(), DebounceSeconds, PollSeconds, [WeakThis](const TArray<FString>& ChangedFiles)
+	{
+		UModSkeletonRegistry* Registry = WeakThis.Get();
+		return Registry == nullptr || Registry->RescanModPaks(ChangedFiles);
+	}));
+}
+
+void UModSkeletonRegistry::StopWatchingModPaks()
+{
+	PakWatcher.Reset();
+}
 
-	ConnectedHooks.HeapPush(NewHook, FModSkeletonConnectHookPredicate());
+bool UModSkeletonRegistry::IsWatchingModPaks() const
+{
+	return PakWatcher.IsValid();
 }
 
-TArray< UBPVariant* > UModSkeletonRegistry::InvokeHook(FString HookName, const TArray< UBPVariant * >& HookIO)
+bool UModSkeletonRegistry::RescanModPaks(const TArray<FString>& ChangedFiles)
 {
-	if (!RegisteredHooks.Contains(HookName))
+	if (bScanInProgress || DispatchDepth > 0)
 	{
-		UE_LOG(ModSkeletonLog, Warning, TEXT("Ignoring Unregistered HookName: %s"), *HookName);
-		return HookIO;
+		return false;
 	}
-	UE_LOG(ModSkeletonLog, Log, TEXT("Invoke HookName: %s"), *HookName);
 
-	// We want to pass the RESULTS from the previous invocation in as the PARAMETERS to the next
-	TArray< UBPVariant* > CurHookIO = HookIO;
+	// A mod is its .pak / .bin pair, either file changing affects the whole mod
+	TArray<FString> ModNames;
+	for (const FString& ChangedFile : ChangedFiles)
+	{
+		ModNames.AddUnique(FPaths::GetBaseFilename(ChangedFile));
+	}
+	ModNames.Sort();
+
+	const FString PakPath = GetModPakDirectory();
+	TArray<FString> AddedMods;
+	TArray<FString> ReloadedMods;
+	TArray<FString> RemovedMods;
+	TArray<FModSkeletonPakScanEntry> Entries;
+	for (const FString& ModName : ModNames)
+	{
+		FString PakFilename = PakPath / ModName + TEXT(".pak");
+		FString BinFilename = PakPath / ModName + TEXT(".bin");
+		FPaths::MakeStandardFilename(PakFilename);
+		FPaths::MakeStandardFilename(BinFilename);
 
-	FModSkeletonHookDescription HookDescription = RegisteredHooks[HookName];
-	if (HookDescription.AlwaysInvoke) {
-		for (auto PlugRef : LoadedPlugins)
+		// a mod that is only half copied is picked up once both files are there
+		const bool bComplete = FPaths::FileExists(PakFilename) && FPaths::FileExists(BinFilename);
+		if (LoadedMods.Contains(ModName))
 		{
-			CurHookIO = IModSkeletonPluginInterface::Execute_ModSkeletonHook(PlugRef.Value, HookName, CurHookIO);
+			if (!bComplete)
+			{
+				UnloadMod(ModName);
+				RemovedMods.Add(ModName);
+			}
+			else if (ReloadMod(ModName))
+			{
+				ReloadedMods.Add(ModName);
+			}
+			else
+			{
+				RemovedMods.Add(ModName);
+			}
+		}
+		else if (bComplete)
+		{
+			FModSkeletonPakScanEntry& Entry = Entries[Entries.AddDefaulted()];
+			Entry.ModName = ModName;
+			Entry.PakFilename = PakFilename;
+			Entry.BinFilename = BinFilename;
+			Entry.MountPoint = FPaths::GetPath(PakFilename);
 		}
 	}
-	else
+
+	if (Entries.Num() > 0)
+	{
+		UE_LOG(ModSkeletonLog, Log, TEXT("Scanning %d new mod paks"), Entries.Num());
+		TSharedPtr<FModSkeletonScanCache, ESPMode::ThreadSafe> Cache = GetScanCache();
+		PrepareAndMountModPaks(Entries, FModSkeletonPakLayer::Get(), Cache.Get(), TFunction<void(int32, int32, const FString&)>());
+		FinishScan(Entries, !bBlockOnPluginLoads);
+		for (const FModSkeletonPakScanEntry& Entry : Entries)
+		{
+			if (LoadedMods.Contains(Entry.ModName))
+			{
+				AddedMods.Add(Entry.ModName);
+			}
+		}
+	}
+
+	if (AddedMods.Num() > 0 || ReloadedMods.Num() > 0 || RemovedMods.Num() > 0)
+	{
+		UE_LOG(ModSkeletonLog, Log, TEXT("Mods changed - added: [%s] reloaded: [%s] removed: [%s]"),
+			*FString::Join(AddedMods, TEXT(", ")), *FString::Join(ReloadedMods, TEXT(", ")), *FString::Join(RemovedMods, TEXT(", ")));
+		OnModsChanged.Broadcast(AddedMods, ReloadedMods, RemovedMods);
+	}
+	return true;
+}
+
+void UModSkeletonRegistry::FindModPaks(const TSet<FString>& LoadedPakNames, TArray<FModSkeletonPakScanEntry>& OutEntries, FModSkeletonScanCache* Cache)
+{
+	IFileManager& FileManager = IFileManager::Get();
+	const FString PakPath = GetModPakDirectory();
+	FString BinSearch = PakPath + "/*.bin";
+
+	// First, search for all AssetRegistry *.bin files in the Paks directory
+	TArray<FString> Files;
+	FileManager.FindFiles(Files, *BinSearch, true, false);
+	UE_LOG(ModSkeletonLog, Log, TEXT("Searching for Pak AssetRegistries: %s"), *BinSearch);
+
+	// FindFiles order depends on the filesystem, sort so mount order is deterministic
+	Files.Sort();
+
+	// Loaded mods keep their cache entries even if their files are gone, they are still mounted
+	TSet<FString> SeenPakNames = LoadedPakNames;
+
+	for (int32 i = 0; i < Files.Num(); ++i)
+	{
+		FString BinFilename = PakPath + TEXT("/") + Files[i];
+		FPaths::MakeStandardFilename(BinFilename);
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - AssetRegistry: %s"), *BinFilename);
+
+		FString PathPart;
+		FString FilenamePart;
+		FString ExtensionPart;
+		FPaths::Split(BinFilename, PathPart, FilenamePart, ExtensionPart);
+		FString PakFilename = PathPart + "/" + FilenamePart + ".pak";
+		FPaths::MakeStandardFilename(PakFilename);
+
+		if (LoadedPakNames.Contains(PakFilename))
+		{
+			continue;
+		}
+
+		// Only process Mods that have BOTH the .bin registry and the .pak content files
+		if (FPaths::FileExists(PakFilename))
+		{
+			SeenPakNames.Add(PakFilename);
+			FModSkeletonPakScanEntry& Entry = OutEntries[OutEntries.AddDefaulted()];
+			Entry.ModName = FilenamePart;
+			Entry.PakFilename = PakFilename;
+			Entry.BinFilename = BinFilename;
+			Entry.MountPoint = FPaths::GetPath(PakFilename);
+		}
+	}
+
+	if (Cache != nullptr)
 	{
-		TArray<FModSkeletonConnectHook> ConnectedHooksClone = ConnectedHooks;
-		FModSkeletonConnectHook Next;
-		while (ConnectedHooksClone.Num() > 0)
+		Cache->RemoveUnseen(SeenPakNames);
+	}
+}
+
+void UModSkeletonRegistry::PrepareAndMountModPaks(TArray<FModSkeletonPakScanEntry>& Entries, FModSkeletonPakLayer& PakLayer, FModSkeletonScanCache* Cache, const TFunction<void(int32, int32, const FString&)>& OnPrepared)
+{
+	// Validating paks and reading AssetRegistry files is independent per mod, fan it out
+	FThreadSafeCounter Completed;
+	IPlatformFile* LowerPlatform = PakLayer.GetLowerLevel();
+	ParallelFor(Entries.Num(), [&Entries, &Completed, &OnPrepared, LowerPlatform, Cache](int32 Index)
+	{
+		PrepareModPak(Entries[Index], LowerPlatform, Cache);
+		const int32 NumCompleted = Completed.Increment();
+		if (OnPrepared)
 		{
-			ConnectedHooksClone.HeapPop(Next, FModSkeletonConnectHookPredicate());
-			if (Next.HookName != HookName) continue;
-			CurHookIO = IModSkeletonPluginInterface::Execute_ModSkeletonHook(Next.ModSkeletonPluginInterface, HookName, CurHookIO);
+			OnPrepared(NumCompleted, Entries.Num(), Entries[Index].ModName);
 		}
+	});
+
+	// Mount in sorted order so pak priority is deterministic - PrepareModPak does not log, so output stays in this order too
+	for (FModSkeletonPakScanEntry& Entry : Entries)
+	{
+		UE_LOG(ModSkeletonLog, Log, TEXT("Attempting PakLoad%s: %s"), Entry.bCached ? TEXT(" (cached)") : TEXT(""), *Entry.PakFilename);
+		MountModPak(Entry, PakLayer);
+	}
+}
+
+void UModSkeletonRegistry::PrepareModPak(FModSkeletonPakScanEntry& Entry, IPlatformFile* LowerPlatform, FModSkeletonScanCache* Cache)
+{
+	Entry.bHasManifest = Entry.Manifest.LoadFromFile(FModSkeletonModManifest::GetManifestFilename(Entry.PakFilename), Entry.ManifestError);
+
+	// An unchanged mod can skip validation and searching for plugins, its file list and plugin paths are already known
+	Entry.bCached = Cache != nullptr && Cache->FindValid(Entry.PakFilename, Entry.BinFilename, Entry.CacheEntry);
+	if (!Entry.bCached && !FModSkeletonPakLayer::ReadPakFiles(LowerPlatform, Entry.PakFilename, Entry.PakFiles))
+	{
+		Entry.Error = FString::Printf(TEXT("Invalid pak file: %s"), *Entry.PakFilename);
+		return;
+	}
+
+	// Load the asset registry .bin file, it is merged into the in-memory AssetRegistry on the game thread.
+	// Cached mods need it too, game code may query the AssetRegistry for their assets.
+	Entry.bAssetDataLoaded = FFileHelper::LoadFileToArray(Entry.SerializedAssetData, *Entry.BinFilename);
+
+	if (Cache != nullptr && !Entry.bCached)
+	{
+		Entry.CacheEntry.PakFilename = Entry.PakFilename;
+		Entry.CacheEntry.PakFiles = Entry.PakFiles;
+		FModSkeletonScanCache::MakeFileKey(Entry.PakFilename, true, Entry.CacheEntry.PakKey);
+		FModSkeletonScanCache::MakeFileKey(Entry.BinFilename, true, Entry.CacheEntry.BinKey);
+	}
+}
+
+void UModSkeletonRegistry::MountModPak(FModSkeletonPakScanEntry& Entry, FModSkeletonPakLayer& PakLayer)
+{
+	if (!Entry.Error.IsEmpty())
+	{
+		return;
 	}
-	return CurHookIO;
+
+	// TODO - Would prefer to use this, but I cannot seem to make the mount paths correct for it
+	//if (!FCoreDelegates::OnMountPak.Execute(PakFilename, 0, &DumpVisitor))
+	//{
+	//	UE_LOG(ModSkeletonLog, Error, TEXT("Failed to mount pak file: %s"), *PakFilename);
+	//	GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Red, FString::Printf(TEXT("Failed to mount pak file: %s"), *PakFilename));
+	//	continue;
+	//}
+
+	// Cached mods skipped validation, their file list comes from the cache instead
+	const bool bMounted = PakLayer.Mount(Entry.PakFilename, Entry.MountPoint, Entry.bCached ? Entry.CacheEntry.PakFiles : Entry.PakFiles, Entry.Error);
+	Entry.PakFiles.Empty();
+	if (!bMounted)
+	{
+		return;
+	}
+	Entry.bMounted = true;
+}
+
+void UModSkeletonRegistry::FinishScan(TArray<FModSkeletonPakScanEntry>& Entries, bool bInitAsync, TFunction<void()> OnInitialized)
+{
+	check(IsInGameThread());
+
+	FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
+	IAssetRegistry& AssetRegistry = AssetRegistryModule.Get();
+
+	// Uncomment this and the "IterateDirectoryRecursively" below to dump out pak contents on load
+	//struct StructDumpVisitor : public IPlatformFile::FDirectoryVisitor
+	//{
+	//	virtual bool Visit(const TCHAR* FilenameOrDirectory, bool bIsDirectory)
+	//	{
+	//		if (bIsDirectory)
+	//		{
+	//			UE_LOG(ModSkeletonLog, Log, TEXT(" - DumpVisitor Directory: %s"), FilenameOrDirectory);
+	//		}
+	//		else
+	//		{
+	//			UE_LOG(ModSkeletonLog, Log, TEXT(" - DumpVisitor File: %s"), FilenameOrDirectory);
+	//		}
+	//		return true;
+	//	}
+	//};
+	//StructDumpVisitor DumpVisitor;
+
+	for (FModSkeletonPakScanEntry& Entry : Entries)
+	{
+		if (!Entry.bMounted)
+		{
+			UE_LOG(ModSkeletonLog, Error, TEXT("%s"), *Entry.Error);
+			GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Red, Entry.Error);
+			continue;
+		}
+
+		FModSkeletonLoadedMod& Mod = LoadedMods.Add(Entry.ModName);
+		Mod.PakFilename = Entry.PakFilename;
+		Mod.BinFilename = Entry.BinFilename;
+		Mod.MountPoint = Entry.MountPoint;
+		Mod.RootPath = TEXT("/") + Entry.ModName + TEXT("/");
+		Mod.ContentPath = FPaths::Combine(*Entry.MountPoint, TEXT("Plugins"), *Entry.ModName, TEXT("Content/"));
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - Mounting At: %s"), *Mod.ContentPath);
+		FPackageName::RegisterMountPoint(Mod.RootPath, Mod.ContentPath);
+
+		// Merge the asset registry .bin file into the in-memory AssetRegistry
+
+		if (Entry.bAssetDataLoaded)
+		{
+			FMemoryReader SerializedAssetData(Entry.SerializedAssetData);
+			AssetRegistry.Serialize(SerializedAssetData);
+			UE_LOG(ModSkeletonLog, Log, TEXT(" - AssetRegistry Loaded (%d bytes): %s"), Entry.SerializedAssetData.Num(), *Entry.BinFilename);
+			//GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Emerald, FString::Printf(TEXT(" - AssetRegistry Loaded (%d bytes): %s"), SerializedAssetData.Num(), *BinFilename));
+		}
+		Entry.SerializedAssetData.Empty();
+
+		//FPlatformFileManager::Get().GetPlatformFile().IterateDirectoryRecursively(*MountTarget, DumpVisitor);
+	}
+
+	// Only look at content contributed by the paks mounted in this pass.
+	// The first scan also covers content that was not loaded from a mod pak (the game itself and enabled plugins).
+	TArray<FName> PluginObjectPaths;
+	if (!bScannedBaseContent)
+	{
+		TArray<FName> BaseContentRoots;
+		GetBaseContentRoots(BaseContentRoots);
+		FindModPluginAssets(AssetRegistry, BaseContentRoots, PluginObjectPaths);
+		bScannedBaseContent = true;
+	}
+
+	// Mods initialized during this scan, ordered by their declared dependencies once they have all been found
+	FModSkeletonModGraph ModGraph;
+	TMap< FString, TArray<FName> > ModPluginObjectPaths;
+	TArray<FString> DeferredMods;
+
+	FModSkeletonScanCache* Cache = ScanCache.Get();
+	for (FModSkeletonPakScanEntry& Entry : Entries)
+	{
+		if (!Entry.bMounted)
+		{
+			if (Cache != nullptr)
+			{
+				Cache->Remove(Entry.PakFilename);
+			}
+			continue;
+		}
+
+		TArray<FName> ModObjectPaths;
+		if (Entry.bCached)
+		{
+			for (const FString& ObjectPath : Entry.CacheEntry.PluginObjectPaths)
+			{
+				ModObjectPaths.Add(FName(*ObjectPath));
+			}
+		}
+		else
+		{
+			FindModPluginAssets(AssetRegistry, { FName(*(TEXT("/") + Entry.ModName)) }, ModObjectPaths);
+
+			if (Cache != nullptr)
+			{
+				Entry.CacheEntry.PluginObjectPaths.Reset();
+				for (const FName& ObjectPath : ModObjectPaths)
+				{
+					Entry.CacheEntry.PluginObjectPaths.Add(ObjectPath.ToString());
+				}
+				Cache->Update(Entry.CacheEntry);
+			}
+		}
+
+		LoadedMods.FindChecked(Entry.ModName).PluginObjectPaths = ModObjectPaths;
+
+		if (!Entry.ManifestError.IsEmpty())
+		{
+			UE_LOG(ModSkeletonLog, Warning, TEXT("%s"), *Entry.ManifestError);
+		}
+
+		if (Entry.bHasManifest && !Entry.Manifest.bEagerInit)
+		{
+			UE_LOG(ModSkeletonLog, Log, TEXT(" - Deferring %d plugins until first use of: %s"), ModObjectPaths.Num(), *FString::Join(Entry.Manifest.Hooks, TEXT(", ")));
+			if (Entry.Manifest.Hooks.Num() == 0)
+			{
+				UE_LOG(ModSkeletonLog, Warning, TEXT("Mod manifest for %s disables EagerInit but declares no Hooks, it will never be loaded"), *Entry.ModName);
+			}
+			DeferPlugins(ModObjectPaths, Entry.Manifest.Hooks);
+			DeferredMods.Add(Entry.ModName);
+			continue;
+		}
+
+		// AssetRegistry order is not stable from run to run
+		ModObjectPaths.Sort([](const FName& A, const FName& B)
+		{
+			return A.ToString() < B.ToString();
+		});
+		ModGraph.AddMod(Entry.ModName, Entry.Manifest.Dependencies);
+		ModPluginObjectPaths.Add(Entry.ModName, MoveTemp(ModObjectPaths));
+	}
+
+	// Mods loaded by earlier scans (or deferred in this one) already satisfy a dependency
+	TSet<FString> AlreadyLoaded;
+	for (const auto& Pair : LoadedMods)
+	{
+		if (!ModPluginObjectPaths.Contains(Pair.Key))
+		{
+			AlreadyLoaded.Add(Pair.Key);
+		}
+	}
+	const FModSkeletonModInitOrder InitOrder = ModGraph.BuildInitOrder(AlreadyLoaded);
+	InitOrder.Log();
+
+	TArray<FString> OrderedMods;
+	InitOrder.GetOrderedMods(OrderedMods);
+	for (const FString& ModName : OrderedMods)
+	{
+		for (const FString& Dependency : ModGraph.GetDependencies(ModName))
+		{
+			if (DeferredMods.Contains(Dependency))
+			{
+				UE_LOG(ModSkeletonLog, Warning, TEXT("Mod %s depends on %s, which defers its init until first use, so may be initialized first"), *ModName, *Dependency);
+			}
+		}
+
+		// Every wave's classes are requested together, ModSkeletonInit then follows the wave order
+		for (const FName& ObjectPath : ModPluginObjectPaths.FindChecked(ModName))
+		{
+			PluginObjectPaths.AddUnique(ObjectPath);
+		}
+	}
+
+	if (Cache != nullptr)
+	{
+		Cache->Save();
+	}
+
+	if (bInitAsync)
+	{
+		TWeakObjectPtr<UModSkeletonRegistry> WeakThis(this);
+		LoadModPlugins(PluginObjectPaths, [WeakThis, OnInitialized](int32 NewPlugins)
+		{
+			if (OnInitialized)
+			{
+				OnInitialized();
+			}
+			if (UModSkeletonRegistry* Registry = WeakThis.Get())
+			{
+				Registry->OnScanComplete.Broadcast(NewPlugins);
+			}
+		});
+		return;
+	}
+
+	const int32 NewPlugins = InitModPlugins(PluginObjectPaths);
+	if (OnInitialized)
+	{
+		OnInitialized();
+	}
+	OnScanComplete.Broadcast(NewPlugins);
+}
+
+void UModSkeletonRegistry::GetBaseContentRoots(TArray<FName>& OutContentRoots)
+{
+	OutContentRoots.Add(FName(TEXT("/Game")));
+	for (const TSharedRef<IPlugin>& Plugin : IPluginManager::Get().GetEnabledPlugins())
+	{
+		if (Plugin->CanContainContent())
+		{
+			OutContentRoots.Add(FName(*(TEXT("/") + Plugin->GetName())));
+		}
+	}
+}
+
+void UModSkeletonRegistry::FindModPluginAssets(IAssetRegistry& AssetRegistry, const TArray<FName>& ContentRoots, TArray<FName>& OutObjectPaths)
+{
+	// now that the content assets have been added, and the asset registry has been updated
+	// we need to search the in-memory AssetRegistry to find any MOD_SKELETON init interfaces
+
+	if (ContentRoots.Num() == 0)
+	{
+		return;
+	}
+
+	FARFilter Filter;
+	Filter.PackagePaths = ContentRoots;
+	Filter.bRecursivePaths = true;
+
+	TArray<FAssetData> AssetData;
+	AssetRegistry.GetAssets(Filter, AssetData);
+
+	UE_LOG(ModSkeletonLog, Log, TEXT("Searching for ModSkeleton Mod Assets:"));
+
+	for (int32 i = 0; i < AssetData.Num(); ++i)
+	{
+		FString name = AssetData[i].AssetName.ToString();
+		if (name.StartsWith("MOD_SKELETON", ESearchCase::CaseSensitive))
+		{
+			UE_LOG(ModSkeletonLog, Log, TEXT(" - Asset: %s %s %s %s"), *name, *AssetData[i].PackagePath.ToString(), *AssetData[i].ObjectPath.ToString(), *AssetData[i].AssetClass.ToString());
+			OutObjectPaths.Add(AssetData[i].ObjectPath);
+		}
+	}
+}
+
+int32 UModSkeletonRegistry::InitModPlugins(const TArray<FName>& ObjectPaths)
+{
+#if MODSKELETON_PROFILING
+	SCOPE_CYCLE_COUNTER(STAT_ModSkeletonInitModPlugins);
+#endif
+
+	int32 NewPlugins = 0;
+	LoadModPlugins(ObjectPaths, [&NewPlugins](int32 Count)
+	{
+		NewPlugins = Count;
+	})->WaitUntilComplete();
+	return NewPlugins;
+}
+
+TSharedRef<FModSkeletonPluginLoader> UModSkeletonRegistry::LoadModPlugins(const TArray<FName>& ObjectPaths, TFunction<void(int32)> OnComplete)
+{
+	TArray<FName> NewObjectPaths;
+	for (const FName& ObjectPath : ObjectPaths)
+	{
+		if (!LoadedPlugins.Contains(ObjectPath))
+		{
+			NewObjectPaths.AddUnique(ObjectPath);
+		}
+	}
+
+	TSharedRef<int32> NewPlugins = MakeShareable(new int32(0));
+	TWeakObjectPtr<UModSkeletonRegistry> WeakThis(this);
+	TSharedRef<FModSkeletonPluginLoader> Loader = MakeShareable(new FModSkeletonPluginLoader(NewObjectPaths, MaxConcurrentPluginLoads,
+		[WeakThis, NewPlugins](const FName& ObjectPath, UClass* PluginClass)
+		{
+			UModSkeletonRegistry* Registry = WeakThis.Get();
+			if (Registry != nullptr && Registry->InitModPlugin(ObjectPath, PluginClass))
+			{
+				++*NewPlugins;
+			}
+		},
+		[WeakThis, NewPlugins, OnComplete]()
+		{
+			UModSkeletonRegistry* Registry = WeakThis.Get();
+			if (Registry != nullptr && *NewPlugins > 0)
+			{
+				// AlwaysInvoke hooks now have more handlers
+				Registry->InvalidatePureCaches();
+				Registry->PublishDispatchSnapshot(INDEX_NONE);
+			}
+			if (OnComplete)
+			{
+				OnComplete(*NewPlugins);
+			}
+		}));
+	Loader->Start();
+	return Loader;
+}
+
+bool UModSkeletonRegistry::InitModPlugin(const FName& ObjectPath, UClass* PluginClass)
+{
+	if (PluginClass == nullptr || LoadedPlugins.Contains(ObjectPath))
+	{
+		return false;
+	}
+	if (PluginClass->GetOutermost()->GetName().StartsWith(UnloadedModPackagePrefix))
+	{
+		UE_LOG(ModSkeletonLog, Log, TEXT("Skipping plugin of a mod unloaded while it was loading: %s"), *ObjectPath.ToString());
+		return false;
+	}
+
+	// ModSkeletonInit handlers may connect, invoke hooks or ask for a mod to be unloaded
+	FModSkeletonDispatchDepthScope DepthScope(DispatchDepth);
+
+	UObject *RealObj = NewObject<UObject>(this, PluginClass);
+	if (!IsModSkeletonPlugin(RealObj))
+	{
+		return false;
+	}
+
+	// Invoke the ModSkeletonInit hook - this is invoked exactly once for every mod right at load.
+
+	static const FName InitHookName(TEXT("ModSkeletonInit"));
+	FModSkeletonHookIOFrame HookIO(this);
+	InvokePlugin(RealObj, InitHookName, TEXT("ModSkeletonInit"), HookIO);
+
+	LoadedPlugins.Add(ObjectPath, RealObj);
+	LoadedPluginList.Add(RealObj);
+	return true;
+}
+
+void UModSkeletonRegistry::ListModPlugins(TArray< UObject* >& OutPluginList)
+{
+	OutPluginList = LoadedPluginList;
+}
+
+void UModSkeletonRegistry::ListMods(TArray< FString >& OutModNames)
+{
+	LoadedMods.GenerateKeyArray(OutModNames);
+	OutModNames.Sort();
+}
+
+bool UModSkeletonRegistry::UnloadMod(const FString& ModName)
+{
+	check(IsInGameThread());
+	if (!LoadedMods.Contains(ModName))
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("UnloadMod ignored, mod is not loaded: %s"), *ModName);
+		return false;
+	}
+	if (bScanInProgress)
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("UnloadMod ignored, an asynchronous scan is in progress: %s"), *ModName);
+		return false;
+	}
+	if (DispatchDepth > 0)
+	{
+		DeferModChange(ModName, false);
+		return true;
+	}
+
+	FModSkeletonLoadedMod Mod;
+	LoadedMods.RemoveAndCopyValue(ModName, Mod);
+	UE_LOG(ModSkeletonLog, Log, TEXT("Unloading mod: %s"), *ModName);
+
+	ReleaseModPlugins(ModName, Mod);
+	UnmountMod(ModName, Mod);
+	return true;
+}
+
+bool UModSkeletonRegistry::ReloadMod(const FString& ModName)
+{
+	check(IsInGameThread());
+	const FModSkeletonLoadedMod* Loaded = LoadedMods.Find(ModName);
+	if (Loaded == nullptr)
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("ReloadMod ignored, mod is not loaded: %s"), *ModName);
+		return false;
+	}
+	if (bScanInProgress)
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("ReloadMod ignored, an asynchronous scan is in progress: %s"), *ModName);
+		return false;
+	}
+	if (DispatchDepth > 0)
+	{
+		DeferModChange(ModName, true);
+		return true;
+	}
+
+	FModSkeletonPakScanEntry Entry;
+	Entry.ModName = ModName;
+	Entry.PakFilename = Loaded->PakFilename;
+	Entry.BinFilename = Loaded->BinFilename;
+	Entry.MountPoint = Loaded->MountPoint;
+
+	UnloadMod(ModName);
+
+	if (!FPaths::FileExists(Entry.PakFilename) || !FPaths::FileExists(Entry.BinFilename))
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("ReloadMod could not find %s any more, it stays unloaded"), *Entry.PakFilename);
+		return false;
+	}
+
+	// the same steps as a scan, for this one mod
+	TArray<FModSkeletonPakScanEntry> Entries;
+	Entries.Add(MoveTemp(Entry));
+	TSharedPtr<FModSkeletonScanCache, ESPMode::ThreadSafe> Cache = GetScanCache();
+	PrepareAndMountModPaks(Entries, FModSkeletonPakLayer::Get(), Cache.Get(), TFunction<void(int32, int32, const FString&)>());
+	FinishScan(Entries, !bBlockOnPluginLoads);
+	return LoadedMods.Contains(ModName);
+}
+
+void UModSkeletonRegistry::DeferModChange(const FString& ModName, bool bReload)
+{
+	UE_LOG(ModSkeletonLog, Log, TEXT("%s of %s deferred until hook dispatch returns"), bReload ? TEXT("ReloadMod") : TEXT("UnloadMod"), *ModName);
+	TWeakObjectPtr<UModSkeletonRegistry> WeakThis(this);
+	AsyncTask(ENamedThreads::GameThread, [WeakThis, ModName, bReload]()
+	{
+		if (UModSkeletonRegistry* Registry = WeakThis.Get())
+		{
+			if (bReload)
+			{
+				Registry->ReloadMod(ModName);
+			}
+			else
+			{
+				Registry->UnloadMod(ModName);
+			}
+		}
+	});
+}
+
+void UModSkeletonRegistry::ReleaseModPlugins(const FString& ModName, const FModSkeletonLoadedMod& Mod)
+{
+	TSet<const UObject*> Plugins;
+	for (const FName& ObjectPath : Mod.PluginObjectPaths)
+	{
+		UObject* Plugin = nullptr;
+		if (LoadedPlugins.RemoveAndCopyValue(ObjectPath, Plugin))
+		{
+			Plugins.Add(Plugin);
+		}
+	}
+	LoadedPluginList.RemoveAll([&Plugins](const UObject* Plugin)
+	{
+		return Plugins.Contains(Plugin);
+	});
+
+	// A connection belongs to the mod if it calls one of its plugins, something a plugin owns, or an instance of one of its classes
+	const FString& RootPath = Mod.RootPath;
+	auto IsModObject = [&Plugins, &RootPath](const UObject* Object)
+	{
+		if (Object == nullptr)
+		{
+			return false;
+		}
+		for (const UObject* Outer = Object; Outer != nullptr; Outer = Outer->GetOuter())
+		{
+			if (Plugins.Contains(Outer))
+			{
+				return true;
+			}
+		}
+		return Object->GetClass()->GetOutermost()->GetName().StartsWith(RootPath);
+	};
+	auto IsModConnection = [&IsModObject](const FModSkeletonConnectHook& Connection)
+	{
+		return IsModObject(Connection.NativeHandler.IsValid() ? Connection.NativeHandler->GetUObject() : Connection.ModSkeletonPluginInterface);
+	};
+
+	int32 Disconnected = 0;
+	for (int32 i = 0; i < RegisteredHooks.Num(); ++i)
+	{
+		FModSkeletonHookEntry& Entry = RegisteredHooks[i];
+		const int32 Removed = Entry.Connections.RemoveAll(IsModConnection);
+		for (const FName& ObjectPath : Mod.PluginObjectPaths)
+		{
+			Entry.DeferredPlugins.Remove(ObjectPath);
+		}
+		if (Removed > 0)
+		{
+			InvalidatePureCache(i);
+			Disconnected += Removed;
+		}
+	}
+	Disconnected += PendingConnections.RemoveAll(IsModConnection);
+
+	// AlwaysInvoke hooks have lost handlers too
+	if (Plugins.Num() > 0)
+	{
+		InvalidatePureCaches();
+	}
+	PublishDispatchSnapshot(INDEX_NONE);
+
+	UE_LOG(ModSkeletonLog, Log, TEXT(" - Released %d plugins and %d connections of mod: %s"), Plugins.Num(), Disconnected, *ModName);
+}
+
+void UModSkeletonRegistry::UnmountMod(const FString& ModName, const FModSkeletonLoadedMod& Mod)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+
+	TArray<UPackage*> Packages;
+	for (TObjectIterator<UPackage> It; It; ++It)
+	{
+		if (It->GetName().StartsWith(Mod.RootPath))
+		{
+			Packages.Add(*It);
+		}
+	}
+
+	for (UPackage* Package : Packages)
+	{
+		AssetRegistry.PackageDeleted(Package);
+
+		// Detach the loader, which holds a handle into the pak, and let go of everything nothing else references
+		ResetLoaders(Package);
+		ForEachObjectWithOuter(Package, [](UObject* Object)
+		{
+			Object->ClearFlags(RF_Standalone | RF_Public);
+		});
+
+		// Anything still referenced keeps working against the old package, but the name is free for a reload to load afresh
+		const FName TrashName = MakeUniqueObjectName(nullptr, UPackage::StaticClass(), FName(*(UnloadedModPackagePrefix + ModName)));
+		Package->Rename(*TrashName.ToString(), nullptr, REN_DontCreateRedirectors | REN_NonTransactional | REN_ForceNoResetLoaders);
+		Package->ClearFlags(RF_Standalone | RF_Public);
+	}
+	AssetRegistry.RemovePath(Mod.RootPath.LeftChop(1));
+
+	FPackageName::UnRegisterMountPoint(Mod.RootPath, Mod.ContentPath);
+	if (!FModSkeletonPakLayer::Get().Unmount(Mod.PakFilename))
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Pak file of mod %s was not mounted: %s"), *ModName, *Mod.PakFilename);
+	}
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	UE_LOG(ModSkeletonLog, Log, TEXT(" - Unmounted %d packages of mod: %s"), Packages.Num(), *ModName);
+}
+
+FString UModSkeletonRegistry::FindModPakForFile(const FString& Filename) const
+{
+	FString PakFilename;
+	FModSkeletonPakLayer::Get().FindFile(Filename, PakFilename);
+	return PakFilename;
+}
+
+FModSkeletonHookHandle UModSkeletonRegistry::InstallHook(FModSkeletonHookDescription HookDescription)
+{
+	FModSkeletonHookHandle Hook = InternHook(FName(*HookDescription.HookName));
+	FModSkeletonHookEntry& Entry = RegisteredHooks[Hook.Index];
+	if (Entry.bInstalled)
+	{
+		return FModSkeletonHookHandle();
+	}
+	Entry.bInstalled = true;
+	Entry.Description = HookDescription;
+	PublishDispatchSnapshot(Hook.Index);
+	return Hook;
+}
+
+FModSkeletonHookHandle UModSkeletonRegistry::GetHookHandle(const FString& HookName)
+{
+	check(IsInGameThread());
+	return InternHook(FName(*HookName));
+}
+
+FModSkeletonHookHandle UModSkeletonRegistry::InternHook(const FName& HookName)
+{
+	// RegisteredHooks may grow here, workers only ever read the dispatch snapshots
+	check(IsInGameThread());
+	FModSkeletonHookHandle Hook;
+	Hook.HookName = HookName;
+
+	if (const int32* Index = HookIndices.Find(HookName))
+	{
+		Hook.Index = *Index;
+		return Hook;
+	}
+
+	Hook.Index = RegisteredHooks.AddDefaulted();
+	RegisteredHooks[Hook.Index].Name = HookName;
+	RegisteredHooks[Hook.Index].HookName = HookName.ToString();
+	HookIndices.Add(HookName, Hook.Index);
+	return Hook;
+}
+
+FModSkeletonHookEntry* UModSkeletonRegistry::FindHookEntry(const FModSkeletonHookHandle& Hook)
+{
+	if (RegisteredHooks.IsValidIndex(Hook.Index) && RegisteredHooks[Hook.Index].Name == Hook.HookName)
+	{
+		return &RegisteredHooks[Hook.Index];
+	}
+
+	// handle was resolved against a different registry instance (or default constructed)
+	if (const int32* Index = HookIndices.Find(Hook.HookName))
+	{
+		return &RegisteredHooks[*Index];
+	}
+	return nullptr;
+}
+
+TArray< FModSkeletonHookDescription > UModSkeletonRegistry::ListHooks()
+{
+	TArray< FModSkeletonHookDescription > OutArray;
+	for (const FModSkeletonHookEntry& Entry : RegisteredHooks)
+	{
+		if (Entry.bInstalled)
+		{
+			OutArray.Add(Entry.Description);
+		}
+	}
+	return OutArray;
+}
+
+FModSkeletonHookDescription UModSkeletonRegistry::GetHookDescription(const FString& HookName)
+{
+	check(IsInGameThread());
+	FModSkeletonHookHandle Hook;
+	Hook.HookName = FName(*HookName, FNAME_Find);
+	const FModSkeletonHookEntry* Entry = FindHookEntry(Hook);
+	if (Entry != nullptr && Entry->bInstalled)
+	{
+		return Entry->Description;
+	}
+	return FModSkeletonHookDescription();
+}
+
+void UModSkeletonRegistry::ConnectHook(const FString& HookName, int32 Priority, UObject *ModSkeletonPluginInterface)
+{
+	ConnectHookByHandle(InternHook(FName(*HookName)), Priority, ModSkeletonPluginInterface);
+}
+
+void UModSkeletonRegistry::ConnectHookByHandle(const FModSkeletonHookHandle& Hook, int32 Priority, UObject *ModSkeletonPluginInterface)
+{
+	if (Hook.HookName.IsNone() || !IsModSkeletonPlugin(ModSkeletonPluginInterface)) {
+		return;
+	}
+
+	FModSkeletonConnectHook NewHook;
+	NewHook.Hook = InternHook(Hook.HookName);
+	NewHook.Priority = Priority;
+	NewHook.ModSkeletonPluginInterface = ModSkeletonPluginInterface;
+	AddOrDeferConnection(NewHook);
+}
+
+void UModSkeletonRegistry::ConnectNativeHook(const FModSkeletonHookHandle& Hook, int32 Priority, const FModSkeletonNativeHookDelegate& Handler)
+{
+	if (Hook.HookName.IsNone() || !Handler.IsBound()) {
+		return;
+	}
+
+	FModSkeletonConnectHook NewHook;
+	NewHook.Hook = InternHook(Hook.HookName);
+	NewHook.Priority = Priority;
+	NewHook.ModSkeletonPluginInterface = nullptr;
+	NewHook.NativeHandler = MakeShareable(new FModSkeletonNativeHookDelegate(Handler));
+	AddOrDeferConnection(NewHook);
+}
+
+void UModSkeletonRegistry::ConnectNativeHook(const FModSkeletonHookHandle& Hook, int32 Priority, TFunction<void(const FString&, TArray< FBPVariant >&)> Handler)
+{
+	if (!Handler)
+	{
+		return;
+	}
+	ConnectNativeHook(Hook, Priority, FModSkeletonNativeHookDelegate::CreateLambda(MoveTemp(Handler)));
+}
+
+void UModSkeletonRegistry::AddOrDeferConnection(const FModSkeletonConnectHook& NewHook)
+{
+	if (RegisteredHooks[NewHook.Hook.Index].ActiveDispatches > 0)
+	{
+		PendingConnections.Add(NewHook);
+		return;
+	}
+
+	AddConnection(NewHook);
+}
+
+void UModSkeletonRegistry::AddConnection(const FModSkeletonConnectHook& NewHook)
+{
+	InvalidatePureCache(NewHook.Hook.Index);
+
+	TArray<FModSkeletonConnectHook>& Connections = RegisteredHooks[NewHook.Hook.Index].Connections;
+
+	// binary search for the first connection that sorts after the new one
+	FModSkeletonConnectHookPredicate Predicate;
+	int32 Low = 0;
+	int32 High = Connections.Num();
+	while (Low < High)
+	{
+		const int32 Mid = Low + (High - Low) / 2;
+		if (Predicate(NewHook, Connections[Mid]))
+		{
+			High = Mid;
+		}
+		else
+		{
+			Low = Mid + 1;
+		}
+	}
+	Connections.Insert(NewHook, Low);
+
+	PublishDispatchSnapshot(NewHook.Hook.Index);
+}
+
+TArray< UBPVariant* > UModSkeletonRegistry::InvokeHook(const FString& HookName, const TArray< UBPVariant * >& HookIO)
+{
+	FModSkeletonHookHandle Hook;
+	Hook.HookName = FName(*HookName, FNAME_Find);
+	if (Hook.HookName.IsNone())
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Ignoring Unregistered HookName: %s"), *HookName);
+		return HookIO;
+	}
+	return InvokeHookByHandle(Hook, HookIO);
+}
+
+TArray< UBPVariant* > UModSkeletonRegistry::InvokeHookByHandle(const FModSkeletonHookHandle& Hook, const TArray< UBPVariant * >& HookIO)
+{
+	if (!IsInGameThread())
+	{
+		// UBPVariants are UObjects, only the game thread may create them
+		UE_LOG(ModSkeletonLog, Error, TEXT("InvokeHook of %s ignored, UBPVariant HookIO can only be used on the game thread. Use InvokeHookValues instead."), *Hook.HookName.ToString());
+		return HookIO;
+	}
+
+	const int32 HookIndex = FindInstalledHookIndex(Hook);
+	if (HookIndex == INDEX_NONE)
+	{
+		return HookIO;
+	}
+
+	if (bRecycleHookVariants)
+	{
+		VariantPool->BeginScope();
+	}
+
+	FModSkeletonHookIOFrame Frame(this);
+	Frame.SetObjects(TArray< UBPVariant* >(HookIO));
+	DispatchHook(HookIndex, Frame);
+	TArray< UBPVariant* > Result = MoveTemp(Frame.GetObjects());
+
+	if (bRecycleHookVariants)
+	{
+		VariantPool->EndScope(HookIO, Result);
+	}
+	return Result;
+}
+
+TArray< FBPVariant > UModSkeletonRegistry::InvokeHookValues(const FString& HookName, const TArray< FBPVariant >& HookIO)
+{
+	FModSkeletonHookHandle Hook;
+	Hook.HookName = FName(*HookName, FNAME_Find);
+	if (Hook.HookName.IsNone())
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Ignoring Unregistered HookName: %s"), *HookName);
+		return HookIO;
+	}
+	return InvokeHookValuesByHandle(Hook, HookIO);
+}
+
+TArray< FBPVariant > UModSkeletonRegistry::InvokeHookValuesByHandle(const FModSkeletonHookHandle& Hook, const TArray< FBPVariant >& HookIO)
+{
+	TArray< FBPVariant > Result(HookIO);
+	InvokeHookValuesInPlace(Hook, Result);
+	return Result;
+}
+
+void UModSkeletonRegistry::InvokeHookValuesInPlace(const FModSkeletonHookHandle& Hook, TArray< FBPVariant >& HookIO)
+{
+	if (!IsInGameThread())
+	{
+		DispatchFromSnapshot(Hook, HookIO, nullptr);
+		return;
+	}
+
+	const int32 HookIndex = FindInstalledHookIndex(Hook);
+	if (HookIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (bRecycleHookVariants)
+	{
+		VariantPool->BeginScope();
+	}
+
+	FModSkeletonHookIOFrame Frame(this);
+	Frame.SetValues(MoveTemp(HookIO));
+	DispatchHook(HookIndex, Frame);
+	HookIO = MoveTemp(Frame.GetValues());
+
+	if (bRecycleHookVariants)
+	{
+		// value IO holds no UBPVariants, so everything converted along the way is temporary
+		VariantPool->EndScope(TArray< UBPVariant* >(), TArray< UBPVariant* >());
+	}
+}
+
+TArray< FModSkeletonPluginResult > UModSkeletonRegistry::InvokeHookBroadcastByHandle(const FModSkeletonHookHandle& Hook, const TArray< FBPVariant >& HookIO)
+{
+	TArray< FModSkeletonPluginResult > Results;
+	if (!IsInGameThread())
+	{
+		TArray< FBPVariant > Parameters(HookIO);
+		DispatchFromSnapshot(Hook, Parameters, &Results);
+		return Results;
+	}
+
+	const int32 HookIndex = FindInstalledHookIndex(Hook);
+	if (HookIndex == INDEX_NONE)
+	{
+		return Results;
+	}
+
+	FModSkeletonDispatchDepthScope DepthScope(DispatchDepth);
+
+	if (RegisteredHooks[HookIndex].DeferredPlugins.Num() > 0)
+	{
+		LoadDeferredPlugins(HookIndex);
+	}
+
+#if MODSKELETON_VALIDATE_HOOKIO
+	if (!ValidateHookIO(HookIndex, HookIO, TEXT("parameters")))
+	{
+		return Results;
+	}
+#endif
+
+	if (bRecycleHookVariants)
+	{
+		VariantPool->BeginScope();
+	}
+
+	BroadcastHook(HookIndex, HookIO, Results);
+
+#if MODSKELETON_VALIDATE_HOOKIO
+	for (const FModSkeletonPluginResult& Result : Results)
+	{
+		ValidateHookIO(HookIndex, Result.HookIO, TEXT("results"));
+	}
+#endif
+
+	if (bRecycleHookVariants)
+	{
+		VariantPool->EndScope(TArray< UBPVariant* >(), TArray< UBPVariant* >());
+	}
+	return Results;
+}
+
+FBPVariantPoolStats UModSkeletonRegistry::GetVariantPoolStats() const
+{
+	return VariantPool->GetStats();
+}
+
+int32 UModSkeletonRegistry::FindInstalledHookIndex(const FModSkeletonHookHandle& Hook)
+{
+	const FModSkeletonHookEntry* Entry = FindHookEntry(Hook);
+	if (Entry == nullptr || !Entry->bInstalled)
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Ignoring Unregistered HookName: %s"), *Hook.HookName.ToString());
+		return INDEX_NONE;
+	}
+	return static_cast<int32>(Entry - RegisteredHooks.GetData());
+}
+
+void UModSkeletonRegistry::DispatchHook(int32 HookIndex, FModSkeletonHookIOFrame& HookIO)
+{
+	FModSkeletonDispatchDepthScope DepthScope(DispatchDepth);
+
+	// Free dispatch snapshots that worker threads have finished with
+	DispatchSnapshots.Reclaim();
+
+	// First invocation of a hook declared by lazily loaded mods - bring them in so they can connect
+	if (RegisteredHooks[HookIndex].DeferredPlugins.Num() > 0)
+	{
+		LoadDeferredPlugins(HookIndex);
+	}
+
+#if MODSKELETON_PROFILING
+	SCOPE_CYCLE_COUNTER(STAT_ModSkeletonInvokeHook);
+#endif
+
+	// Handlers may intern or install hooks, which can reallocate RegisteredHooks - only hold on to the index
+	UE_LOG(ModSkeletonLog, Verbose, TEXT("Invoke HookName: %s"), *RegisteredHooks[HookIndex].HookName);
+	const bool bParallelBroadcast = RegisteredHooks[HookIndex].Description.ParallelBroadcast;
+	const bool bPure = RegisteredHooks[HookIndex].Description.Pure;
+
+#if MODSKELETON_VALIDATE_HOOKIO
+	// Handlers of a hook with a schema read HookIO unchecked, so don't let them see anything else
+	if (!ValidateHookIO(HookIndex, HookIO, TEXT("parameters")))
+	{
+		return;
+	}
+#endif
+
+	if (bParallelBroadcast)
+	{
+		// broadcast handlers don't chain, so HookIO is passed back unchanged
+		TArray< FModSkeletonPluginResult > Results;
+		BroadcastHook(HookIndex, HookIO.GetValues(), Results);
+		return;
+	}
+
+	if (bPure)
+	{
+		DispatchPureHook(HookIndex, HookIO);
+	}
+	else
+	{
+		InvokeHandlers(HookIndex, HookIO);
+	}
+
+#if MODSKELETON_VALIDATE_HOOKIO
+	ValidateHookIO(HookIndex, HookIO, TEXT("results"));
+#endif
+}
+
+bool UModSkeletonRegistry::ValidateHookIO(int32 HookIndex, const FModSkeletonHookIOFrame& HookIO, const TCHAR* Boundary) const
+{
+	return HookIO.MatchesHookIOTypes(RegisteredHooks[HookIndex], Boundary);
+}
+
+bool UModSkeletonRegistry::ValidateHookIO(int32 HookIndex, const TArray< FBPVariant >& HookIO, const TCHAR* Boundary) const
+{
+	const FModSkeletonHookEntry& Entry = RegisteredHooks[HookIndex];
+	return MatchesHookIOTypes(Entry.HookName, Entry.Description.HookIOTypes, HookIO, Boundary);
+}
+
+void UModSkeletonRegistry::InvokeHandlers(int32 HookIndex, FModSkeletonHookIOFrame& HookIO)
+{
+	const FModSkeletonHookEntry& Entry = RegisteredHooks[HookIndex];
+
+	// We want to pass the RESULTS from the previous invocation in as the PARAMETERS to the next
+
+	if (Entry.Description.AlwaysInvoke) {
+		// Plugins loaded by a handler are appended, so index iteration stays valid
+		const FName HookKey = Entry.Name;
+		const FString HookName = Entry.HookName;
+		for (int32 i = 0; i < LoadedPluginList.Num(); ++i)
+		{
+			InvokePlugin(LoadedPluginList[i], HookKey, HookName, HookIO);
+		}
+	}
+	else if (Entry.Connections.Num() > 0)
+	{
+		// ConnectHook defers connections to a hook while it is being dispatched, so the connection list cannot change under us
+		const FName HookKey = Entry.Name;
+		const FString HookName = Entry.HookName;
+		++RegisteredHooks[HookIndex].ActiveDispatches;
+		for (int32 i = 0; i < RegisteredHooks[HookIndex].Connections.Num(); ++i)
+		{
+			const FModSkeletonConnectHook& Connection = RegisteredHooks[HookIndex].Connections[i];
+			if (Connection.NativeHandler.IsValid())
+			{
+				// hold a reference, the handler may reallocate RegisteredHooks
+				TSharedPtr<FModSkeletonNativeHookDelegate> Handler = Connection.NativeHandler;
+				InvokeNativeHandler(*Handler, HookKey, HookName, HookIO);
+			}
+			else
+			{
+				InvokePlugin(Connection.ModSkeletonPluginInterface, HookKey, HookName, HookIO);
+			}
+		}
+
+		if (--RegisteredHooks[HookIndex].ActiveDispatches == 0 && PendingConnections.Num() > 0)
+		{
+			ApplyPendingConnections(HookIndex);
+		}
+	}
+}
+
+void UModSkeletonRegistry::DispatchPureHook(int32 HookIndex, FModSkeletonHookIOFrame& HookIO)
+{
+	FModSkeletonHookEntry& Entry = RegisteredHooks[HookIndex];
+	if (Entry.PureCache.Num() == 0)
+	{
+		Entry.PureCache.SetNum(FMath::Max(1, Entry.Description.PureCacheSize));
+	}
+
+	const uint32 Hash = HookIO.GetStructuralHash();
+	const int32 Slot = Hash % static_cast<uint32>(Entry.PureCache.Num());
+	const FModSkeletonPureCacheEntry& Cached = Entry.PureCache[Slot];
+	if (Cached.bValid && Cached.Hash == Hash && HookIO.StructurallyEquals(Cached.Input))
+	{
+		++Entry.PureCacheStats.Hits;
+#if MODSKELETON_PROFILING
+		INC_DWORD_STAT(STAT_ModSkeletonPureCacheHits);
+#endif
+		HookIO.SetValues(TArray< FBPVariant >(Cached.Result));
+		return;
+	}
+
+	++Entry.PureCacheStats.Misses;
+#if MODSKELETON_PROFILING
+	INC_DWORD_STAT(STAT_ModSkeletonPureCacheMisses);
+#endif
+	TArray< FBPVariant > Input;
+	HookIO.CopyValues(Input);
+	const int32 Generation = Entry.PureCacheGeneration;
+
+	InvokeHandlers(HookIndex, HookIO);
+
+	// Handlers may have changed the handler set (or reallocated RegisteredHooks) - don't keep a result that could be stale
+	FModSkeletonHookEntry& After = RegisteredHooks[HookIndex];
+	if (After.PureCacheGeneration == Generation && After.PureCache.IsValidIndex(Slot))
+	{
+		FModSkeletonPureCacheEntry& Store = After.PureCache[Slot];
+		Store.bValid = true;
+		Store.Hash = Hash;
+		Store.Input = MoveTemp(Input);
+		HookIO.CopyValues(Store.Result);
+	}
+}
+
+void UModSkeletonRegistry::InvalidatePureCache(int32 HookIndex)
+{
+	FModSkeletonHookEntry& Entry = RegisteredHooks[HookIndex];
+	++Entry.PureCacheGeneration;
+	if (Entry.PureCache.Num() > 0)
+	{
+		Entry.PureCache.Empty();
+		++Entry.PureCacheStats.Invalidations;
+	}
+}
+
+void UModSkeletonRegistry::InvalidatePureCaches()
+{
+	for (int32 i = 0; i < RegisteredHooks.Num(); ++i)
+	{
+		if (RegisteredHooks[i].Description.Pure)
+		{
+			InvalidatePureCache(i);
+		}
+	}
+}
+
+FModSkeletonPureCacheStats UModSkeletonRegistry::GetPureCacheStats(const FModSkeletonHookHandle& Hook)
+{
+	const FModSkeletonHookEntry* Entry = FindHookEntry(Hook);
+	return Entry != nullptr ? Entry->PureCacheStats : FModSkeletonPureCacheStats();
+}
+
+void UModSkeletonRegistry::BroadcastHook(int32 HookIndex, const TArray< FBPVariant >& HookIO, TArray< FModSkeletonPluginResult >& OutResults)
+{
+	const FModSkeletonHookEntry& Entry = RegisteredHooks[HookIndex];
+	const FName HookKey = Entry.Name;
+	const FString HookName = Entry.HookName;
+	const bool bParallel = Entry.Description.ParallelBroadcast;
+
+	// Snapshot the handlers up front, Blueprint handlers may connect or load plugins while we run
+	TArray< TSharedPtr<FModSkeletonNativeHookDelegate> > NativeHandlers;
+	OutResults.Reset();
+	if (Entry.Description.AlwaysInvoke)
+	{
+		for (UObject* Plugin : LoadedPluginList)
+		{
+			OutResults[OutResults.AddDefaulted()].Plugin = Plugin;
+			NativeHandlers.AddDefaulted();
+		}
+	}
+	else
+	{
+		for (const FModSkeletonConnectHook& Connection : Entry.Connections)
+		{
+			OutResults[OutResults.AddDefaulted()].Plugin = Connection.NativeHandler.IsValid() ? Connection.NativeHandler->GetUObject() : Connection.ModSkeletonPluginInterface;
+			NativeHandlers.Add(Connection.NativeHandler);
+		}
+	}
+
+	TArray<int32> NativeIndices;
+	TArray<int32> BlueprintIndices;
+	for (int32 i = 0; i < OutResults.Num(); ++i)
+	{
+		OutResults[i].HookIO = HookIO;
+		if (NativeHandlers[i].IsValid() || Cast<IModSkeletonNativePluginInterface>(OutResults[i].Plugin) != nullptr)
+		{
+			NativeIndices.Add(i);
+		}
+		else if (OutResults[i].Plugin != nullptr)
+		{
+			BlueprintIndices.Add(i);
+		}
+	}
+
+	{
+#if MODSKELETON_PROFILING
+		SCOPE_CYCLE_COUNTER(STAT_ModSkeletonBroadcastNative);
+#endif
+		// Every native handler works on its own copy of HookIO, so they can run side by side
+		// The profiler is game thread only, these calls are only covered by the cycle counter above
+		ParallelFor(NativeIndices.Num(), [&OutResults, &NativeHandlers, &NativeIndices, &HookName](int32 i)
+		{
+			const int32 Index = NativeIndices[i];
+			FModSkeletonPluginResult& Result = OutResults[Index];
+			if (NativeHandlers[Index].IsValid())
+			{
+				NativeHandlers[Index]->ExecuteIfBound(HookName, Result.HookIO);
+			}
+			else
+			{
+				Cast<IModSkeletonNativePluginInterface>(Result.Plugin)->ModSkeletonNativeHook(HookName, Result.HookIO);
+			}
+		}, !bParallel);
+	}
+
+	for (int32 Index : BlueprintIndices)
+	{
+		FModSkeletonHookIOFrame Frame(this);
+		Frame.SetValues(MoveTemp(OutResults[Index].HookIO));
+		InvokePlugin(OutResults[Index].Plugin, HookKey, HookName, Frame);
+		OutResults[Index].HookIO = MoveTemp(Frame.GetValues());
+	}
+}
+
+void UModSkeletonRegistry::ApplyPendingConnections(int32 HookIndex)
+{
+	for (int32 i = 0; i < PendingConnections.Num(); )
+	{
+		if (PendingConnections[i].Hook.Index == HookIndex)
+		{
+			AddConnection(PendingConnections[i]);
+			PendingConnections.RemoveAt(i, 1, false);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+void UModSkeletonRegistry::PublishDispatchSnapshot(int32 HookIndex)
+{
+	const FModSkeletonDispatchSnapshot& Current = DispatchSnapshots.GetCurrent();
+	FModSkeletonDispatchSnapshot* Next = new FModSkeletonDispatchSnapshot();
+
+	// Hooks that did not change are shared with the current snapshot
+	Next->Hooks = Current.Hooks;
+	Next->Hooks.SetNum(RegisteredHooks.Num());
+	Next->HookIndices = Current.HookIndices;
+	for (int32 i = 0; i < RegisteredHooks.Num(); ++i)
+	{
+		if ((HookIndex == INDEX_NONE || HookIndex == i) && RegisteredHooks[i].bInstalled)
+		{
+			Next->Hooks[i] = BuildHookSnapshot(i);
+			Next->HookIndices.Add(RegisteredHooks[i].Name, i);
+		}
+	}
+	DispatchSnapshots.Publish(Next);
+}
+
+TSharedPtr<const FModSkeletonHookSnapshot, ESPMode::ThreadSafe> UModSkeletonRegistry::BuildHookSnapshot(int32 HookIndex) const
+{
+	const FModSkeletonHookEntry& Entry = RegisteredHooks[HookIndex];
+	TSharedPtr<FModSkeletonHookSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShareable(new FModSkeletonHookSnapshot());
+	Snapshot->Name = Entry.Name;
+	Snapshot->HookName = Entry.HookName;
+	Snapshot->HookIOTypes = Entry.Description.HookIOTypes;
+	Snapshot->bParallelBroadcast = Entry.Description.ParallelBroadcast;
+	Snapshot->bHasDeferredPlugins = Entry.DeferredPlugins.Num() > 0;
+
+	auto AddPlugin = [&Snapshot](UObject* Plugin)
+	{
+		if (IModSkeletonNativePluginInterface* NativePlugin = Cast<IModSkeletonNativePluginInterface>(Plugin))
+		{
+			FModSkeletonSnapshotHandler& Handler = Snapshot->Handlers[Snapshot->Handlers.AddDefaulted()];
+			Handler.NativePlugin = NativePlugin;
+			Handler.Plugin = Plugin;
+		}
+		else
+		{
+			++Snapshot->GameThreadHandlers;
+		}
+	};
+
+	if (Entry.Description.AlwaysInvoke)
+	{
+		for (UObject* Plugin : LoadedPluginList)
+		{
+			AddPlugin(Plugin);
+		}
+	}
+	else
+	{
+		for (const FModSkeletonConnectHook& Connection : Entry.Connections)
+		{
+			if (Connection.NativeHandler.IsValid())
+			{
+				FModSkeletonSnapshotHandler& Handler = Snapshot->Handlers[Snapshot->Handlers.AddDefaulted()];
+				Handler.Delegate = Connection.NativeHandler;
+				Handler.Plugin = Connection.NativeHandler->GetUObject();
+			}
+			else
+			{
+				AddPlugin(Connection.ModSkeletonPluginInterface);
+			}
+		}
+	}
+	return Snapshot;
+}
+
+void UModSkeletonRegistry::DispatchFromSnapshot(const FModSkeletonHookHandle& Hook, TArray< FBPVariant >& HookIO, TArray< FModSkeletonPluginResult >* OutBroadcastResults) const
+{
+	// Pins the snapshot until we return, a concurrent ConnectHook or InstallHook publishes a new one instead of changing it
+	FModSkeletonDispatchSnapshotPublisher::FReadScope Snapshot(DispatchSnapshots);
+	const FModSkeletonHookSnapshot* HookSnapshot = Snapshot->FindHook(Hook.HookName, Hook.Index);
+	if (HookSnapshot == nullptr)
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Ignoring Unregistered HookName: %s"), *Hook.HookName.ToString());
+		return;
+	}
+
+	if (HookSnapshot->GameThreadHandlers > 0 || HookSnapshot->bHasDeferredPlugins)
+	{
+		UE_LOG(ModSkeletonLog, Verbose, TEXT("Invoke HookName off the game thread: %s, skipping %d Blueprint handlers%s"),
+			*HookSnapshot->HookName, HookSnapshot->GameThreadHandlers, HookSnapshot->bHasDeferredPlugins ? TEXT(" and deferred plugins") : TEXT(""));
+	}
+
+#if MODSKELETON_VALIDATE_HOOKIO
+	if (!MatchesHookIOTypes(HookSnapshot->HookName, HookSnapshot->HookIOTypes, HookIO, TEXT("parameters")))
+	{
+		return;
+	}
+#endif
+
+	const TArray<FModSkeletonSnapshotHandler>& Handlers = HookSnapshot->Handlers;
+	const FString& HookName = HookSnapshot->HookName;
+
+	if (OutBroadcastResults != nullptr || HookSnapshot->bParallelBroadcast)
+	{
+		// Same as BroadcastHook: every handler gets its own copy, and HookIO itself is passed back unchanged
+		TArray< FModSkeletonPluginResult > DiscardedResults;
+		TArray< FModSkeletonPluginResult >& Results = OutBroadcastResults != nullptr ? *OutBroadcastResults : DiscardedResults;
+		Results.Reset();
+		Results.SetNum(Handlers.Num());
+		for (int32 i = 0; i < Handlers.Num(); ++i)
+		{
+			Results[i].Plugin = Handlers[i].Plugin;
+			Results[i].HookIO = HookIO;
+		}
+
+		ParallelFor(Handlers.Num(), [&Results, &Handlers, &HookName](int32 i)
+		{
+			Handlers[i].Execute(HookName, Results[i].HookIO);
+		}, !HookSnapshot->bParallelBroadcast);
+
+#if MODSKELETON_VALIDATE_HOOKIO
+		for (const FModSkeletonPluginResult& Result : Results)
+		{
+			MatchesHookIOTypes(HookName, HookSnapshot->HookIOTypes, Result.HookIO, TEXT("results"));
+		}
+#endif
+		return;
+	}
+
+	// Pure hooks are not cached here, the cache belongs to the game thread. Running the handlers gives the same result.
+	for (const FModSkeletonSnapshotHandler& Handler : Handlers)
+	{
+		Handler.Execute(HookName, HookIO);
+	}
+
+#if MODSKELETON_VALIDATE_HOOKIO
+	MatchesHookIOTypes(HookName, HookSnapshot->HookIOTypes, HookIO, TEXT("results"));
+#endif
+}
+
+void UModSkeletonRegistry::DeferPlugins(const TArray<FName>& ObjectPaths, const TArray<FString>& HookNames)
+{
+	for (const FString& HookName : HookNames)
+	{
+		const FModSkeletonHookHandle Hook = InternHook(FName(*HookName));
+		for (const FName& ObjectPath : ObjectPaths)
+		{
+			RegisteredHooks[Hook.Index].DeferredPlugins.AddUnique(ObjectPath);
+		}
+	}
+	PublishDispatchSnapshot(INDEX_NONE);
+}
+
+void UModSkeletonRegistry::LoadDeferredPlugins(int32 HookIndex)
+{
+	TArray<FName> ObjectPaths = MoveTemp(RegisteredHooks[HookIndex].DeferredPlugins);
+	RegisteredHooks[HookIndex].DeferredPlugins.Reset();
+	UE_LOG(ModSkeletonLog, Log, TEXT("Loading %d deferred plugins for HookName: %s"), ObjectPaths.Num(), *RegisteredHooks[HookIndex].HookName);
+
+	// plugins declaring several hooks are only loaded once, both paths skip those already loaded
+	if (bBlockOnPluginLoads)
+	{
+		InitModPlugins(ObjectPaths);
+	}
+	else
+	{
+		// This invocation goes ahead without them, they connect as they finish loading
+		LoadModPlugins(ObjectPaths, TFunction<void(int32)>());
+	}
+	PublishDispatchSnapshot(HookIndex);
+}
+
+bool UModSkeletonRegistry::IsModSkeletonPlugin(UObject* Plugin)
+{
+	return Plugin != nullptr && (
+		Plugin->GetClass()->ImplementsInterface(UModSkeletonNativePluginInterface::StaticClass()) ||
+		Plugin->GetClass()->ImplementsInterface(UModSkeletonValuePluginInterface::StaticClass()) ||
+		Plugin->GetClass()->ImplementsInterface(UModSkeletonPluginInterface::StaticClass()));
+}
+
+void UModSkeletonRegistry::InvokePlugin(UObject* Plugin, const FName& HookKey, const FString& HookName, FModSkeletonHookIOFrame& HookIO)
+{
+	MODSKELETON_PROFILE_PLUGIN_CALL(HookKey, Plugin);
+
+	if (IModSkeletonNativePluginInterface* NativePlugin = Cast<IModSkeletonNativePluginInterface>(Plugin))
+	{
+		NativePlugin->ModSkeletonNativeHook(HookName, HookIO.GetValues());
+	}
+	else if (Plugin->GetClass()->ImplementsInterface(UModSkeletonValuePluginInterface::StaticClass()))
+	{
+		HookIO.SetValues(IModSkeletonValuePluginInterface::Execute_ModSkeletonValueHook(Plugin, HookName, HookIO.GetValues()));
+	}
+	else
+	{
+		HookIO.SetObjects(IModSkeletonPluginInterface::Execute_ModSkeletonHook(Plugin, HookName, HookIO.GetObjects()));
+	}
+}
+
+void UModSkeletonRegistry::InvokeNativeHandler(const FModSkeletonNativeHookDelegate& Handler, const FName& HookKey, const FString& HookName, FModSkeletonHookIOFrame& HookIO)
+{
+	MODSKELETON_PROFILE_PLUGIN_CALL(HookKey, Handler.GetUObject());
+
+	Handler.ExecuteIfBound(HookName, HookIO.GetValues());
 }
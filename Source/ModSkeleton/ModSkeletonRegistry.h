@@ -15,8 +15,35 @@
 #pragma once
 
 #include "UObject/NoExportTypes.h"
+#include "BPVariant.h"
+#include "BPVariantPool.h"
+#include "ModSkeletonNativePluginInterface.h"
 #include "ModSkeletonRegistry.generated.h"
 
+#include "ModSkeletonScanCache.h"
+#include "ModSkeletonModManifest.h"
+#include "ModSkeletonDispatchSnapshot.h"
+#include "ModSkeletonProfiler.h"
+
+/**
+ * Check HookIO against the HookIOTypes schema of a hook on the way in and out of every invocation.
+ * Off in Shipping builds, where handlers rely on the schema without any check.
+ */
+#ifndef MODSKELETON_VALIDATE_HOOKIO
+#define MODSKELETON_VALIDATE_HOOKIO !UE_BUILD_SHIPPING
+#endif
+
+struct FModSkeletonHookIOFrame;
+class FModSkeletonPakLayer;
+class FModSkeletonPakWatcher;
+class FModSkeletonPluginLoader;
+class IAssetRegistry;
+class IPlatformFile;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FModSkeletonScanProgressDelegate, int32, CompletedMods, int32, TotalMods, const FString&, ModName);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FModSkeletonScanCompleteDelegate, int32, NewPlugins);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FModSkeletonModsChangedDelegate, const TArray<FString>&, AddedMods, const TArray<FString>&, ReloadedMods, const TArray<FString>&, RemovedMods);
+
 /**
  * This struct describes the API of an individual hook
  */
@@ -25,6 +52,14 @@ struct FModSkeletonHookDescription
 {
 	GENERATED_BODY()
 
+	FModSkeletonHookDescription()
+		: AlwaysInvoke(false)
+		, ParallelBroadcast(false)
+		, Pure(false)
+		, PureCacheSize(256)
+	{
+	}
+
 	/**
 	 * AlwaysInvoke Hooks to not participate in prioritization, and, when invoked,
 	 * are called on every registered ModPlugin.
@@ -33,6 +68,29 @@ struct FModSkeletonHookDescription
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeletonHookDescription")
 	bool AlwaysInvoke;
 
+	/**
+	 * ParallelBroadcast Hooks are notifications: every handler gets its own copy of the HookIO
+	 * instead of the previous handler's result, and the results are collected per handler
+	 * (see InvokeHookBroadcastByHandle). Native handlers run concurrently on the task graph,
+	 * so they must be thread safe. Blueprint handlers still run on the game thread.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeletonHookDescription")
+	bool ParallelBroadcast;
+
+	/**
+	 * Pure Hooks promise their result depends only on the HookIO passed in.
+	 * Results are cached by the structure of the input HookIO, and handlers only run on a cache miss.
+	 * The cache is cleared whenever a connection is made to the hook or new plugins are loaded.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeletonHookDescription")
+	bool Pure;
+
+	/**
+	 * Number of results a Pure hook keeps. Inputs that hash to the same slot replace each other.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeletonHookDescription")
+	int32 PureCacheSize;
+
 	/**
 	 * Globally unique name of the hook
 	 */
@@ -55,6 +113,72 @@ struct FModSkeletonHookDescription
 	 */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeletonHookDescription")
 	TArray<FString> HookIODescription;
+
+	/**
+	 * Optional machine readable schema: the type of each element of HookIO.
+	 * It covers both parameters and results, since each handler's results are the next handler's parameters.
+	 * When set, HookIO is checked against it on entry to and exit from every invocation (see MODSKELETON_VALIDATE_HOOKIO),
+	 * and typed native handlers are checked against it once when they connect.
+	 * Handlers of a hook with a schema may then read HookIO with the GetAs*Unchecked accessors.
+	 * Leave empty for a free-form hook.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeletonHookDescription")
+	TArray<EBPVariantType> HookIOTypes;
+};
+
+/**
+ * HookIO produced by a single handler of a broadcast hook
+ */
+USTRUCT(BlueprintType, Category = "ModSkeleton")
+struct FModSkeletonPluginResult
+{
+	GENERATED_BODY()
+
+	FModSkeletonPluginResult()
+		: Plugin(nullptr)
+	{
+	}
+
+	/**
+	 * The plugin, or the object a native handler is bound to (nullptr for unbound native handlers)
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "ModSkeletonPluginResult")
+	UObject* Plugin;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ModSkeletonPluginResult")
+	TArray< FBPVariant > HookIO;
+};
+
+/**
+ * Interned reference to a hook. Resolve once with GetHookHandle / InstallHook,
+ * then cache it to invoke or connect without any string hashing or comparison.
+ */
+USTRUCT(BlueprintType, Category = "ModSkeleton")
+struct MODSKELETON_API FModSkeletonHookHandle
+{
+	GENERATED_BODY()
+
+	FModSkeletonHookHandle()
+		: Index(INDEX_NONE)
+	{
+	}
+
+	bool IsValid() const
+	{
+		return Index != INDEX_NONE;
+	}
+
+	/**
+	 * Interned name of the hook
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "ModSkeletonHookHandle")
+	FName HookName;
+
+	/**
+	 * Slot of the hook in the registry hook table
+	 */
+	UPROPERTY()
+	int32 Index;
 };
 
 /**
@@ -66,10 +190,10 @@ struct FModSkeletonConnectHook
 	GENERATED_BODY()
 
 	/**
-	 * Connected HookName
+	 * Connected Hook
 	 */
 	UPROPERTY()
-	FString HookName;
+	FModSkeletonHookHandle Hook;
 
 	/**
 	 * Priority - higher numbers are invoked first
@@ -79,14 +203,21 @@ struct FModSkeletonConnectHook
 
 	/**
 	 * Link to the UObject on which to invoke this hook.
-	 * Must implement ModSkeletonPluginInterface
+	 * Must implement ModSkeletonPluginInterface, ModSkeletonValuePluginInterface or ModSkeletonNativePluginInterface
+	 * nullptr for native handler connections
 	 */
 	UPROPERTY()
 	UObject *ModSkeletonPluginInterface;
+
+	/**
+	 * Set for connections made with ConnectNativeHook
+	 * Shared so dispatch can keep the handler alive while a handler reallocates the connection list
+	 */
+	TSharedPtr<FModSkeletonNativeHookDelegate> NativeHandler;
 };
 
 /**
- * Heap priority sort predicate helper
+ * Priority sort predicate helper
  */
 struct FModSkeletonConnectHookPredicate
 {
@@ -97,9 +228,227 @@ struct FModSkeletonConnectHookPredicate
 	}
 };
 
+/**
+ * Counters for the result cache of a Pure hook
+ */
+USTRUCT(BlueprintType, Category = "ModSkeleton")
+struct FModSkeletonPureCacheStats
+{
+	GENERATED_BODY()
+
+	FModSkeletonPureCacheStats()
+		: Hits(0)
+		, Misses(0)
+		, Invalidations(0)
+	{
+	}
+
+	UPROPERTY(BlueprintReadOnly, Category = "ModSkeletonPureCacheStats")
+	int32 Hits;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ModSkeletonPureCacheStats")
+	int32 Misses;
+
+	/**
+	 * Times the cache was cleared because the set of handlers changed
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "ModSkeletonPureCacheStats")
+	int32 Invalidations;
+};
+
+/**
+ * This is an internal structure holding one cached result of a Pure hook
+ */
+USTRUCT()
+struct FModSkeletonPureCacheEntry
+{
+	GENERATED_BODY()
+
+	FModSkeletonPureCacheEntry()
+		: bValid(false)
+		, Hash(0)
+	{
+	}
+
+	UPROPERTY()
+	bool bValid;
+
+	UPROPERTY()
+	uint32 Hash;
+
+	UPROPERTY()
+	TArray< FBPVariant > Input;
+
+	UPROPERTY()
+	TArray< FBPVariant > Result;
+};
+
+/**
+ * This is an internal structure holding everything the registry knows about a single interned hook name
+ */
+USTRUCT()
+struct FModSkeletonHookEntry
+{
+	GENERATED_BODY()
+
+	FModSkeletonHookEntry()
+		: bInstalled(false)
+		, ActiveDispatches(0)
+		, PureCacheGeneration(0)
+	{
+	}
+
+	/**
+	 * Interned name, used to validate handles
+	 */
+	UPROPERTY()
+	FName Name;
+
+	/**
+	 * HookName as passed to ModSkeletonHook, kept so dispatch never has to convert the FName
+	 */
+	UPROPERTY()
+	FString HookName;
+
+	/**
+	 * A hook may be interned (by GetHookHandle or ConnectHook) before it is installed
+	 */
+	UPROPERTY()
+	bool bInstalled;
+
+	/**
+	 * Description passed to InstallHook
+	 */
+	UPROPERTY()
+	FModSkeletonHookDescription Description;
+
+	/**
+	 * Connections to this hook, kept sorted with FModSkeletonConnectHookPredicate
+	 * Connections of equal priority are invoked in the order they were connected
+	 */
+	UPROPERTY()
+	TArray<FModSkeletonConnectHook> Connections;
+
+	/**
+	 * Object paths of MOD_SKELETON plugins whose manifest declares this hook, but which have not been loaded yet
+	 */
+	UPROPERTY()
+	TArray<FName> DeferredPlugins;
+
+	/**
+	 * Number of dispatches of this hook currently on the stack
+	 */
+	int32 ActiveDispatches;
+
+	/**
+	 * Results of a Pure hook, indexed by input hash modulo Description.PureCacheSize. Allocated on first use.
+	 */
+	UPROPERTY()
+	TArray<FModSkeletonPureCacheEntry> PureCache;
+
+	FModSkeletonPureCacheStats PureCacheStats;
+
+	/**
+	 * Bumped on every invalidation, so a result computed across one is not stored
+	 */
+	int32 PureCacheGeneration;
+};
+
+/**
+ * This is an internal structure describing a mounted mod pak, kept so it can be unloaded or reloaded
+ */
+USTRUCT()
+struct FModSkeletonLoadedMod
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FString PakFilename;
+
+	UPROPERTY()
+	FString BinFilename;
+
+	/**
+	 * Directory the pak is mounted at
+	 */
+	UPROPERTY()
+	FString MountPoint;
+
+	/**
+	 * Package root registered for the mod ("/<ModName>/") and the content path it maps to
+	 */
+	UPROPERTY()
+	FString RootPath;
+
+	UPROPERTY()
+	FString ContentPath;
+
+	/**
+	 * Every MOD_SKELETON plugin found in the mod, whether loaded or deferred
+	 */
+	UPROPERTY()
+	TArray<FName> PluginObjectPaths;
+};
+
+/**
+ * This is an internal structure tracking a single mod pak through ScanForModPlugins
+ */
+struct FModSkeletonPakScanEntry
+{
+	FModSkeletonPakScanEntry()
+		: bAssetDataLoaded(false)
+		, bMounted(false)
+		, bCached(false)
+		, bHasManifest(false)
+	{
+	}
+
+	FString ModName;
+	FString PakFilename;
+	FString BinFilename;
+	FString MountPoint;
+
+	/**
+	 * Contents of the .bin AssetRegistry, read off the game thread
+	 */
+	TArray<uint8> SerializedAssetData;
+	bool bAssetDataLoaded;
+
+	bool bMounted;
+
+	/**
+	 * Files in the pak, relative to its mount point, listed while validating it
+	 */
+	TArray<FString> PakFiles;
+
+	/**
+	 * Set if the scan cache says this mod is unchanged, CacheEntry then holds its file list and plugin paths.
+	 * Otherwise CacheEntry collects the keys to store for this mod once it has been scanned.
+	 */
+	bool bCached;
+	FModSkeletonScanCacheEntry CacheEntry;
+
+	/**
+	 * Contents of the optional "<ModName>.json" manifest
+	 */
+	bool bHasManifest;
+	FModSkeletonModManifest Manifest;
+	FString ManifestError;
+
+	/**
+	 * Reported from the game thread if the pak could not be validated or mounted
+	 */
+	FString Error;
+};
+
 /**
  * This object loads all mod packages, invokes any MOD_SKELETON ModSkeletonInit interfaces found
  * And keeps track of all registered mod hooks and connections.
+ *
+ * Loading, installing and connecting happen on the game thread. Value type hooks may also be invoked from any other
+ * thread: those invocations run the native handlers of a published snapshot of the hook table (see FModSkeletonDispatchSnapshot),
+ * which never takes a lock, so the native handlers of a hook invoked that way must be thread safe.
+ * Blueprint handlers, deferred plugins, the Pure cache and the profiler are game thread only, and are skipped off it.
  */
 UCLASS(BlueprintType)
 class MODSKELETON_API UModSkeletonRegistry : public UObject
@@ -109,25 +458,138 @@ class MODSKELETON_API UModSkeletonRegistry : public UObject
 public:
 	UModSkeletonRegistry();
 
+	/**
+	 * Keeps plugins alive while a dispatch snapshot that another thread may be calling still refers to them
+	 */
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
 	/**
 	 * Invoked automaticall by ModSkeletonGameInstance...
 	 * Should be safe to invoke at runtime to load any new modules added to directory
-	 * will not re-load any mods that have changed or un-load any deleted ones
+	 * will not re-load any mods that have changed or un-load any deleted ones, use ReloadMod / UnloadMod for those
 	 */
 	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
 	virtual void ScanForModPlugins();
 
+	/**
+	 * Same as ScanForModPlugins, but pak discovery, validation, mounting and AssetRegistry file reads happen off the
+	 * game thread. Merging the AssetRegistry data and ModSkeletonInit run back on the game thread.
+	 * Progress is reported through OnScanProgress, and OnScanComplete fires when done.
+	 * Returns false if a scan is already in progress.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual bool ScanForModPluginsAsync();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeleton")
+	virtual bool IsScanInProgress() const;
+
+	/**
+	 * Fired on the game thread as each mod pak has been prepared by ScanForModPluginsAsync
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "ModSkeleton")
+	FModSkeletonScanProgressDelegate OnScanProgress;
+
+	/**
+	 * MOD_SKELETON plugin classes requested from the async package loader at once while a scan loads plugins.
+	 * ModSkeletonInit still runs in the order the plugins were found. 0 requests them all together.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeleton")
+	int32 MaxConcurrentPluginLoads;
+
+	/**
+	 * Make ReloadMod, pak watcher rescans and the first invocation of a hook with deferred plugins wait on the game thread
+	 * until the plugins they bring in have loaded and run ModSkeletonInit. Off by default: those plugins stream in over
+	 * the following frames, and the invocation that triggered a deferred load does not reach them yet.
+	 * ScanForModPlugins always waits, ScanForModPluginsAsync never does.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeleton")
+	bool bBlockOnPluginLoads;
+
+	/**
+	 * Fired on the game thread once a scan has initialized all new plugins
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "ModSkeleton")
+	FModSkeletonScanCompleteDelegate OnScanComplete;
+
+	/**
+	 * Watch Content/Paks and, once changes have been quiet for DebounceSeconds, load mods whose .pak / .bin pair appeared,
+	 * ReloadMod those that changed and UnloadMod those that were deleted. Only the affected mods are scanned.
+	 * Uses the engine's directory watcher (inotify on Linux) where available, and polls every PollSeconds otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual void StartWatchingModPaks(float DebounceSeconds = 1.f, float PollSeconds = 2.f);
+
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual void StopWatchingModPaks();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeleton")
+	virtual bool IsWatchingModPaks() const;
+
+	/**
+	 * Fired on the game thread when watching Content/Paks has changed the set of loaded mods
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "ModSkeleton")
+	FModSkeletonModsChangedDelegate OnModsChanged;
+
+	/**
+	 * Remember each mod's plugin paths in Saved/ModSkeleton/ScanCache.bin, keyed by the size, timestamp and hash of
+	 * its .pak and .bin. Unchanged mods then skip pak validation and the search for their plugins on later launches.
+	 * Their AssetRegistry data is still merged, so the AssetRegistry lists their assets either way.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeleton")
+	bool bUseScanCache;
+
 	/**
 	 * Get a list of all loaded plugin init interfaces
 	 */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeleton")
 	virtual void ListModPlugins(TArray< UObject* >& OutPluginList);
 
+	/**
+	 * Names of the mod paks that are loaded (the pak filename without its extension)
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeleton")
+	virtual void ListMods(TArray< FString >& OutModNames);
+
+	/**
+	 * Disconnect a mod's plugins from every hook, release them so they can be garbage collected,
+	 * then remove its packages and AssetRegistry entries, unregister its mount point and unmount its pak.
+	 * Objects that other code still references stay alive, but are no longer called by any hook.
+	 * Called while a hook is being dispatched, the unload happens once dispatch has returned.
+	 * Returns false if the mod is not loaded.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual bool UnloadMod(const FString& ModName);
+
+	/**
+	 * UnloadMod, then mount the mod's pak again and ModSkeletonInit its plugins, picking up any changes to its files.
+	 * Unless bBlockOnPluginLoads is set, the plugins are initialized once they have streamed in, after this returns.
+	 * Returns false if the mod was not loaded, or could not be loaded again.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual bool ReloadMod(const FString& ModName);
+
+	/**
+	 * The mounted mod pak that provides a file, or an empty string if none does
+	 * A file provided by several mods belongs to the one mounted first, which is the one the pak layer serves
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeleton")
+	virtual FString FindModPakForFile(const FString& Filename) const;
+
 	/**
 	 * Install a new hook to the mod system
+	 * Returns an invalid handle if a hook with this name is already installed
 	 */
 	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
-	virtual bool InstallHook(FModSkeletonHookDescription HookDescription);
+	virtual FModSkeletonHookHandle InstallHook(FModSkeletonHookDescription HookDescription);
+
+	/**
+	 * Resolve a HookName to a handle that can be cached and passed to the *ByHandle functions
+	 * The hook does not need to be installed yet: an unknown name is interned, and stays registered, so this is not pure.
+	 * Game thread only; the handle may then be used from any thread.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual FModSkeletonHookHandle GetHookHandle(const FString& HookName);
 
 	/**
 	 * List all hooks that have been installed
@@ -136,29 +598,97 @@ public:
 	virtual TArray< FModSkeletonHookDescription > ListHooks();
 
 	/**
-	 * Get a HookDescription for a single hook
+	 * Get a HookDescription for a single hook. Game thread only.
 	 */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeleton")
-	virtual FModSkeletonHookDescription GetHookDescription(FString HookName);
+	virtual FModSkeletonHookDescription GetHookDescription(const FString& HookName);
 
 	/**
 	 * Connect a plugin interface to a HookName at a given priority
 	 */
 	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
-	virtual void ConnectHook(FString HookName, int32 Priority, UObject *ModSkeletonPluginInterface);
+	virtual void ConnectHook(const FString& HookName, int32 Priority, UObject *ModSkeletonPluginInterface);
+
+	/**
+	 * Connect a plugin interface to a hook handle at a given priority
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual void ConnectHookByHandle(const FModSkeletonHookHandle& Hook, int32 Priority, UObject *ModSkeletonPluginInterface);
+
+	/**
+	 * Connect a native handler to a hook handle at a given priority
+	 * It is called directly, without the Blueprint VM, interleaved in priority order with plugin interface connections.
+	 * Handlers bound to a UObject or shared pointer are skipped once it is gone. A bound UObject is not garbage collected
+	 * while it is connected, or while another thread may still be calling it, but one that is destroyed explicitly still goes.
+	 */
+	void ConnectNativeHook(const FModSkeletonHookHandle& Hook, int32 Priority, const FModSkeletonNativeHookDelegate& Handler);
+	void ConnectNativeHook(const FModSkeletonHookHandle& Hook, int32 Priority, TFunction<void(const FString&, TArray< FBPVariant >&)> Handler);
+
+	/**
+	 * Invoke an installed hook. Game thread only.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual TArray< UBPVariant* > InvokeHook(const FString& HookName, const TArray< UBPVariant* >& HookIO);
 
 	/**
-	 * Invoke an installed hook
+	 * Invoke an installed hook through a cached handle. Game thread only.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
-	virtual TArray< UBPVariant* > InvokeHook(FString HookName, const TArray< UBPVariant* >& HookIO);
+	virtual TArray< UBPVariant* > InvokeHookByHandle(const FModSkeletonHookHandle& Hook, const TArray< UBPVariant* >& HookIO);
+
+	/**
+	 * Invoke an installed hook with value type HookIO
+	 * Safe from any thread, off the game thread only native handlers are called
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual TArray< FBPVariant > InvokeHookValues(const FString& HookName, const TArray< FBPVariant >& HookIO);
+
+	/**
+	 * Invoke an installed hook through a cached handle with value type HookIO
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual TArray< FBPVariant > InvokeHookValuesByHandle(const FModSkeletonHookHandle& Hook, const TArray< FBPVariant >& HookIO);
+
+	/**
+	 * Invoke an installed hook through a cached handle, replacing HookIO with the result
+	 * The array is moved through the dispatch rather than copied, so callers can reuse its allocation. See TModSkeletonHook.
+	 */
+	void InvokeHookValuesInPlace(const FModSkeletonHookHandle& Hook, TArray< FBPVariant >& HookIO);
+
+	/**
+	 * Invoke an installed hook without chaining: each handler gets a copy of HookIO and its result is returned separately.
+	 * Native handlers only run concurrently if the hook was installed as ParallelBroadcast.
+	 * Plain InvokeHook calls on a ParallelBroadcast hook behave the same, and return HookIO unchanged.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ModSkeleton")
+	virtual TArray< FModSkeletonPluginResult > InvokeHookBroadcastByHandle(const FModSkeletonHookHandle& Hook, const TArray< FBPVariant >& HookIO);
+
+	/**
+	 * Hit / miss counters of the result cache of a Pure hook
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeleton")
+	virtual FModSkeletonPureCacheStats GetPureCacheStats(const FModSkeletonHookHandle& Hook);
+
+	/**
+	 * Hit / miss counters of the UBPVariant pool used during hook invocations
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "ModSkeleton")
+	virtual FBPVariantPoolStats GetVariantPoolStats() const;
+
+	/**
+	 * When set, UBPVariants created during an InvokeHook call are drawn from a pool, and any
+	 * that are not part of the call's input or result are recycled when the call completes.
+	 * Off by default: only set this when no mod keeps references to temporary variants beyond the hook that created them.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ModSkeleton")
+	bool bRecycleHookVariants;
 
 private:
 	/**
-	 * Keep track of loaded pak names so we don't re-load one we've loaded before
+	 * Loaded mod paks by ModName, so we don't re-load one we've loaded before and can unload it again
 	 */
 	UPROPERTY()
-	TMap<FString, bool> LoadedPaks;
+	TMap<FString, FModSkeletonLoadedMod> LoadedMods;
 
 	/**
 	 * Keep track of all initialized MOD_SKELETON init interfaces, so we don't re-init any
@@ -167,15 +697,261 @@ private:
 	TMap<FName, UObject *> LoadedPlugins;
 
 	/**
-	 * Keep track of all installed hook descriptions
+	 * LoadedPlugins in load order. AlwaysInvoke hooks walk this by index, so plugins loaded mid-dispatch are safe.
+	 */
+	UPROPERTY()
+	TArray<UObject *> LoadedPluginList;
+
+	/**
+	 * Every interned hook, indexed by FModSkeletonHookHandle::Index
+	 * Entries are never removed, so handles stay valid for the lifetime of the registry
+	 */
+	UPROPERTY()
+	TArray<FModSkeletonHookEntry> RegisteredHooks;
+
+	/**
+	 * Interned HookName to RegisteredHooks index
 	 */
 	UPROPERTY()
-	TMap<FString, FModSkeletonHookDescription> RegisteredHooks;
+	TMap<FName, int32> HookIndices;
+
+	/**
+	 * Connections requested while their hook is being dispatched
+	 * These are applied once the outermost dispatch of that hook returns, so dispatch lists are never modified mid-iteration
+	 */
+	UPROPERTY()
+	TArray<FModSkeletonConnectHook> PendingConnections;
+
+	/**
+	 * Move PendingConnections for a hook that is no longer being dispatched into its dispatch list
+	 */
+	void ApplyPendingConnections(int32 HookIndex);
+
+	/**
+	 * What invocations off the game thread dispatch from, republished whenever a hook's handlers change
+	 */
+	FModSkeletonDispatchSnapshotPublisher DispatchSnapshots;
+
+#if MODSKELETON_PROFILING
+	/**
+	 * Lets ModSkeleton.Benchmark.ConcurrentDispatch register a stand-in mod to unload
+	 */
+	friend struct FModSkeletonBenchmarkRegistryAccess;
+#endif
+
+	/**
+	 * Publish a snapshot with one hook, or every hook for INDEX_NONE, rebuilt from RegisteredHooks
+	 */
+	void PublishDispatchSnapshot(int32 HookIndex);
+
+	TSharedPtr<const FModSkeletonHookSnapshot, ESPMode::ThreadSafe> BuildHookSnapshot(int32 HookIndex) const;
+
+	/**
+	 * Invoke a hook from a thread other than the game thread, calling only the native handlers of the current snapshot.
+	 * OutBroadcastResults, if given, receives one result per handler as with InvokeHookBroadcastByHandle.
+	 */
+	void DispatchFromSnapshot(const FModSkeletonHookHandle& Hook, TArray< FBPVariant >& HookIO, TArray< FModSkeletonPluginResult >* OutBroadcastResults) const;
+
+	/**
+	 * Record plugins to be loaded on the first invocation of any of HookNames
+	 */
+	void DeferPlugins(const TArray<FName>& ObjectPaths, const TArray<FString>& HookNames);
+
+	/**
+	 * Load and ModSkeletonInit every plugin deferred on a hook
+	 */
+	void LoadDeferredPlugins(int32 HookIndex);
 
 	/**
-	 * USE AS A HEAP - always access with heap functions using FModSkeletonConnectHookPredicate
-	 * The priority heap of connected hooks
+	 * Recycles UBPVariants created while hooks are invoked
 	 */
 	UPROPERTY()
-	TArray<FModSkeletonConnectHook> ConnectedHooks;
+	UBPVariantPool* VariantPool;
+
+	/**
+	 * Set while ScanForModPluginsAsync is running
+	 */
+	bool bScanInProgress;
+
+	/**
+	 * Number of hook dispatches and plugin inits on the stack. Mods are only unloaded when it is zero,
+	 * since dispatch walks the connection and plugin lists by index.
+	 */
+	int32 DispatchDepth;
+
+	/**
+	 * Run UnloadMod or ReloadMod on the next tick, once the current dispatch has returned
+	 */
+	void DeferModChange(const FString& ModName, bool bReload);
+
+	/**
+	 * Disconnect and forget every plugin of a mod, loaded or deferred
+	 */
+	void ReleaseModPlugins(const FString& ModName, const FModSkeletonLoadedMod& Mod);
+
+	/**
+	 * Drop a mod's packages and AssetRegistry entries, unregister its mount point and unmount its pak
+	 */
+	void UnmountMod(const FString& ModName, const FModSkeletonLoadedMod& Mod);
+
+	TSet<FString> GetLoadedPakNames() const;
+
+	/**
+	 * Content/Paks, where mods are dropped
+	 */
+	static FString GetModPakDirectory();
+
+	/**
+	 * Set while StartWatchingModPaks is in effect
+	 */
+	TSharedPtr<FModSkeletonPakWatcher> PakWatcher;
+
+	/**
+	 * Load, reload or unload the mods of files the watcher reported. Returns false to be called again later,
+	 * if a scan or a hook dispatch is in progress.
+	 */
+	bool RescanModPaks(const TArray<FString>& ChangedFiles);
+
+	/**
+	 * Find every .bin / .pak pair in Content/Paks that is not already loaded. Thread safe.
+	 * Cache (if given) forgets every mod that is no longer in Content/Paks.
+	 */
+	static void FindModPaks(const TSet<FString>& LoadedPakNames, TArray<FModSkeletonPakScanEntry>& OutEntries, FModSkeletonScanCache* Cache);
+
+	/**
+	 * Run PrepareModPak for every entry in parallel, then mount them in order.
+	 * OnPrepared (if bound) is called from worker threads as each entry is prepared.
+	 */
+	static void PrepareAndMountModPaks(TArray<FModSkeletonPakScanEntry>& Entries, FModSkeletonPakLayer& PakLayer, FModSkeletonScanCache* Cache, const TFunction<void(int32, int32, const FString&)>& OnPrepared);
+
+	/**
+	 * Validate the pak and read its AssetRegistry file, unless Cache has it. Thread safe, does not log.
+	 */
+	static void PrepareModPak(FModSkeletonPakScanEntry& Entry, IPlatformFile* LowerPlatform, FModSkeletonScanCache* Cache);
+
+	/**
+	 * Mount a prepared pak into the mod pak layer. Thread safe.
+	 */
+	static void MountModPak(FModSkeletonPakScanEntry& Entry, FModSkeletonPakLayer& PakLayer);
+
+	/**
+	 * Register mount points, merge AssetRegistry data and init new plugins. Game thread only.
+	 * With bInitAsync it returns while plugin classes are still loading. OnInitialized (if bound) runs once the new plugins
+	 * have been initialized, just before OnScanComplete is broadcast.
+	 */
+	void FinishScan(TArray<FModSkeletonPakScanEntry>& Entries, bool bInitAsync = false, TFunction<void()> OnInitialized = TFunction<void()>());
+
+	/**
+	 * Set once the first scan has searched the content that does not come from mod paks
+	 */
+	bool bScannedBaseContent;
+
+	/**
+	 * Content paths of the game and enabled plugins, which may contain MOD_SKELETON assets without being mod paks
+	 */
+	static void GetBaseContentRoots(TArray<FName>& OutContentRoots);
+
+	/**
+	 * Find the object paths of all MOD_SKELETON assets under ContentRoots
+	 */
+	static void FindModPluginAssets(IAssetRegistry& AssetRegistry, const TArray<FName>& ContentRoots, TArray<FName>& OutObjectPaths);
+
+	/**
+	 * Create and ModSkeletonInit any of these MOD_SKELETON plugins not yet loaded, blocking the game thread until they are.
+	 * Returns the number of new plugins. Only for ScanForModPlugins and bBlockOnPluginLoads, otherwise use LoadModPlugins.
+	 */
+	int32 InitModPlugins(const TArray<FName>& ObjectPaths);
+
+	/**
+	 * Stream in the classes of any of these plugins not yet loaded and ModSkeletonInit them in order as they arrive.
+	 * OnComplete (if bound) receives the number of new plugins. Call WaitUntilComplete on the result to block.
+	 */
+	TSharedRef<FModSkeletonPluginLoader> LoadModPlugins(const TArray<FName>& ObjectPaths, TFunction<void(int32)> OnComplete);
+
+	/**
+	 * Create and ModSkeletonInit one plugin. False if the class is missing, already loaded, not a plugin, or belongs to a
+	 * mod that was unloaded while it was streaming in.
+	 */
+	bool InitModPlugin(const FName& ObjectPath, UClass* PluginClass);
+
+	/**
+	 * Lazily loaded scan cache, or nullptr if bUseScanCache is off
+	 */
+	TSharedPtr<FModSkeletonScanCache, ESPMode::ThreadSafe> GetScanCache();
+
+	TSharedPtr<FModSkeletonScanCache, ESPMode::ThreadSafe> ScanCache;
+
+	/**
+	 * AddConnection, or queue it in PendingConnections if its hook is being dispatched
+	 */
+	void AddOrDeferConnection(const FModSkeletonConnectHook& NewHook);
+
+	/**
+	 * Insert a connection into its hook's dispatch list, preserving priority order
+	 */
+	void AddConnection(const FModSkeletonConnectHook& NewHook);
+
+	/**
+	 * Find or create the RegisteredHooks entry for a HookName
+	 */
+	FModSkeletonHookHandle InternHook(const FName& HookName);
+
+	/**
+	 * Returns the entry for a handle, re-resolving by name if the handle came from another registry
+	 */
+	FModSkeletonHookEntry* FindHookEntry(const FModSkeletonHookHandle& Hook);
+
+	/**
+	 * RegisteredHooks index of an installed hook, or INDEX_NONE (with a warning) if it is not installed
+	 */
+	int32 FindInstalledHookIndex(const FModSkeletonHookHandle& Hook);
+
+	/**
+	 * Run every handler of an installed hook, chaining HookIO from one to the next
+	 * Broadcast and Pure hooks are routed to BroadcastHook / DispatchPureHook
+	 */
+	void DispatchHook(int32 HookIndex, FModSkeletonHookIOFrame& HookIO);
+
+	/**
+	 * False, loudly, if HookIO does not match the hook's HookIOTypes schema. Boundary names the check in the log.
+	 */
+	bool ValidateHookIO(int32 HookIndex, const FModSkeletonHookIOFrame& HookIO, const TCHAR* Boundary) const;
+	bool ValidateHookIO(int32 HookIndex, const TArray< FBPVariant >& HookIO, const TCHAR* Boundary) const;
+
+	/**
+	 * The chaining part of DispatchHook
+	 */
+	void InvokeHandlers(int32 HookIndex, FModSkeletonHookIOFrame& HookIO);
+
+	/**
+	 * Serve a Pure hook from its cache, or InvokeHandlers and remember the result
+	 */
+	void DispatchPureHook(int32 HookIndex, FModSkeletonHookIOFrame& HookIO);
+
+	/**
+	 * Drop the cached results of one hook, or of every hook
+	 */
+	void InvalidatePureCache(int32 HookIndex);
+	void InvalidatePureCaches();
+
+	/**
+	 * Run every handler of an installed hook on its own copy of HookIO, native handlers in parallel if the hook allows it
+	 */
+	void BroadcastHook(int32 HookIndex, const TArray< FBPVariant >& HookIO, TArray< FModSkeletonPluginResult >& OutResults);
+
+	/**
+	 * True if the object implements either plugin interface
+	 */
+	static bool IsModSkeletonPlugin(UObject* Plugin);
+
+	/**
+	 * Invoke a single plugin through whichever plugin interface it implements.
+	 * HookKey is the hook entry's Name, which keys the profiler; HookName is what the plugin is passed.
+	 */
+	void InvokePlugin(UObject* Plugin, const FName& HookKey, const FString& HookName, FModSkeletonHookIOFrame& HookIO);
+
+	/**
+	 * Call a native handler connection, if it is still bound
+	 */
+	void InvokeNativeHandler(const FModSkeletonNativeHookDelegate& Handler, const FName& HookKey, const FString& HookName, FModSkeletonHookIOFrame& HookIO);
 };
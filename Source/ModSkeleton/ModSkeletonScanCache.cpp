@@ -0,0 +1,220 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ModSkeleton.h"
+#include "ModSkeletonScanCache.h"
+
+namespace ModSkeletonScanCache
+{
+	const uint32 Magic = 0x4D534B43; // "MSKC"
+	const int32 Version = 2;
+}
+
+FArchive& operator<<(FArchive& Ar, FModSkeletonScanCacheFileKey& Key)
+{
+	Ar << Key.Size;
+	Ar << Key.Timestamp;
+	Ar << Key.Hash;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FModSkeletonScanCacheEntry& Entry)
+{
+	Ar << Entry.PakFilename;
+	Ar << Entry.PakKey;
+	Ar << Entry.BinKey;
+	Ar << Entry.PluginObjectPaths;
+	Ar << Entry.PakFiles;
+	return Ar;
+}
+
+FModSkeletonScanCache::FModSkeletonScanCache()
+	: CacheFilename(FPaths::GameSavedDir() / TEXT("ModSkeleton") / TEXT("ScanCache.bin"))
+	, bDirty(false)
+{
+}
+
+void FModSkeletonScanCache::Load()
+{
+	FScopeLock Lock(&CriticalSection);
+	Entries.Empty();
+	bDirty = false;
+
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *CacheFilename, FILEREAD_Silent))
+	{
+		return;
+	}
+
+	FMemoryReader Ar(Data);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Ar << Magic;
+	Ar << Version;
+	if (Magic != ModSkeletonScanCache::Magic || Version != ModSkeletonScanCache::Version)
+	{
+		UE_LOG(ModSkeletonLog, Log, TEXT("Discarding outdated scan cache: %s"), *CacheFilename);
+		return;
+	}
+
+	TArray<FModSkeletonScanCacheEntry> LoadedEntries;
+	Ar << LoadedEntries;
+	if (Ar.IsError())
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Discarding corrupt scan cache: %s"), *CacheFilename);
+		return;
+	}
+
+	for (FModSkeletonScanCacheEntry& Entry : LoadedEntries)
+	{
+		Entries.Add(Entry.PakFilename, MoveTemp(Entry));
+	}
+	UE_LOG(ModSkeletonLog, Log, TEXT("Loaded scan cache with %d mods: %s"), Entries.Num(), *CacheFilename);
+}
+
+void FModSkeletonScanCache::Save()
+{
+	FScopeLock Lock(&CriticalSection);
+	if (!bDirty)
+	{
+		return;
+	}
+
+	TArray<FModSkeletonScanCacheEntry> SavedEntries;
+	Entries.GenerateValueArray(SavedEntries);
+
+	TArray<uint8> Data;
+	FMemoryWriter Ar(Data);
+	uint32 Magic = ModSkeletonScanCache::Magic;
+	int32 Version = ModSkeletonScanCache::Version;
+	Ar << Magic;
+	Ar << Version;
+	Ar << SavedEntries;
+
+	if (FFileHelper::SaveArrayToFile(Data, *CacheFilename))
+	{
+		bDirty = false;
+	}
+	else
+	{
+		UE_LOG(ModSkeletonLog, Warning, TEXT("Failed to write scan cache: %s"), *CacheFilename);
+	}
+}
+
+bool FModSkeletonScanCache::FindValid(const FString& PakFilename, const FString& BinFilename, FModSkeletonScanCacheEntry& OutEntry)
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+		const FModSkeletonScanCacheEntry* Entry = Entries.Find(PakFilename);
+		if (Entry == nullptr)
+		{
+			return false;
+		}
+		OutEntry = *Entry;
+	}
+
+	// Hashing reads the whole file, do it on our copy of the keys
+	bool bKeyUpdated = false;
+	const bool bUnchanged = IsFileUnchanged(PakFilename, OutEntry.PakKey, bKeyUpdated) && IsFileUnchanged(BinFilename, OutEntry.BinKey, bKeyUpdated);
+
+	FScopeLock Lock(&CriticalSection);
+	if (!bUnchanged)
+	{
+		UE_LOG(ModSkeletonLog, Log, TEXT(" - Scan cache stale: %s"), *PakFilename);
+		Entries.Remove(PakFilename);
+		bDirty = true;
+		return false;
+	}
+
+	if (bKeyUpdated)
+	{
+		if (FModSkeletonScanCacheEntry* Entry = Entries.Find(PakFilename))
+		{
+			Entry->PakKey.Timestamp = OutEntry.PakKey.Timestamp;
+			Entry->BinKey.Timestamp = OutEntry.BinKey.Timestamp;
+			bDirty = true;
+		}
+	}
+	return true;
+}
+
+bool FModSkeletonScanCache::MakeFileKey(const FString& Filename, bool bHash, FModSkeletonScanCacheFileKey& OutKey)
+{
+	IFileManager& FileManager = IFileManager::Get();
+	OutKey.Size = FileManager.FileSize(*Filename);
+	if (OutKey.Size < 0)
+	{
+		return false;
+	}
+	OutKey.Timestamp = FileManager.GetTimeStamp(*Filename);
+	if (bHash)
+	{
+		OutKey.Hash = FMD5Hash::HashFile(*Filename);
+	}
+	return true;
+}
+
+bool FModSkeletonScanCache::IsFileUnchanged(const FString& Filename, FModSkeletonScanCacheFileKey& Key, bool& bOutKeyUpdated)
+{
+	FModSkeletonScanCacheFileKey Current;
+	if (!MakeFileKey(Filename, false, Current) || Current.Size != Key.Size)
+	{
+		return false;
+	}
+	if (Current.Timestamp == Key.Timestamp)
+	{
+		return true;
+	}
+
+	// Touched but possibly not modified - only pay for hashing the file in this case
+	Current.Hash = FMD5Hash::HashFile(*Filename);
+	if (!Current.Hash.IsValid() || Current.Hash != Key.Hash)
+	{
+		return false;
+	}
+	Key.Timestamp = Current.Timestamp;
+	bOutKeyUpdated = true;
+	return true;
+}
+
+void FModSkeletonScanCache::Update(const FModSkeletonScanCacheEntry& Entry)
+{
+	FScopeLock Lock(&CriticalSection);
+	Entries.Add(Entry.PakFilename, Entry);
+	bDirty = true;
+}
+
+void FModSkeletonScanCache::RemoveUnseen(const TSet<FString>& PakFilenames)
+{
+	FScopeLock Lock(&CriticalSection);
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (!PakFilenames.Contains(It.Key()))
+		{
+			UE_LOG(ModSkeletonLog, Log, TEXT(" - Scan cache dropping missing mod: %s"), *It.Key());
+			It.RemoveCurrent();
+			bDirty = true;
+		}
+	}
+}
+
+void FModSkeletonScanCache::Remove(const FString& PakFilename)
+{
+	FScopeLock Lock(&CriticalSection);
+	if (Entries.Remove(PakFilename) > 0)
+	{
+		bDirty = true;
+	}
+}
@@ -0,0 +1,101 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "Misc/SecureHash.h"
+
+/**
+ * Identifies one version of a file on disk
+ */
+struct FModSkeletonScanCacheFileKey
+{
+	FModSkeletonScanCacheFileKey()
+		: Size(-1)
+	{
+	}
+
+	int64 Size;
+	FDateTime Timestamp;
+	FMD5Hash Hash;
+
+	friend FArchive& operator<<(FArchive& Ar, FModSkeletonScanCacheFileKey& Key);
+};
+
+/**
+ * Everything a scan needs to know about an unchanged mod pak
+ */
+struct FModSkeletonScanCacheEntry
+{
+	FString PakFilename;
+	FModSkeletonScanCacheFileKey PakKey;
+	FModSkeletonScanCacheFileKey BinKey;
+	TArray<FString> PluginObjectPaths;
+
+	/**
+	 * Files in the pak relative to its mount point, so an unchanged pak mounts without reading its directory again
+	 */
+	TArray<FString> PakFiles;
+
+	friend FArchive& operator<<(FArchive& Ar, FModSkeletonScanCacheEntry& Entry);
+};
+
+/**
+ * On-disk cache of ScanForModPlugins results, stored in Saved/ModSkeleton.
+ * Entries are keyed by the size, timestamp and MD5 of each mod's .pak and .bin, so a changed mod only invalidates its own entry.
+ * All functions are thread safe.
+ */
+class MODSKELETON_API FModSkeletonScanCache
+{
+public:
+	FModSkeletonScanCache();
+
+	/**
+	 * Read the cache file, discarding it if it was written by a different version
+	 */
+	void Load();
+
+	/**
+	 * Write the cache file if any entry changed since Load
+	 */
+	void Save();
+
+	/**
+	 * Look up a mod and check its files are unchanged. Stale entries are removed.
+	 * Files are hashed outside the lock, so mods prepared in parallel do not wait on each other.
+	 */
+	bool FindValid(const FString& PakFilename, const FString& BinFilename, FModSkeletonScanCacheEntry& OutEntry);
+
+	/**
+	 * Compute the key for a file on disk, returns false if the file does not exist
+	 */
+	static bool MakeFileKey(const FString& Filename, bool bHash, FModSkeletonScanCacheFileKey& OutKey);
+
+	void Update(const FModSkeletonScanCacheEntry& Entry);
+	void Remove(const FString& PakFilename);
+
+	/**
+	 * Drop the entries of every pak not in PakFilenames, such as mods deleted since the cache was written
+	 */
+	void RemoveUnseen(const TSet<FString>& PakFilenames);
+
+private:
+	static bool IsFileUnchanged(const FString& Filename, FModSkeletonScanCacheFileKey& Key, bool& bOutKeyUpdated);
+
+	FString CacheFilename;
+	TMap<FString, FModSkeletonScanCacheEntry> Entries;
+	bool bDirty;
+	FCriticalSection CriticalSection;
+};
@@ -0,0 +1,393 @@
+// Copyright 2017 Smogworks
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "ModSkeleton.h"
+#include "Templates/IntegerSequence.h"
+#include "Templates/Tuple.h"
+#include "ModSkeletonRegistry.h"
+
+/**
+ * Marshals one C++ type to and from an FBPVariant.
+ * Only the specializations below exist, so an unsupported hook argument type fails to compile.
+ */
+template <typename T>
+struct TModSkeletonHookArg
+{
+	static_assert(sizeof(T) == 0, "Type cannot be carried in ModSkeleton HookIO. Use bool, int32, float, FString, UClass*, a UObject pointer, TArray<FBPVariant> or a TArray of int32, float or FVector.");
+};
+
+template <>
+struct TModSkeletonHookArg<bool>
+{
+	static const EBPVariantType Type = EBPVariantType::VT_Boolean;
+
+	static void Store(FBPVariant& Out, bool Value) { Out.SetAsBoolean(Value); }
+	static bool Load(const FBPVariant& In, bool& OutValue)
+	{
+		if (In.GetType() != EBPVariantType::VT_Boolean) return false;
+		OutValue = In.GetAsBoolean();
+		return true;
+	}
+	static bool LoadUnchecked(const FBPVariant& In) { return In.GetAsBooleanUnchecked(); }
+};
+
+template <>
+struct TModSkeletonHookArg<int32>
+{
+	static const EBPVariantType Type = EBPVariantType::VT_Integer;
+
+	static void Store(FBPVariant& Out, int32 Value) { Out.SetAsInteger(Value); }
+	static bool Load(const FBPVariant& In, int32& OutValue)
+	{
+		if (In.GetType() != EBPVariantType::VT_Integer) return false;
+		OutValue = In.GetAsInteger();
+		return true;
+	}
+	static int32 LoadUnchecked(const FBPVariant& In) { return In.GetAsIntegerUnchecked(); }
+};
+
+template <>
+struct TModSkeletonHookArg<float>
+{
+	static const EBPVariantType Type = EBPVariantType::VT_Float;
+
+	static void Store(FBPVariant& Out, float Value) { Out.SetAsFloat(Value); }
+	static bool Load(const FBPVariant& In, float& OutValue)
+	{
+		if (In.GetType() != EBPVariantType::VT_Float) return false;
+		OutValue = In.GetAsFloat();
+		return true;
+	}
+	static float LoadUnchecked(const FBPVariant& In) { return In.GetAsFloatUnchecked(); }
+};
+
+template <>
+struct TModSkeletonHookArg<FString>
+{
+	static const EBPVariantType Type = EBPVariantType::VT_String;
+
+	static void Store(FBPVariant& Out, const FString& Value) { Out.SetAsString(Value); }
+	static bool Load(const FBPVariant& In, FString& OutValue)
+	{
+		if (In.GetType() != EBPVariantType::VT_String) return false;
+		OutValue = In.GetAsString();
+		return true;
+	}
+	static const FString& LoadUnchecked(const FBPVariant& In) { return In.GetAsStringUnchecked(); }
+};
+
+template <>
+struct TModSkeletonHookArg<UClass*>
+{
+	static const EBPVariantType Type = EBPVariantType::VT_Class;
+
+	static void Store(FBPVariant& Out, UClass* Value) { Out.SetAsClass(Value); }
+	static bool Load(const FBPVariant& In, UClass*& OutValue)
+	{
+		if (In.GetType() != EBPVariantType::VT_Class) return false;
+		OutValue = In.GetAsClass();
+		return true;
+	}
+	static UClass* LoadUnchecked(const FBPVariant& In) { return In.GetAsClassUnchecked(); }
+};
+
+template <typename T>
+struct TModSkeletonHookArg<T*>
+{
+	static_assert(TPointerIsConvertibleFromTo<T, UObject>::Value, "Only UObject pointers can be carried in ModSkeleton HookIO.");
+
+	static const EBPVariantType Type = EBPVariantType::VT_Object;
+
+	static void Store(FBPVariant& Out, T* Value) { Out.SetAsObject(Value); }
+	static bool Load(const FBPVariant& In, T*& OutValue)
+	{
+		if (In.GetType() != EBPVariantType::VT_Object) return false;
+		UObject* Object = In.GetAsObject();
+		T* Typed = Cast<T>(Object);
+		if (Object != nullptr && Typed == nullptr) return false;
+		OutValue = Typed;
+		return true;
+	}
+
+	/**
+	 * The schema only says VT_Object, so the class is still checked. Returns nullptr for an object of another class.
+	 */
+	static T* LoadUnchecked(const FBPVariant& In) { return Cast<T>(In.GetAsObjectUnchecked()); }
+};
+
+template <>
+struct TModSkeletonHookArg< TArray< FBPVariant > >
+{
+	static const EBPVariantType Type = EBPVariantType::VT_Array;
+
+	static void Store(FBPVariant& Out, const TArray< FBPVariant >& Value) { Out.SetAsArray() = Value; }
+	static bool Load(const FBPVariant& In, TArray< FBPVariant >& OutValue)
+	{
+		if (In.GetType() != EBPVariantType::VT_Array) return false;
+		OutValue = In.GetAsArray();
+		return true;
+	}
+	static const TArray< FBPVariant >& LoadUnchecked(const FBPVariant& In) { return In.GetAsArrayUnchecked(); }
+};
+
+template <>
+struct TModSkeletonHookArg< TArray<int32> >
+{
+	static const EBPVariantType Type = EBPVariantType::VT_IntArray;
+
+	static void Store(FBPVariant& Out, const TArray<int32>& Value) { Out.SetAsIntArray() = Value; }
+	static bool Load(const FBPVariant& In, TArray<int32>& OutValue)
+	{
+		if (In.GetType() != EBPVariantType::VT_IntArray) return false;
+		OutValue = In.GetAsIntArray();
+		return true;
+	}
+	static const TArray<int32>& LoadUnchecked(const FBPVariant& In) { return In.GetAsIntArray(); }
+};
+
+template <>
+struct TModSkeletonHookArg< TArray<float> >
+{
+	static const EBPVariantType Type = EBPVariantType::VT_FloatArray;
+
+	static void Store(FBPVariant& Out, const TArray<float>& Value) { Out.SetAsFloatArray() = Value; }
+	static bool Load(const FBPVariant& In, TArray<float>& OutValue)
+	{
+		if (In.GetType() != EBPVariantType::VT_FloatArray) return false;
+		OutValue = In.GetAsFloatArray();
+		return true;
+	}
+	static const TArray<float>& LoadUnchecked(const FBPVariant& In) { return In.GetAsFloatArray(); }
+};
+
+template <>
+struct TModSkeletonHookArg< TArray<FVector> >
+{
+	static const EBPVariantType Type = EBPVariantType::VT_VectorArray;
+
+	static void Store(FBPVariant& Out, const TArray<FVector>& Value) { Out.SetAsVectorArray() = Value; }
+	static bool Load(const FBPVariant& In, TArray<FVector>& OutValue)
+	{
+		if (In.GetType() != EBPVariantType::VT_VectorArray) return false;
+		OutValue = In.GetAsVectorArray();
+		return true;
+	}
+	static const TArray<FVector>& LoadUnchecked(const FBPVariant& In) { return In.GetAsVectorArray(); }
+};
+
+/**
+ * Compares a C++ argument list with hook schemas and HookIO, and calls typed handlers
+ */
+template <typename... ArgTypes>
+struct TModSkeletonHookSignature
+{
+	/**
+	 * True if a hook declared with HookIOTypes carries exactly ArgTypes
+	 */
+	static bool Matches(const TArray< EBPVariantType >& HookIOTypes)
+	{
+		// leading VT_None keeps the array non-empty for an empty argument list
+		const EBPVariantType Types[] = { EBPVariantType::VT_None, TModSkeletonHookArg<ArgTypes>::Type... };
+		if (HookIOTypes.Num() != sizeof...(ArgTypes))
+		{
+			return false;
+		}
+		for (int32 i = 0; i < HookIOTypes.Num(); ++i)
+		{
+			if (HookIOTypes[i] != Types[i + 1])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * True if HookIO holds exactly ArgTypes
+	 */
+	static bool Matches(const TArray< FBPVariant >& HookIO)
+	{
+		const EBPVariantType Types[] = { EBPVariantType::VT_None, TModSkeletonHookArg<ArgTypes>::Type... };
+		if (HookIO.Num() != sizeof...(ArgTypes))
+		{
+			return false;
+		}
+		for (int32 i = 0; i < HookIO.Num(); ++i)
+		{
+			if (HookIO[i].GetType() != Types[i + 1])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Read HookIO, already known to match, into arguments for Handler and write them back afterwards
+	 */
+	template <uint32... Indices>
+	static void Call(const TFunction<void(ArgTypes&...)>& Handler, TArray< FBPVariant >& HookIO, TIntegerSequence<uint32, Indices...>)
+	{
+		TTuple<ArgTypes...> Args(TModSkeletonHookArg<ArgTypes>::LoadUnchecked(HookIO[Indices])...);
+		Handler(Args.template Get<Indices>()...);
+		int32 StoreArgs[] = { 0, (TModSkeletonHookArg<ArgTypes>::Store(HookIO[Indices], Args.template Get<Indices>()), 0)... };
+		(void)StoreArgs;
+	}
+};
+
+/**
+ * Connect a native handler with typed arguments, e.g.
+ *
+ *   ModSkeletonConnectTypedHook<int32, FString>(Registry, Handle, 10, [](int32& Damage, FString& Name) { Damage *= 2; });
+ *
+ * If the hook is installed with HookIOTypes, the signature is checked against them once, here, and HookIO is then
+ * read with the unchecked accessors on every call - the registry validates HookIO at the invocation boundary in
+ * non-Shipping builds. Otherwise the types are checked on every call and a mismatched call is skipped.
+ * Returns false, without connecting, if the signature does not match the hook's HookIOTypes.
+ */
+template <typename... ArgTypes>
+bool ModSkeletonConnectTypedHook(UModSkeletonRegistry* Registry, const FModSkeletonHookHandle& Hook, int32 Priority, TFunction<void(ArgTypes&...)> Handler)
+{
+	const FModSkeletonHookDescription Description = Registry->GetHookDescription(Hook.HookName.ToString());
+	const bool bHasSchema = Description.HookIOTypes.Num() > 0;
+	if (bHasSchema && !TModSkeletonHookSignature<ArgTypes...>::Matches(Description.HookIOTypes))
+	{
+		UE_LOG(ModSkeletonLog, Error, TEXT("Typed handler does not match the HookIOTypes of hook %s, not connecting"), *Description.HookName);
+		ensureMsgf(false, TEXT("Typed handler does not match the HookIOTypes of hook %s"), *Description.HookName);
+		return false;
+	}
+
+	Registry->ConnectNativeHook(Hook, Priority, [Handler, bHasSchema](const FString& HookName, TArray< FBPVariant >& HookIO)
+	{
+		if (!bHasSchema && !TModSkeletonHookSignature<ArgTypes...>::Matches(HookIO))
+		{
+			UE_LOG(ModSkeletonLog, Warning, TEXT("Skipping typed handler of hook %s, HookIO does not match its arguments"), *HookName);
+			return;
+		}
+		TModSkeletonHookSignature<ArgTypes...>::Call(Handler, HookIO, TMakeIntegerSequence<uint32, sizeof...(ArgTypes)>());
+	});
+	return true;
+}
+
+/**
+ * Typed C++ front end to a hook, e.g.
+ *
+ *   TModSkeletonHook<int32, FString, UObject*> ItemStats(Registry, TEXT("ItemStats"));
+ *   ItemStats.Invoke(Damage, Name, Owner);
+ *
+ * The hook name is resolved to a handle once. Arguments are written into a HookIO array owned by this object,
+ * which keeps its allocation between calls, and is dispatched in place with InvokeHookValuesInPlace.
+ * Once warm, a call with scalar arguments does not touch the heap when every handler is native.
+ * Bind (and the constructor taking a name) must run on the game thread. A bound hook may then be invoked from
+ * any thread like InvokeHookValuesInPlace, but one instance must not be invoked from two threads at once.
+ */
+template <typename... ArgTypes>
+class TModSkeletonHook
+{
+public:
+	TModSkeletonHook()
+		: bInvoking(false)
+	{
+	}
+
+	TModSkeletonHook(UModSkeletonRegistry* InRegistry, const FString& HookName)
+		: bInvoking(false)
+	{
+		Bind(InRegistry, HookName);
+	}
+
+	/**
+	 * Resolve HookName. If the hook is installed with HookIOTypes that don't match ArgTypes, this logs an error
+	 * and leaves the hook unbound, so a wrong signature is caught here rather than by every handler.
+	 */
+	void Bind(UModSkeletonRegistry* InRegistry, const FString& HookName)
+	{
+		Registry = InRegistry;
+		Hook = InRegistry != nullptr ? InRegistry->GetHookHandle(HookName) : FModSkeletonHookHandle();
+		if (InRegistry == nullptr)
+		{
+			return;
+		}
+
+		const FModSkeletonHookDescription Description = InRegistry->GetHookDescription(HookName);
+		if (Description.HookIOTypes.Num() > 0 && !TModSkeletonHookSignature<ArgTypes...>::Matches(Description.HookIOTypes))
+		{
+			UE_LOG(ModSkeletonLog, Error, TEXT("TModSkeletonHook arguments do not match the HookIOTypes of hook %s"), *HookName);
+			ensureMsgf(false, TEXT("TModSkeletonHook arguments do not match the HookIOTypes of hook %s"), *HookName);
+			Hook = FModSkeletonHookHandle();
+		}
+	}
+
+	bool IsBound() const
+	{
+		return Hook.IsValid() && Registry.IsValid();
+	}
+
+	const FModSkeletonHookHandle& GetHandle() const
+	{
+		return Hook;
+	}
+
+	/**
+	 * Invoke the hook with Args as HookIO, then read the resulting HookIO back into Args.
+	 * Returns false, leaving any mismatched Args untouched, if the handlers left HookIO with a different shape.
+	 */
+	bool Invoke(ArgTypes&... Args)
+	{
+		UModSkeletonRegistry* BoundRegistry = Registry.Get();
+		if (BoundRegistry == nullptr || !Hook.IsValid())
+		{
+			return false;
+		}
+
+		// A handler invoking this same hook again gets its own HookIO
+		TArray< FBPVariant > NestedHookIO;
+		TArray< FBPVariant >& HookIO = bInvoking ? NestedHookIO : ScratchHookIO;
+		const bool bWasInvoking = bInvoking;
+		bInvoking = true;
+
+		HookIO.SetNum(sizeof...(ArgTypes), false);
+		int32 StoreIndex = 0;
+		int32 StoreArgs[] = { 0, (TModSkeletonHookArg<ArgTypes>::Store(HookIO[StoreIndex++], Args), 0)... };
+		(void)StoreArgs;
+		(void)StoreIndex;
+
+		BoundRegistry->InvokeHookValuesInPlace(Hook, HookIO);
+
+		bool bMatched = HookIO.Num() == sizeof...(ArgTypes);
+		if (bMatched)
+		{
+			int32 LoadIndex = 0;
+			int32 LoadArgs[] = { 0, (bMatched = TModSkeletonHookArg<ArgTypes>::Load(HookIO[LoadIndex++], Args) && bMatched, 0)... };
+			(void)LoadArgs;
+			(void)LoadIndex;
+		}
+
+		bInvoking = bWasInvoking;
+		return bMatched;
+	}
+
+private:
+	TWeakObjectPtr<UModSkeletonRegistry> Registry;
+	FModSkeletonHookHandle Hook;
+
+	/**
+	 * Reused across calls so its element storage, and string buffers inside it, stay allocated
+	 */
+	TArray< FBPVariant > ScratchHookIO;
+	bool bInvoking;
+};